@@ -8,4 +8,5 @@ const QColor BACKGROUND_COLOR(0, 0, 0);
 const QColor OUTLINE_COLOR(0, 0, 255);
 const QColor POLYGON_COLOR(0, 255, 0);
 const QColor COMPLEX_OUTLINE(255, 0, 0);
+const QColor MARKER_COLOR(255, 255, 255);
 }
@@ -17,5 +17,6 @@ extern const QColor BACKGROUND_COLOR;
 extern const QColor OUTLINE_COLOR;
 extern const QColor POLYGON_COLOR;
 extern const QColor COMPLEX_OUTLINE;
+extern const QColor MARKER_COLOR;
 }
 #endif // CONSTANTS_HPP
@@ -0,0 +1,38 @@
+#include "DragCoalescer.hpp"
+
+DragCoalescer::DragCoalescer() noexcept
+    : _vertex(0), _pending(false), _waiting(false), _received(0), _applied(0),
+      _coalesced(0) {}
+
+void DragCoalescer::post(const int vertex, const QPointF &pointer) noexcept {
+  if (this->_pending && vertex == this->_vertex) {
+    ++this->_coalesced;
+  }
+  // ^ A move for some other vertex would be a new drag, which the caller
+  // should have flushed the old one for; either way, nothing's merged
+
+  this->_vertex = vertex;
+  this->_pointer = pointer;
+  this->_pending = true;
+  ++this->_received;
+}
+
+bool DragCoalescer::isReady() const noexcept {
+  return this->_pending && !this->_waiting;
+}
+
+bool DragCoalescer::take(int &vertex, QPointF &pointer) noexcept {
+  if (!this->_pending)
+    return false;
+
+  vertex = this->_vertex;
+  pointer = this->_pointer;
+  this->_pending = false;
+  this->_waiting = true;
+  ++this->_applied;
+  return true;
+}
+
+void DragCoalescer::discard() noexcept { this->_pending = false; }
+
+void DragCoalescer::frameShown() noexcept { this->_waiting = false; }
@@ -0,0 +1,46 @@
+#ifndef DRAGCOALESCER_HPP
+#define DRAGCOALESCER_HPP
+
+#include <QPointF>
+#include <QtGlobal>
+
+/**
+ * Paces vertex drags to the display.  A fast mouse sends far more moves than
+ * there are frames to show them in, and each applied move costs a simplicity
+ * update and another trip through the renderer's pipeline.  So once a move is
+ * applied, the ones after it are held back until that frame has been shown;
+ * while they wait, each one just replaces the last, and only the newest
+ * pointer position is ever applied.
+ */
+class DragCoalescer {
+public:
+  DragCoalescer() noexcept;
+
+  void post(const int vertex, const QPointF &pointer) noexcept;
+  // ^ The pointer (in widget pixels) moved while dragging vertex
+  bool isReady() const noexcept;
+  // ^ Whether there's a move waiting, and no frame we're waiting on
+  bool take(int &vertex, QPointF &pointer) noexcept;
+  // ^ The move to apply, if any; then waits for frameShown() again
+  void discard() noexcept;
+  // ^ Forgets the move waiting, if any, e.g. because the model changed
+  void frameShown() noexcept;
+  // ^ The last move we took is on screen
+
+  quint64 received() const noexcept { return this->_received; }
+  quint64 applied() const noexcept { return this->_applied; }
+  quint64 coalesced() const noexcept { return this->_coalesced; }
+  // ^ Moves that were replaced by a newer one before they were applied
+
+private:
+  int _vertex;
+  QPointF _pointer;
+  bool _pending;
+  bool _waiting;
+
+  quint64 _received;
+  quint64 _applied;
+  quint64 _coalesced;
+};
+
+#endif // DRAGCOALESCER_HPP
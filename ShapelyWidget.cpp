@@ -8,6 +8,7 @@
 #include <QDebug>
 #include <QElapsedTimer>
 #include <QListWidgetItem>
+#include <QMetaObject>
 #include <QMouseEvent>
 #include <QPoint>
 #include <QPolygonF>
@@ -15,6 +16,7 @@
 #include <QOpenGLVertexArrayObject>
 #include <QSharedPointer>
 #include <QSurfaceFormat>
+#include <QTransform>
 #include <QtMath>
 
 #include "Constants.hpp"
@@ -24,6 +26,7 @@
 #include "renderer/ShaderRenderer.hpp"
 #include "renderer/MidpointRenderer.hpp"
 #include "model/ShapelyModel.hpp"
+#include "profiling/Profiler.hpp"
 
 constexpr QSurfaceFormat::FormatOption FORMAT_OPTION =
 #ifdef DEBUG
@@ -36,7 +39,12 @@ constexpr QSurfaceFormat::OpenGLContextProfile PROFILE =
 constexpr QSurfaceFormat::RenderableType RENDER_TYPE = QSurfaceFormat::OpenGL;
 constexpr QSurfaceFormat::SwapBehavior SWAP_TYPE =
     QSurfaceFormat::DefaultSwapBehavior;
+constexpr int MAJOR_VERSION = 3;
+constexpr int MINOR_VERSION = 2;
+// ^ For fence sync objects, which the renderers' stream buffers rely on
 constexpr int SAMPLES = 0;
+constexpr int STENCIL_BITS = 8;
+// ^ For the stencil-then-cover fill modes
 
 constexpr QSurfaceFormat::FormatOptions FLAGS(FORMAT_OPTION | PROFILE |
                                               RENDER_TYPE | SWAP_TYPE);
@@ -44,23 +52,33 @@ constexpr QSurfaceFormat::FormatOptions FLAGS(FORMAT_OPTION | PROFILE |
 constexpr int NO_POINT_SELECTED = -1;
 const QTransform REFLECT(0, -1, -1, 0, 0, 0);
 
-constexpr QOpenGLBuffer::UsagePattern USAGE_PATTERN = QOpenGLBuffer::StaticDraw;
+constexpr QOpenGLBuffer::UsagePattern USAGE_PATTERN = QOpenGLBuffer::StreamDraw;
+// ^ The polygon is rewritten every time a vertex is dragged
 
 ShapelyWidget::ShapelyWidget(QWidget *parent)
-    : QOpenGLWidget(parent), _selected(NO_POINT_SELECTED), _log(parent),
+    : QOpenGLWidget(parent), _selected(NO_POINT_SELECTED),
+      _fillMode(AbstractRenderer::Triangulate), _log(parent),
       _vbo(QOpenGLBuffer::VertexBuffer), _vao(),
       _default(Qt::CursorShape::ArrowCursor),
       _gripping(Qt::CursorShape::ClosedHandCursor) {
   QSurfaceFormat format(FLAGS);
+  format.setVersion(MAJOR_VERSION, MINOR_VERSION);
   format.setSamples(SAMPLES);
+  format.setStencilBufferSize(STENCIL_BITS);
   this->setFormat(format);
+
+  connect(this, &QOpenGLWidget::frameSwapped, this,
+          &ShapelyWidget::frameShown);
 }
 
 ShapelyWidget::~ShapelyWidget() {
   Q_ASSERT(this->_renderer);
   Q_ASSERT(this->_vbo.isCreated());
   Q_ASSERT(this->_vao.isCreated());
+  this->makeCurrent();
+  this->_profiler.releaseGpu();
   this->_renderer.reset();
+  this->_scene.reset();
   _vbo.release();
   _vao.release();
   _vbo.destroy();
@@ -96,6 +114,12 @@ void ShapelyWidget::initializeGL() {
   this->_renderer.reset(new ShaderRenderer(":/shader/shader.vert",
                                            ":/shader/shader.frag",
                                            this->context(), this, &this->_vbo));
+  this->_renderer->setLogger(&this->_log);
+  this->_renderer->setProfiler(&this->_profiler);
+  this->_renderer->setResultListener(this->_repaintLater());
+  this->_scene.reset(new SceneRenderer(":/shader/scene.vert",
+                                       ":/shader/scene.frag", this->context()));
+  this->_scene->setResultListener(this->_repaintLater());
 
   if (!_log.initialize()) {
     qWarning() << "GL_KHR_debug extension not supported, debug logging will "
@@ -105,24 +129,50 @@ void ShapelyWidget::initializeGL() {
     _log.startLogging();
   }
 
+  if (!this->_profiler.initializeGpu()) {
+    qWarning() << "Timer queries not supported, GPU time will not be measured";
+  }
+
   QSharedPointer<ShapelyModel> model = this->_currentModel();
   if (model) {
 
-    this->_renderer->updateData(*model);
-    this->_renderer->updateView(*model);
+    this->_updateData(*model);
+    this->_updateView(*model);
   }
 }
 
 void ShapelyWidget::paintGL() {
-  glClear(GL_COLOR_BUFFER_BIT);
+  QElapsedTimer frame;
+  frame.start();
+  this->_profiler.beginGpu();
+
+  glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
   QSharedPointer<ShapelyModel> model = this->_currentModel();
-  if (model && model->polygon.size()) {
-    Q_ASSERT(this->_renderer);
-    Q_ASSERT(this->_vao.isCreated());
-    Q_ASSERT(this->_vbo.isCreated());
+  ShapelyWindow *w = static_cast<ShapelyWindow *>(this->window());
+  Q_ASSERT(this->_scene);
+
+  {
+    Profiler::Scope scope(&this->_profiler, Profiler::Draw);
+    // ^ Including any uploads, which are also timed on their own
 
-    this->_renderer->drawPolygon();
+    bool opaque = this->_renderer->isOpaque();
+    if (!opaque) {
+      this->_scene->draw(w->models(), model.data());
+    }
+    // ^ Under the current model, unless the renderer would paint over it
+
+    if (model && model->polygon.size()) {
+      Q_ASSERT(this->_renderer);
+      Q_ASSERT(this->_vao.isCreated());
+      Q_ASSERT(this->_vbo.isCreated());
+
+      this->_renderer->drawPolygon();
+    }
+
+    if (opaque) {
+      this->_scene->draw(w->models(), model.data());
+    }
   }
 
   if (this->_log.isLogging()) {
@@ -130,46 +180,88 @@ void ShapelyWidget::paintGL() {
       qDebug() << message;
     }
   }
+
+  this->_profiler.endGpu();
+  qint64 elapsed = frame.nsecsElapsed();
+  this->_profiler.record(Profiler::Frame, elapsed);
+  emit finishedRendering(elapsed / 1000000);
+  // ^ CPU time only; the GPU's is in the profiler once it's known
 }
 
 void ShapelyWidget::resizeGL(const int w, const int h) {
   QSharedPointer<ShapelyModel> model = this->_currentModel();
   this->_renderer->updateSize(w, h);
+  this->_scene->updateSize(w, h);
   this->update();
   if (model) {
     Q_ASSERT(this->_renderer);
 
-    this->_renderer->updateView(*model);
+    this->_updateView(*model);
   }
 }
 
 void ShapelyWidget::mouseMoveEvent(QMouseEvent *e) {
   if (this->_selected >= 0) {
     // If the use is dragging a vertex...
-    QSharedPointer<ShapelyModel> model = this->_currentModel();
+    this->_drag.post(this->_selected, e->localPos());
 
-    if (model) {
-      Q_ASSERT(this->_renderer);
+    if (this->_drag.isReady()) {
+      this->_applyDrag();
+    }
+    // ^ Otherwise it waits for the frame we're showing the last move in
+  }
+}
 
-      QPointF c(e->x(), e->y());
-      c.setY(this->height() - c.y());
-      c.setX(jtg::map<float>(c.x(), 0, this->width(), -1.0f, 1.0f));
-      c.setY(jtg::map<float>(c.y(), 0, this->height(), -1.0f, 1.0f));
-      QPointF coords = this->_renderer->unproject(c.x(), c.y());
+/**
+ * Moves the dragged vertex to wherever the pointer was last seen, if it's moved
+ * since we last did.
+ */
+void ShapelyWidget::_applyDrag() {
+  int vertex;
+  QPointF pointer;
+  if (!this->_drag.take(vertex, pointer))
+    return;
 
-      Q_ASSERT(0 <= this->_selected && this->_selected < model->polygon.size());
-      model->polygon[this->_selected].setX(coords.x());
-      model->polygon[this->_selected].setY(coords.y());
+  QSharedPointer<ShapelyModel> model = this->_currentModel();
+  if (!model)
+    return;
 
-      this->_renderer->updateData(*model);
-      this->update();
-    }
+  Q_ASSERT(this->_renderer);
+
+  QPointF c(pointer.x(), this->height() - pointer.y());
+  c.setX(jtg::map<float>(c.x(), 0, this->width(), -1.0f, 1.0f));
+  c.setY(jtg::map<float>(c.y(), 0, this->height(), -1.0f, 1.0f));
+  QPointF coords = this->_renderer->unproject(c.x(), c.y());
+
+  Q_ASSERT(0 <= vertex && vertex < model->polygon.size());
+  QPointF from = model->polygon[vertex];
+  {
+    Profiler::Scope scope(&this->_profiler, Profiler::Simplicity);
+    model->moveVertex(vertex, coords);
+  }
+  // Only the two edges touching this vertex get re-tested for
+  // self-intersection
+  this->_history().moveVertex(model, vertex, from);
+  // ^ Merged with the rest of the drag, so the whole drag is one undo
+
+  this->_updateVertex(*model, vertex);
+  this->update();
+}
+
+void ShapelyWidget::frameShown() {
+  this->_drag.frameShown();
+
+  if (this->_drag.isReady()) {
+    this->_applyDrag();
   }
 }
 
 void ShapelyWidget::mouseDoubleClickEvent(QMouseEvent *) {}
 
 void ShapelyWidget::mousePressEvent(QMouseEvent *e) {
+  this->_applyDrag();
+  // ^ Whatever's left of the last drag goes first
+
   QSharedPointer<ShapelyModel> model = this->_currentModel();
 
   if (model) {
@@ -180,7 +272,7 @@ void ShapelyWidget::mousePressEvent(QMouseEvent *e) {
     c.setX(jtg::map<float>(c.x(), 0, this->width(), -1.0f, 1.0f));
     c.setY(jtg::map<float>(c.y(), 0, this->height(), -1.0f, 1.0f));
     QPointF coords = this->_renderer->unproject(c.x(), c.y());
-    int clicked = this->_clickedPoint(coords);
+    int clicked = this->_clickedPoint(e->localPos());
 
     if (e->button() == Qt::MouseButton::LeftButton) {
       // ^ this will be the last index when we add the next point
@@ -195,31 +287,41 @@ void ShapelyWidget::mousePressEvent(QMouseEvent *e) {
 #endif
       } else {
         this->_selected = model->polygon.size();
-        model->polygon.append(coords);
+        {
+          Profiler::Scope scope(&this->_profiler, Profiler::Simplicity);
+          model->appendVertex(coords);
+        }
+        this->_history().insertVertex(model, this->_selected);
 #ifdef DEBUG
         qDebug() << "Adding a vertex to" << model->name;
 #endif
+        this->_updateVertex(*model, this->_selected);
       }
-
-      this->_renderer->updateData(*model);
     } else if (e->button() == Qt::MouseButton::RightButton) {
       if (clicked >= 0) {
         Q_ASSERT(0 <= clicked && clicked < model->polygon.size());
-        model->polygon.remove(clicked);
+        QPointF removed = model->polygon[clicked];
+        {
+          Profiler::Scope scope(&this->_profiler, Profiler::Simplicity);
+          model->removeVertex(clicked);
+        }
+        this->_history().removeVertex(model, clicked, removed);
 
 #ifdef DEBUG
         qDebug() << "Deleted vertex #" << clicked << "on" << model->name;
 #endif
-        this->_renderer->updateData(*model);
+        this->_updateData(*model);
       }
     }
 
-    this->_renderer->updateView(*model);
+    this->_updateView(*model);
     this->update();
   }
 }
 
 void ShapelyWidget::mouseReleaseEvent(QMouseEvent *e) {
+  this->_applyDrag();
+  // ^ So the vertex ends up exactly where it was dropped
 
 #ifdef DEBUG
   if (this->_selected != NO_POINT_SELECTED) {
@@ -232,6 +334,12 @@ void ShapelyWidget::mouseReleaseEvent(QMouseEvent *e) {
     }
   }
 #endif
+  this->releaseVertex();
+}
+
+void ShapelyWidget::releaseVertex() {
+  this->_applyDrag();
+  this->_history().seal();
   this->_selected = NO_POINT_SELECTED;
   this->setCursor(this->_default);
   this->update();
@@ -245,9 +353,11 @@ void ShapelyWidget::translateX(const double x) {
     Q_ASSERT(this->_renderer);
 
     float tx = model->transform.dx(); // horizontal translation
+    QTransform from = model->transform;
     model->transform.translate(x - tx, 0);
+    this->_history().transform(model, from, EditHistory::Translate);
 
-    this->_renderer->updateView(*model);
+    this->_updateView(*model);
 
     this->update();
 #ifdef DEBUG
@@ -263,9 +373,11 @@ void ShapelyWidget::translateY(const double y) {
     Q_ASSERT(this->_renderer);
 
     float ty = model->transform.dy(); // vertical translation
+    QTransform from = model->transform;
     model->transform.translate(0, y - ty);
+    this->_history().transform(model, from, EditHistory::Translate);
 
-    this->_renderer->updateView(*model);
+    this->_updateView(*model);
 
     this->update();
 #ifdef DEBUG
@@ -281,9 +393,11 @@ void ShapelyWidget::rotate(const int degrees) {
 
     float d = degrees * (M_PI / 180.0f);
     float a = std::atan2(model->transform.m22(), model->transform.m21());
+    QTransform from = model->transform;
     model->transform.rotateRadians(-d - a);
+    this->_history().transform(model, from, EditHistory::Rotate);
 
-    this->_renderer->updateView(*model);
+    this->_updateView(*model);
 
     this->update();
 #ifdef DEBUG
@@ -303,8 +417,10 @@ void ShapelyWidget::scaleX(double x) {
       Q_ASSERT(this->_renderer);
 
       float sx = model->transform.m11(); // horizontal scaling factor
+      QTransform from = model->transform;
       model->transform.scale(x / sx, 1);
-      this->_renderer->updateView(*model);
+      this->_history().transform(model, from, EditHistory::Scale);
+      this->_updateView(*model);
 
       this->update();
 #ifdef DEBUG
@@ -324,8 +440,10 @@ void ShapelyWidget::scaleY(double y) {
       Q_ASSERT(this->_renderer);
 
       float sy = model->transform.m22(); // vertical scaling factor
+      QTransform from = model->transform;
       model->transform.scale(1, y / sy);
-      this->_renderer->updateView(*model);
+      this->_history().transform(model, from, EditHistory::Scale);
+      this->_updateView(*model);
 
       this->update();
 #ifdef DEBUG
@@ -343,8 +461,10 @@ void ShapelyWidget::shearX(double x) {
       Q_ASSERT(this->_renderer);
 
       float sx = model->transform.m21(); // horizontal shearing
+      QTransform from = model->transform;
       model->transform.shear(x - sx, 0);
-      this->_renderer->updateView(*model);
+      this->_history().transform(model, from, EditHistory::Shear);
+      this->_updateView(*model);
 
 #ifdef DEBUG
       qDebug() << "Sheared horizontally to" << x;
@@ -363,8 +483,10 @@ void ShapelyWidget::shearY(double y) {
       Q_ASSERT(this->_renderer);
 
       float sy = model->transform.m12(); // horizontal shearing
+      QTransform from = model->transform;
       model->transform.shear(0, y - sy);
-      this->_renderer->updateView(*model);
+      this->_history().transform(model, from, EditHistory::Shear);
+      this->_updateView(*model);
 
 #ifdef DEBUG
       qDebug() << "Sheared vertically to" << y;
@@ -380,22 +502,36 @@ void ShapelyWidget::reflect() {
   if (model) {
     Q_ASSERT(this->_renderer);
 
+    QTransform from = model->transform;
     model->transform *= REFLECT;
-    this->_renderer->updateView(*model);
+    this->_history().transform(model, from, EditHistory::Reflect);
+    this->_updateView(*model);
   }
   this->update();
 }
 
 void ShapelyWidget::setRenderer(const int hardware) {
+  this->makeCurrent();
+  // We're called from a signal, not from a paint, so the context may not be
+  // current; the renderers compile shaders and create GL objects
+
+  this->_renderer.reset();
+  // Destroy the old renderer first, so it doesn't disable the new one's vertex
+  // attributes on its way out
+
   if (hardware) {
     this->_renderer.reset(
         new ShaderRenderer(":/shader/shader.vert", ":/shader/shader.frag",
                            this->context(), this, &this->_vbo));
   } else {
-    this->_renderer.reset(
-        new MidpointRenderer(":/shader/shader.vert", ":/shader/shader.frag",
-                             this->context(), this, &this->_vbo));
+    this->_renderer.reset(new MidpointRenderer(
+        ":/shader/framebuffer.vert", ":/shader/framebuffer.frag",
+        this->context(), this, &this->_vbo));
   }
+  this->_renderer->setFillMode(this->_fillMode);
+  this->_renderer->setLogger(&this->_log);
+  this->_renderer->setProfiler(&this->_profiler);
+  this->_renderer->setResultListener(this->_repaintLater());
 
 #ifdef DEBUG
   qDebug() << ((hardware) ? "Enabled" : "Disabled") << "hardware rasterization";
@@ -407,8 +543,21 @@ void ShapelyWidget::setRenderer(const int hardware) {
     Q_ASSERT(this->_renderer);
 
     this->_renderer->updateSize(this->width(), this->height());
-    this->_renderer->updateData(*model);
-    this->_renderer->updateView(*model);
+    this->_updateData(*model);
+    this->_updateView(*model);
+  }
+  this->doneCurrent();
+  this->update();
+}
+
+void ShapelyWidget::setFillMode(const int mode) {
+  Q_ASSERT(this->_renderer);
+  this->_fillMode = static_cast<AbstractRenderer::FillMode>(mode);
+  this->_renderer->setFillMode(this->_fillMode);
+
+  QSharedPointer<ShapelyModel> model = this->_currentModel();
+  if (model) {
+    this->_updateData(*model);
   }
   this->update();
 }
@@ -433,32 +582,127 @@ void ShapelyWidget::setModel(QListWidgetItem *current, QListWidgetItem *prev) {
   }
 #endif
 
+  this->_drag.discard();
+  // ^ It was meant for the other model
+
   if (now) {
-    this->_renderer->updateData(*now);
-    this->_renderer->updateView(*now);
+    now->load();
+    // ^ If it's from a scene, the renderers need their own copy; its trackers
+    // wait until it's edited
+    this->_updateData(*now);
+    this->_updateView(*now);
+  }
+  this->update();
+}
+
+Profiler &ShapelyWidget::profiler() noexcept { return this->_profiler; }
+
+const DragCoalescer &ShapelyWidget::drag() const noexcept {
+  return this->_drag;
+}
+
+void ShapelyWidget::showEdit(const EditHistory::Edit &edit) {
+  Q_ASSERT(this->_renderer);
+
+  if (edit.kind == EditHistory::MoveVertex) {
+    this->_updateVertex(*edit.model, edit.index);
+  } else if (edit.kind != EditHistory::Transform) {
+    this->_updateData(*edit.model);
+    // ^ Inserting or removing a vertex renumbers the ones after it
   }
+
+  this->_updateView(*edit.model);
   this->update();
 }
 
+void ShapelyWidget::_updateData(const ShapelyModel &model) {
+  Profiler::Scope scope(&this->_profiler, Profiler::UpdateData);
+  this->_renderer->updateData(model);
+}
+
+void ShapelyWidget::_updateVertex(const ShapelyModel &model, const int index) {
+  Profiler::Scope scope(&this->_profiler, Profiler::UpdateData);
+  this->_renderer->updateVertex(model, index);
+}
+
+void ShapelyWidget::_updateView(const ShapelyModel &model) {
+  Profiler::Scope scope(&this->_profiler, Profiler::UpdateView);
+  this->_renderer->updateView(model);
+}
+
+/**
+ * @return Something a renderer's pipeline can call from its own thread to
+ * have the widget repainted with what it just finished
+ */
+AbstractRenderer::Listener ShapelyWidget::_repaintLater() {
+  return [this]() {
+    QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+  };
+}
+
 QSharedPointer<ShapelyModel> ShapelyWidget::_currentModel() noexcept {
   ShapelyWindow *w = static_cast<ShapelyWindow *>(this->window());
   Q_ASSERT(typeid(*w) == typeid(ShapelyWindow));
   return w->currentModel();
 }
 
+EditHistory &ShapelyWidget::_history() noexcept {
+  ShapelyWindow *w = static_cast<ShapelyWindow *>(this->window());
+  Q_ASSERT(typeid(*w) == typeid(ShapelyWindow));
+  return w->history();
+}
+
+/**
+ * @return The index of the current model's vertex nearest to the given point
+ * (in widget pixels), if its marker is within MARKER_RADIUS pixels of it, else
+ * NO_POINT_SELECTED
+ */
 int ShapelyWidget::_clickedPoint(const QPointF &point) noexcept {
+  using Constants::MARKER_RADIUS;
   QSharedPointer<ShapelyModel> model = this->_currentModel();
 
-  if (model) {
-    for (int i = 0; i < model->polygon.size(); ++i) {
-      const QPointF &p = model->polygon[i];
-      QPointF delta = p - point;
-      if (delta.x() * delta.x() + delta.y() * delta.y() <=
-          Constants::MARKER_RADIUS * Constants::MARKER_RADIUS) {
-        return i;
-      }
-    }
+  if (!model)
+    return NO_POINT_SELECTED;
+
+  float w = this->width();
+  float h = this->height();
+  QPointF click(point.x(), h - point.y());
+  // ^ Flipped to match the renderers, with y going up
+
+  auto toWorld = [this, w, h](const QPointF &pixel) {
+    return this->_renderer->unproject(jtg::map<float>(pixel.x(), 0, w, -1, 1),
+                                      jtg::map<float>(pixel.y(), 0, h, -1, 1));
+  };
+
+  QPolygonF corners;
+  for (const QPointF &offset :
+       {QPointF(-MARKER_RADIUS, -MARKER_RADIUS),
+        QPointF(MARKER_RADIUS, -MARKER_RADIUS),
+        QPointF(MARKER_RADIUS, MARKER_RADIUS),
+        QPointF(-MARKER_RADIUS, MARKER_RADIUS)}) {
+    corners.append(toWorld(click + offset));
   }
+  // ^ The square of pixels around the click, in world space; the model
+  // transform can rotate or shear it, so take its bounding box
+
+  int nearest = NO_POINT_SELECTED;
+  float nearestDistance = MARKER_RADIUS * MARKER_RADIUS;
+  model->track();
+  // ^ A click is where editing a model opened from a scene starts
+  model->vertices.query(corners.boundingRect(), [&](const int i) {
+    const QPointF &p = model->polygon[i];
+    QPointF ndc = this->_renderer->project(p.x(), p.y());
+    QPointF delta(jtg::map<float>(ndc.x(), -1, 1, 0, w) - click.x(),
+                  jtg::map<float>(ndc.y(), -1, 1, 0, h) - click.y());
+    float distance = delta.x() * delta.x() + delta.y() * delta.y();
+
+    if (distance <= nearestDistance) {
+      // If this vertex's marker is under the mouse, and closer than any other
+      // we've seen...
+      nearest = i;
+      nearestDistance = distance;
+    }
+  });
 
-  return NO_POINT_SELECTED;
+  return nearest;
 }
@@ -11,7 +11,11 @@
 #include <QOpenGLWidget>
 #include <QVector>
 
+#include "DragCoalescer.hpp"
+#include "model/EditHistory.hpp"
 #include "renderer/AbstractRenderer.hpp"
+#include "renderer/SceneRenderer.hpp"
+#include "profiling/Profiler.hpp"
 
 struct ShapelyModel;
 class QMouseEvent;
@@ -27,6 +31,14 @@ public:
   ShapelyWidget(QWidget *parent);
   virtual ~ShapelyWidget();
 
+  Profiler &profiler() noexcept;
+  const DragCoalescer &drag() const noexcept;
+  // ^ How many drag moves were applied, and how many were skipped
+  void releaseVertex();
+  // ^ Drops whatever vertex is being dragged, as if the mouse were released
+  void showEdit(const EditHistory::Edit &);
+  // ^ The current model was just changed by undoing or redoing that edit
+
 protected:
   void paintGL() override;
   void resizeGL(const int w, const int h) override;
@@ -43,11 +55,24 @@ private:
   QCursor _default;
   QCursor _gripping;
   QSharedPointer<ShapelyModel> _currentModel() noexcept;
+  EditHistory &_history() noexcept;
   int _clickedPoint(const QPointF &point) noexcept;
+  void _updateData(const ShapelyModel &);
+  void _updateVertex(const ShapelyModel &, const int index);
+  void _updateView(const ShapelyModel &);
+  // ^ Call the renderer's, and time it; the expensive part happens on its
+  // pipeline, so this only measures handing it over
+  AbstractRenderer::Listener _repaintLater();
+  void _applyDrag();
 
   std::unique_ptr<AbstractRenderer> _renderer;
+  std::unique_ptr<SceneRenderer> _scene;
+  // ^ Draws every model but the current one
   int _selected;
+  AbstractRenderer::FillMode _fillMode;
+  DragCoalescer _drag;
 
+  Profiler _profiler;
   QOpenGLDebugLogger _log;
   QOpenGLBuffer _vbo;
   QOpenGLVertexArrayObject _vao;
@@ -65,7 +90,9 @@ private slots:
   //////////////////////////////////////////////////////////////////////////////
 
   void setRenderer(const int);
+  void setFillMode(const int);
   void setModel(QListWidgetItem *current, QListWidgetItem *prev);
+  void frameShown();
 };
 
 #endif // SHAPELYWIDGET_HPP
@@ -1,20 +1,57 @@
 #include "ShapelyWindow.hpp"
 #include "ui_shapely.h"
 
+#include <exception>
+
+#include <QDoubleSpinBox>
+#include <QFileDialog>
 #include <QListWidgetItem>
+#include <QMessageBox>
+#include <QProgressBar>
+#include <QPushButton>
 #include <QPointF>
 #include <QSharedPointer>
+#include <QSignalBlocker>
+#include <QTransform>
 #include <QVariant>
 
 #include "Constants.hpp"
+#include "DragCoalescer.hpp"
+#include "ShapelyWidget.hpp"
+#include "model/SceneFile.hpp"
 #include "model/ShapelyModel.hpp"
+#include "profiling/Profiler.hpp"
+
+constexpr int TIMINGS_INTERVAL = 250;
+// ^ Milliseconds between status bar updates
+constexpr char SCENE_FILTER[] = "Shapely scenes (*.shapely)";
+constexpr char IMPORT_FILTER[] =
+    "Polygons (*.wkt *.geojson *.json *.csv);;WKT (*.wkt);;"
+    "GeoJSON (*.geojson *.json);;CSV (*.csv)";
+constexpr int PROGRESS_STEPS = 1000;
+// ^ The progress bar only takes ints, and files can be bigger than that
 
 ShapelyWindow::ShapelyWindow(QWidget *parent)
-    : QMainWindow(parent), ui(new Ui::Shapely), _created(0) {
+    : QMainWindow(parent), ui(new Ui::Shapely), _created(0),
+      _importer(nullptr), _importProgress(new QProgressBar(this)),
+      _cancelImport(new QPushButton("Cancel", this)) {
   ui->setupUi(this);
+  this->_timingsShown.start();
+
+  this->_importProgress->setRange(0, PROGRESS_STEPS);
+  this->_importProgress->hide();
+  this->_cancelImport->hide();
+  this->ui->statusBar->addPermanentWidget(this->_importProgress);
+  this->ui->statusBar->addPermanentWidget(this->_cancelImport);
+
+  this->_history.setListener([this]() { this->_updateHistoryActions(); });
 }
 
-ShapelyWindow::~ShapelyWindow() { delete ui; }
+ShapelyWindow::~ShapelyWindow() {
+  delete this->_importer;
+  // ^ Stops it before anything it might send to goes away
+  delete ui;
+}
 
 QSharedPointer<ShapelyModel> ShapelyWindow::currentModel() noexcept {
   QListWidgetItem *item = this->ui->polygons->currentItem();
@@ -26,20 +63,303 @@ QSharedPointer<ShapelyModel> ShapelyWindow::currentModel() noexcept {
   }
 }
 
+const QVector<QSharedPointer<ShapelyModel>> &
+ShapelyWindow::models() const noexcept {
+  return this->_models;
+}
+
+EditHistory &ShapelyWindow::history() noexcept { return this->_history; }
+
+/**
+ * Puts the model in the list at row, or at the end if row is negative (or past
+ * the end)
+ */
+QListWidgetItem *
+ShapelyWindow::_addModel(const QSharedPointer<ShapelyModel> &model,
+                         const int row) {
+  QListWidgetItem *item =
+      new QListWidgetItem(model->name, nullptr, QListWidgetItem::UserType);
+
+  item->setData(Constants::MODEL_ROLE, QVariant::fromValue(model));
+  if (0 <= row && row < this->ui->polygons->count()) {
+    this->ui->polygons->insertItem(row, item);
+  } else {
+    this->ui->polygons->addItem(item);
+  }
+  this->_models.append(model);
+  // ^ Even if it's going back where it was, so the scene renderer only has to
+  // add it, not pack everything again
+  return item;
+}
+
+/**
+ * Takes the model at row out of the list
+ */
+void ShapelyWindow::_removeModel(const int row) {
+  this->_models.removeOne(this->ui->polygons->item(row)
+                              ->data(Constants::MODEL_ROLE)
+                              .value<QSharedPointer<ShapelyModel>>());
+  delete this->ui->polygons->takeItem(row);
+}
+
+/**
+ * @return Where the model is in the list, or -1 if it isn't
+ */
+int ShapelyWindow::_row(const ShapelyModel *model) const noexcept {
+  int n = this->ui->polygons->count();
+
+  for (int i = 0; i < n; ++i) {
+    if (this->ui->polygons->item(i)
+            ->data(Constants::MODEL_ROLE)
+            .value<QSharedPointer<ShapelyModel>>()
+            .data() == model) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
 void ShapelyWindow::createPolygon() noexcept {
   QString name = QString("polygon%1").arg(QString::number(this->_created++));
-  QListWidgetItem *item =
-      new QListWidgetItem(name, nullptr, QListWidgetItem::UserType);
   QSharedPointer<ShapelyModel> model = QSharedPointer<ShapelyModel>::create();
   model->name = name;
 
-  QVariant data = QVariant::fromValue(model);
-
-  item->setData(Constants::MODEL_ROLE, data);
-  this->ui->polygons->addItem(item);
+  QListWidgetItem *item = this->_addModel(model);
+  this->_history.addModel(model, this->ui->polygons->row(item));
 #ifdef DEBUG
-  qDebug() << "Created a new polygon named"
-           << data.value<QSharedPointer<ShapelyModel>>()->name;
+  qDebug() << "Created a new polygon named" << model->name;
 #endif
   this->ui->polygons->setCurrentItem(item);
 }
+
+void ShapelyWindow::removePolygon() {
+  int row = this->ui->polygons->currentRow();
+  if (row < 0)
+    return;
+
+  QSharedPointer<ShapelyModel> model = this->currentModel();
+  this->ui->canvas->releaseVertex();
+  this->_removeModel(row);
+  this->_history.removeModel(model, row);
+  // ^ The history keeps the model alive, in case it's brought back
+}
+
+void ShapelyWindow::undo() {
+  this->ui->canvas->releaseVertex();
+  // ^ A drag in progress is finished first, so that's what gets undone
+
+  const EditHistory::Edit *edit = this->_history.undo();
+  if (edit) {
+    this->_showEdit(*edit, true);
+  }
+}
+
+void ShapelyWindow::redo() {
+  this->ui->canvas->releaseVertex();
+
+  const EditHistory::Edit *edit = this->_history.redo();
+  if (edit) {
+    this->_showEdit(*edit, false);
+  }
+}
+
+/**
+ * Brings the list and the canvas up to date with an edit that was just undone
+ * (or redone, if not undone).  The history has already applied vertex and
+ * transform edits to the model; adding it to or removing it from the list is
+ * up to us.
+ */
+void ShapelyWindow::_showEdit(const EditHistory::Edit &edit,
+                              const bool undone) {
+  if (edit.kind == EditHistory::AddModel ||
+      edit.kind == EditHistory::RemoveModel) {
+    if ((edit.kind == EditHistory::AddModel) != undone) {
+      this->ui->polygons->setCurrentItem(
+          this->_addModel(edit.model, edit.index));
+    } else {
+      this->_removeModel(this->_row(edit.model.data()));
+    }
+    return;
+  }
+
+  int row = this->_row(edit.model.data());
+  Q_ASSERT(row >= 0);
+  // ^ Edits to a model that was removed come before its removal, so it's
+  // back in the list by the time they're undone
+
+  if (row != this->ui->polygons->currentRow()) {
+    this->ui->polygons->setCurrentRow(row);
+    // ^ So the edit can be seen; the canvas shows the whole model anew
+  } else {
+    this->ui->canvas->showEdit(edit);
+  }
+
+  if (edit.kind == EditHistory::Transform) {
+    this->_showTransform(edit.model->transform);
+  }
+}
+
+/**
+ * Puts the transform's entries in the spin boxes that set them, without the
+ * spin boxes passing them on to the canvas (which would record a new edit).
+ */
+void ShapelyWindow::_showTransform(const QTransform &transform) {
+  struct {
+    QDoubleSpinBox *box;
+    double value;
+  } shown[] = {{this->ui->translateX, transform.dx()},
+               {this->ui->translateY, transform.dy()},
+               {this->ui->scaleX, transform.m11()},
+               {this->ui->scaleY, transform.m22()},
+               {this->ui->shearX, transform.m21()},
+               {this->ui->shearY, transform.m12()}};
+  // ^ The same entries ShapelyWidget's slots read back
+
+  for (const auto &s : shown) {
+    QSignalBlocker blocker(s.box);
+    s.box->setValue(s.value);
+  }
+}
+
+void ShapelyWindow::_updateHistoryActions() noexcept {
+  this->ui->actionUndo->setEnabled(this->_history.canUndo());
+  this->ui->actionRedo->setEnabled(this->_history.canRedo());
+}
+
+void ShapelyWindow::showTimings(int) {
+  if (this->_timingsShown.elapsed() < TIMINGS_INTERVAL)
+    return;
+
+  this->_timingsShown.restart();
+  QString message = this->ui->canvas->profiler().summary();
+
+  const DragCoalescer &drag = this->ui->canvas->drag();
+  if (drag.received()) {
+    message += QString("  |  drag: %1 of %2 moves coalesced")
+                   .arg(drag.coalesced())
+                   .arg(drag.received());
+  }
+
+  this->ui->statusBar->showMessage(message);
+}
+
+void ShapelyWindow::exportTimings() {
+  QString path = QFileDialog::getSaveFileName(
+      this, "Export Timings", "timings.csv", "CSV files (*.csv)");
+  if (path.isEmpty())
+    return;
+
+  if (!this->ui->canvas->profiler().exportCsv(path)) {
+    QMessageBox::warning(this, "Export Timings",
+                         QString("Could not write %1").arg(path));
+  }
+}
+
+void ShapelyWindow::openScene() {
+  if (this->_importer)
+    return;
+
+  QString path =
+      QFileDialog::getOpenFileName(this, "Open Scene", QString(), SCENE_FILTER);
+  if (path.isEmpty())
+    return;
+
+  try {
+    SceneFile file(path);
+  } catch (const std::exception &e) {
+    QMessageBox::warning(this, "Open Scene", e.what());
+    return;
+  }
+  // ^ Only maps it and checks the header and model table, so a bad file
+  // changes nothing
+
+  this->_models.clear();
+  this->ui->polygons->clear();
+  this->_history.clear();
+  // ^ Its edits were to models that are gone
+  this->_startImport(path, Importer::Scene);
+  // ^ Models are only built from the mapped file, but scenes that don't say
+  // which models are simple take seconds per ten million vertices to track, so
+  // they're built in the background and show up as they're ready
+}
+
+void ShapelyWindow::saveScene() {
+  QString path = QFileDialog::getSaveFileName(
+      this, "Save Scene", "scene.shapely", SCENE_FILTER);
+  if (path.isEmpty())
+    return;
+
+  try {
+    SceneFile::save(path, this->models());
+  } catch (const std::exception &e) {
+    QMessageBox::warning(this, "Save Scene", e.what());
+  }
+}
+
+void ShapelyWindow::importPolygons() {
+  if (this->_importer)
+    return;
+
+  QString path = QFileDialog::getOpenFileName(this, "Import Polygons",
+                                              QString(), IMPORT_FILTER);
+  if (path.isEmpty())
+    return;
+
+  this->_startImport(path, Importer::Polygons);
+}
+
+void ShapelyWindow::_startImport(const QString &path,
+                                 const Importer::Format format) {
+  this->_importer = new Importer(path, format, this);
+  connect(this->_importer, &Importer::progress, this,
+          &ShapelyWindow::showImportProgress);
+  connect(this->_importer, &Importer::imported, this,
+          &ShapelyWindow::addImported);
+  connect(this->_importer, &Importer::failed, this,
+          &ShapelyWindow::showImportError);
+  connect(this->_importer, &QThread::finished, this,
+          &ShapelyWindow::finishImport);
+  connect(this->_cancelImport, &QPushButton::clicked, this->_importer,
+          &Importer::cancel);
+
+  this->ui->actionOpen->setEnabled(false);
+  this->ui->actionImport->setEnabled(false);
+  this->_importProgress->setValue(0);
+  this->_importProgress->show();
+  this->_cancelImport->show();
+  this->_importer->start();
+}
+
+void ShapelyWindow::showImportProgress(qint64 read, qint64 total) {
+  this->_importProgress->setValue(total ? read * PROGRESS_STEPS / total
+                                        : PROGRESS_STEPS);
+}
+
+void ShapelyWindow::addImported(Importer::Models models) {
+  bool none = this->ui->polygons->currentItem() == nullptr;
+
+  this->ui->polygons->setUpdatesEnabled(false);
+  for (const QSharedPointer<ShapelyModel> &model : models) {
+    this->_addModel(model);
+  }
+  this->ui->polygons->setUpdatesEnabled(true);
+
+  if (none && this->ui->polygons->count()) {
+    this->ui->polygons->setCurrentRow(0);
+  }
+}
+
+void ShapelyWindow::showImportError(const QString &error) {
+  QMessageBox::warning(this, "Import Polygons", error);
+}
+
+void ShapelyWindow::finishImport() {
+  this->_importer->deleteLater();
+  this->_importer = nullptr;
+
+  this->_importProgress->hide();
+  this->_cancelImport->hide();
+  this->ui->actionOpen->setEnabled(true);
+  this->ui->actionImport->setEnabled(true);
+}
@@ -1,13 +1,21 @@
 #ifndef SHAPELY_HPP
 #define SHAPELY_HPP
 
+#include <QElapsedTimer>
 #include <QMainWindow>
+#include <QVector>
+#include "io/Importer.hpp"
+#include "model/EditHistory.hpp"
 #include "model/ShapelyModel.hpp"
 
 namespace Ui {
 class Shapely;
 }
 
+class QListWidgetItem;
+class QProgressBar;
+class QPushButton;
+class QTransform;
 template <class T> class QSharedPointer;
 
 class ShapelyWindow : public QMainWindow {
@@ -16,14 +24,50 @@ class ShapelyWindow : public QMainWindow {
 public:
   explicit ShapelyWindow(QWidget *parent = 0);
   QSharedPointer<ShapelyModel> currentModel() noexcept;
+  const QVector<QSharedPointer<ShapelyModel>> &models() const noexcept;
+  // ^ Every polygon in the list, in the order they were added (the list itself
+  // is sorted by name)
+  EditHistory &history() noexcept;
+  // ^ Where the canvas records its edits
   ~ShapelyWindow();
 
 private slots:
   void createPolygon() noexcept;
+  void removePolygon();
+  void undo();
+  void redo();
+  void showTimings(int ms);
+  void exportTimings();
+  void openScene();
+  void saveScene();
+  void importPolygons();
+  void showImportProgress(qint64 read, qint64 total);
+  void addImported(Importer::Models models);
+  void showImportError(const QString &error);
+  void finishImport();
 
 private:
+  QListWidgetItem *_addModel(const QSharedPointer<ShapelyModel> &,
+                             const int row = -1);
+  void _removeModel(const int row);
+  int _row(const ShapelyModel *) const noexcept;
+  void _startImport(const QString &path, const Importer::Format);
+  void _showEdit(const EditHistory::Edit &, const bool undone);
+  void _showTransform(const QTransform &);
+  void _updateHistoryActions() noexcept;
+
   Ui::Shapely *ui;
+  QVector<QSharedPointer<ShapelyModel>> _models;
+  // ^ The list's models, kept alongside it so the canvas can have them every
+  // frame without unpacking each item's QVariant
   int _created;
+  QElapsedTimer _timingsShown;
+  // ^ So the status bar isn't redrawn every frame
+  Importer *_importer;
+  // ^ The import (or scene being opened) in progress, if any
+  QProgressBar *_importProgress;
+  QPushButton *_cancelImport;
+  EditHistory _history;
 };
 
 #endif // SHAPELY_HPP
@@ -1,85 +1,587 @@
 #include "Utility.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <set>
+#include <unordered_set>
+#include <vector>
+
 #include <QtGlobal>
 #include <QLineF>
 #include <QPair>
 #include <QPoint>
 #include <QPolygonF>
+#include <QRectF>
 #include <QVector>
 
+#include "renderer/FrameArena.hpp"
+
 namespace jtg {
 
+namespace {
+// Shamos-Hoey: sweep a vertical line from left to right, keeping the edges it
+// crosses sorted from bottom to top.  Two edges can't cross without first
+// being neighbors in that order, so we only ever need to test neighbors, and
+// we can stop at the first intersection since that's all we care about.
+
+struct Segment {
+  QPointF a; // Left (or bottom, if vertical) end
+  QPointF b; // Right (or top) end
+  int index; // Which edge of the polygon this is
+};
+
+inline bool lexLess(const QPointF &p, const QPointF &q) noexcept {
+  return p.x() < q.x() || (p.x() == q.x() && p.y() < q.y());
+}
+
+inline qreal cross(const QPointF &o, const QPointF &a,
+                   const QPointF &b) noexcept {
+  return (a.x() - o.x()) * (b.y() - o.y()) - (a.y() - o.y()) * (b.x() - o.x());
+}
+
+/**
+ * @return Positive if p is above s, negative if below, 0 if on it (or on the
+ * line through it).  Vertical segments count as having an infinite slope, so
+ * anything to their right is below them.
+ */
+inline int side(const Segment &s, const QPointF &p) noexcept {
+  int o = jtg::sign(cross(s.a, s.b, p));
+  if (o == 0 && s.a.x() == s.b.x()) {
+    // If p is directly above or below a vertical s...
+    return (p.y() > s.b.y()) - (p.y() < s.a.y());
+  }
+
+  return o;
+}
+
+inline bool onSegment(const QPointF &a, const QPointF &b,
+                      const QPointF &p) noexcept {
+  // Assumes p is collinear with a and b
+  return qMin(a.x(), b.x()) <= p.x() && p.x() <= qMax(a.x(), b.x()) &&
+         qMin(a.y(), b.y()) <= p.y() && p.y() <= qMax(a.y(), b.y());
+}
+
+/**
+ * @return Positive if s is above t where the sweep line crosses both of them,
+ * negative if it's below, 0 if they overlap
+ */
+int compare(const Segment &s, const Segment &t) noexcept {
+  int o;
+  if (!lexLess(s.a, t.a)) {
+    // Compare where s begins against t, since t is already there...
+    o = side(t, s.a);
+    if (o == 0)
+      o = side(t, s.b);
+    if (o == 0)
+      o = -side(s, t.b);
+    // ^ ...unless that doesn't tell us anything (e.g. t is vertical), in
+    // which case look at it from s's point of view
+  } else {
+    o = -side(s, t.a);
+    if (o == 0)
+      o = -side(s, t.b);
+    if (o == 0)
+      o = side(t, s.b);
+  }
+
+  return o;
+}
+
+struct SweepOrder {
+  bool operator()(const Segment *s, const Segment *t) const noexcept {
+    if (s == t)
+      return false;
+
+    int o = (s->index < t->index) ? compare(*s, *t) : -compare(*t, *s);
+    // ^ Always compare a given pair the same way around, so the answer's
+    // consistent in degenerate cases
+    if (o != 0)
+      return o < 0;
+
+    return s->index < t->index;
+    // ^ Collinear and overlapping; they intersect anyway, this just has to be
+    // consistent until we notice
+  }
+};
+
+struct SweepEvent {
+  QPointF point;
+  const Segment *segment;
+  bool left;
+
+  bool operator<(const SweepEvent &o) const noexcept {
+    if (this->point != o.point)
+      return lexLess(this->point, o.point);
+    return this->left > o.left;
+    // ^ At the same point, insert before removing so that edges that only
+    // touch there still get compared
+  }
+};
+
+inline bool intersects(const Segment &s, const Segment &t,
+                       const int n) noexcept {
+  int i = s.index;
+  int j = t.index;
+  return segmentsIntersect(s.a, s.b, t.a, t.b,
+                           (i + 1) % n == j || (j + 1) % n == i);
+}
+}
+
+bool segmentsIntersect(const QPointF &a, const QPointF &b, const QPointF &c,
+                       const QPointF &d, const bool adjacent) noexcept {
+  qreal d1 = cross(a, b, c);
+  qreal d2 = cross(a, b, d);
+  qreal d3 = cross(c, d, a);
+  qreal d4 = cross(c, d, b);
+
+  if (adjacent) {
+    // Neighboring edges always share one vertex; the only problem is if they
+    // double back over each other
+    if (d1 != 0 || d2 != 0)
+      return false;
+
+    const QPointF &shared = (a == c || a == d) ? a : b;
+    const QPointF &p = (shared == a) ? b : a;
+    const QPointF &q = (shared == c) ? d : c;
+    return QPointF::dotProduct(p - shared, q - shared) > 0;
+  }
+
+  if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) &&
+      ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))) {
+    // If each edge's endpoints are strictly on opposite sides of the other...
+    return true;
+  }
+
+  return (d1 == 0 && onSegment(a, b, c)) || (d2 == 0 && onSegment(a, b, d)) ||
+         (d3 == 0 && onSegment(c, d, a)) || (d4 == 0 && onSegment(c, d, b));
+  // ^ An endpoint of one is on the other
+}
+
+std::size_t PointHash::operator()(const QPointF &p) const noexcept {
+  std::hash<qreal> h;
+  return h(p.x() + 0.0) * 31 + h(p.y() + 0.0);
+  // ^ + 0.0 so that -0.0 and 0.0 hash the same, since they compare equal
+}
+
 bool isSimplePolygon(const QPolygonF &polygon) noexcept {
-  if (polygon.size() < 3)
+  int n = polygon.size();
+  if (n < 3)
     return false;
 
-  if (polygon.size() == 3)
+  if (n == 3)
     return true;
 
-  for (int i = 0; i < polygon.size(); ++i) {
-    if (i < polygon.size() - 1) {
-      // When we reach the end...
-      for (int h = i + 1; h < polygon.size(); ++h) {
+  std::unordered_set<QPointF, PointHash> seen;
+  seen.reserve(n);
+  for (const QPointF &p : polygon) {
+    if (!seen.insert(p).second) {
+      // If we have a duplicate vertex...
+      return false;
+    }
+  }
 
-        if (polygon[i] == polygon[h]) {
-          // If we have a duplicate vertex...
+  std::vector<Segment> segments(n);
+  std::vector<SweepEvent> events;
+  events.reserve(n * 2);
+  for (int i = 0; i < n; ++i) {
+    const QPointF &p = polygon[i];
+    const QPointF &q = polygon[(i + 1) % n];
+    Segment &s = segments[i];
+    s.a = lexLess(p, q) ? p : q;
+    s.b = lexLess(p, q) ? q : p;
+    s.index = i;
 
-          return false;
-        }
+    events.push_back(SweepEvent{s.a, &s, true});
+    events.push_back(SweepEvent{s.b, &s, false});
+  }
+  std::sort(events.begin(), events.end());
+
+  typedef std::set<const Segment *, SweepOrder> Status;
+  Status status;
+  std::vector<Status::iterator> where(n);
+
+  for (const SweepEvent &e : events) {
+    const Segment &s = *e.segment;
+
+    if (e.left) {
+      Status::iterator it = status.insert(&s).first;
+      where[s.index] = it;
+
+      if (it != status.begin() && intersects(**std::prev(it), s, n))
+        return false;
+
+      Status::iterator next = std::next(it);
+      if (next != status.end() && intersects(**next, s, n))
+        return false;
+    } else {
+      Status::iterator it = where[s.index];
+      Status::iterator next = std::next(it);
+
+      if (it != status.begin() && next != status.end() &&
+          intersects(**std::prev(it), **next, n)) {
+        // If the edges on either side of this one are about to become
+        // neighbors, check them against each other
+        return false;
       }
+
+      status.erase(it);
     }
+  }
 
-    int j = (i + 1) % polygon.size();
-    QPointF iToj = polygon[j] - polygon[i];
-    QPointF iTojNormal(iToj.y(), -iToj.x());
-    // i is the first vertex and j is the second
+  return true;
+}
 
-    int startK = (j + 1) % polygon.size();
-    int endK = (i - 1 + polygon.size()) % polygon.size();
-    endK += startK < endK ? 0 : startK + 1;
-    int k = startK;
+namespace {
+// Ear clipping.  Find the polygon's "ears" (convex corners whose triangle
+// contains no other vertex) and cut them off one at a time.
+// Only reflex vertices can be inside an ear, so only they go into a uniform
+// grid, and each ear test only looks at the reflex vertices near it.  Cutting
+// an ear never makes a vertex reflex, so vertices only ever leave the grid.
 
-    QPointF iTok = polygon[k] - polygon[i];
+constexpr int NONE = -1;
+constexpr qreal CELL_EPSILON = 1e-7;
+// ^ Fraction of a cell to pad by, so rounding can't skip a cell we need
 
-    bool onLeftSide = QPointF::dotProduct(iTok, iTojNormal) >= 0;
+struct EarNode {
+  QPointF p;
+  int index; // Into the original polygon
+  int prev;
+  int next;
+  int blocker; // Reflex vertex that was last found inside this one's ear
+  bool reflex;
+  bool ear;
+  bool cut;
+};
 
-    QPointF prevK = polygon[k];
+struct GridEntry {
+  QPointF p; // Copied from the node, so scanning a cell stays in cache
+  int node;
+};
 
-    ++k;
+class EarClipper {
+public:
+  EarClipper(const QPolygonF &polygon, FrameArena &scratch) noexcept;
+  void clip(QVector<std::uint32_t> &triangles) noexcept;
 
-    for (; k <= endK; ++k) {
-      int modK = k % polygon.size();
+private:
+  bool _isReflex(const int i) const noexcept;
+  bool _isEar(const int i) noexcept;
+  void _cut(const int i) noexcept;
+  void _unmarkReflex(const int i) noexcept;
+  int _cellX(const qreal x) const noexcept;
+  int _cellY(const qreal y) const noexcept;
+  int _cell(const QPointF &p) const noexcept;
 
-      iTok = polygon[modK] - polygon[i];
+  FrameArena &_scratch;
+  // ^ Everything below comes from here
+  int _n;
+  EarNode *_nodes;
+  GridEntry *_reflex;
+  int *_cellStart;
+  int *_cellEnd;
+  // ^ The reflex vertices in cell c are _reflex[_cellStart[c], _cellEnd[c]);
+  // cells are row-major, and shrink as their vertices turn convex
+  qreal _left;
+  qreal _top;
+  qreal _cellSize;
+  int _columns;
+  int _rows;
+};
 
-      if (onLeftSide != QPointF::dotProduct(iTok, iTojNormal) >= 0) {
+EarClipper::EarClipper(const QPolygonF &polygon, FrameArena &scratch) noexcept
+    : _scratch(scratch), _n(polygon.size()) {
+  int n = this->_n;
 
-        QPointF prevKtoK = polygon[modK] - prevK;
+  qreal area = 0;
+  for (int i = 0; i < n; ++i) {
+    const QPointF &a = polygon[i];
+    const QPointF &b = polygon[(i + 1) % n];
+    area += a.x() * b.y() - b.x() * a.y();
+  }
+  bool clockwise = area < 0;
+  // ^ The ear test assumes counter-clockwise order, so walk backwards if not
 
-        QPointF prevKtoKNormal(prevKtoK.y(), -prevKtoK.x());
+  this->_nodes = scratch.allocate<EarNode>(n);
+  for (int i = 0; i < n; ++i) {
+    EarNode &node = this->_nodes[i];
+    node.index = clockwise ? n - 1 - i : i;
+    node.p = polygon[node.index];
+    node.prev = (i + n - 1) % n;
+    node.next = (i + 1) % n;
+    node.blocker = NONE;
+    node.ear = false;
+    node.cut = false;
+  }
 
-        if ((QPointF::dotProduct(polygon[i] - prevK, prevKtoKNormal) >= 0) !=
-            (QPointF::dotProduct(polygon[j] - prevK, prevKtoKNormal) >= 0)) {
+  QRectF bounds = polygon.boundingRect();
+  this->_left = bounds.left();
+  this->_top = bounds.top();
+  this->_cellSize =
+      std::max(std::sqrt(bounds.width() * bounds.height() / n),
+               std::max(bounds.width(), bounds.height()) / n);
+  // ^ About one vertex per cell, even for long, thin polygons
+  if (!(this->_cellSize > 0)) {
+    this->_cellSize = 1;
+  }
+  this->_columns = this->_cellX(bounds.right()) + 1;
+  this->_rows = this->_cellY(bounds.bottom()) + 1;
+
+  int cells = this->_columns * this->_rows;
+  this->_cellStart = scratch.allocate<int>(cells + 1);
+  std::fill(this->_cellStart, this->_cellStart + cells + 1, 0);
+  for (int i = 0; i < n; ++i) {
+    EarNode &node = this->_nodes[i];
+    node.reflex = this->_isReflex(i);
+    if (node.reflex) {
+      ++this->_cellStart[this->_cell(node.p) + 1];
+    }
+  }
+
+  for (int c = 0; c < cells; ++c) {
+    this->_cellStart[c + 1] += this->_cellStart[c];
+  }
+
+  this->_reflex = scratch.allocate<GridEntry>(this->_cellStart[cells]);
+  this->_cellEnd = scratch.allocate<int>(cells);
+  std::copy(this->_cellStart, this->_cellStart + cells, this->_cellEnd);
+  for (int i = 0; i < n; ++i) {
+    if (this->_nodes[i].reflex) {
+      GridEntry &e =
+          this->_reflex[this->_cellEnd[this->_cell(this->_nodes[i].p)]++];
+      e.p = this->_nodes[i].p;
+      e.node = i;
+    }
+  }
+}
+
+int EarClipper::_cellX(const qreal x) const noexcept {
+  return std::max<int>((x - this->_left) / this->_cellSize, 0);
+}
+
+int EarClipper::_cellY(const qreal y) const noexcept {
+  return std::max<int>((y - this->_top) / this->_cellSize, 0);
+}
+
+int EarClipper::_cell(const QPointF &p) const noexcept {
+  return this->_cellY(p.y()) * this->_columns + this->_cellX(p.x());
+}
+
+bool EarClipper::_isReflex(const int i) const noexcept {
+  const EarNode &node = this->_nodes[i];
+  return cross(this->_nodes[node.prev].p, node.p,
+               this->_nodes[node.next].p) <= 0;
+  // ^ Straight angles count as reflex, since they can sit on an ear's edge
+}
+
+bool EarClipper::_isEar(const int i) noexcept {
+  EarNode &b = this->_nodes[i];
+  const EarNode &a = this->_nodes[b.prev];
+  const EarNode &c = this->_nodes[b.next];
+
+  if (cross(a.p, b.p, c.p) <= 0)
+    return false;
+
+  auto inside = [&](const int j, const QPointF &r) {
+    return j != b.prev && j != b.next && cross(a.p, b.p, r) >= 0 &&
+           cross(b.p, c.p, r) >= 0 && cross(c.p, a.p, r) >= 0;
+  };
+
+  if (b.blocker != NONE && this->_nodes[b.blocker].reflex &&
+      inside(b.blocker, this->_nodes[b.blocker].p)) {
+    // If whatever was in the way last time still is...
+    return false;
+  }
+  // ^ A vertex next to a big triangle's corner gets tested every time that
+  // corner's neighbors are cut; this saves rescanning the whole triangle
+
+  int y0 = this->_cellY(qMin(a.p.y(), qMin(b.p.y(), c.p.y())));
+  int y1 = std::min(this->_cellY(qMax(a.p.y(), qMax(b.p.y(), c.p.y()))),
+                    this->_rows - 1);
+  qreal pad = this->_cellSize * CELL_EPSILON;
+  const QPointF *corners[] = {&a.p, &b.p, &c.p};
+
+  for (int y = y0; y <= y1; ++y) {
+    // Only look at the cells in this row that the triangle covers, rather
+    // than its whole bounding box; big ears are usually long and thin
+    qreal low = this->_top + y * this->_cellSize - pad;
+    qreal high = low + this->_cellSize + 2 * pad;
+    qreal left = std::numeric_limits<qreal>::max();
+    qreal right = std::numeric_limits<qreal>::lowest();
+
+    for (int k = 0; k < 3; ++k) {
+      const QPointF &p = *corners[k];
+      const QPointF &q = *corners[(k + 1) % 3];
+      if (qMax(p.y(), q.y()) < low || qMin(p.y(), q.y()) > high)
+        continue;
+
+      qreal xp = p.x();
+      qreal xq = q.x();
+      if (p.y() != q.y()) {
+        qreal dx = (q.x() - p.x()) / (q.y() - p.y());
+        xp = p.x() + dx * (qBound(low, p.y(), high) - p.y());
+        xq = p.x() + dx * (qBound(low, q.y(), high) - p.y());
+      }
+      // ^ The ends of the part of this edge that's within the row
+
+      left = qMin(left, qMin(xp, xq));
+      right = qMax(right, qMax(xp, xq));
+    }
+
+    int x0 = this->_cellX(left - pad);
+    int x1 = std::min(this->_cellX(right + pad), this->_columns - 1);
+    for (int x = x0; x <= x1; ++x) {
+      int cell = y * this->_columns + x;
+      for (int k = this->_cellStart[cell]; k < this->_cellEnd[cell]; ++k) {
+        const GridEntry &e = this->_reflex[k];
+        if (inside(e.node, e.p)) {
+          // If another vertex is inside (or on) this triangle...
+          b.blocker = e.node;
           return false;
         }
       }
+    }
+  }
+
+  return true;
+}
+
+void EarClipper::_cut(const int i) noexcept {
+  EarNode &node = this->_nodes[i];
+  EarNode &prev = this->_nodes[node.prev];
+  EarNode &next = this->_nodes[node.next];
+
+  prev.next = node.next;
+  next.prev = node.prev;
+  node.cut = true;
+
+  if (node.reflex)
+    this->_unmarkReflex(i);
+  // ^ Only when desperate; real ears are convex
+
+  if (prev.reflex && !this->_isReflex(node.prev))
+    this->_unmarkReflex(node.prev);
+  if (next.reflex && !this->_isReflex(node.next))
+    this->_unmarkReflex(node.next);
+  // ^ Cutting an ear can only turn a reflex neighbor convex, not vice versa
+}
+
+void EarClipper::_unmarkReflex(const int i) noexcept {
+  int cell = this->_cell(this->_nodes[i].p);
+  GridEntry *begin = this->_reflex + this->_cellStart[cell];
+  GridEntry *end = this->_reflex + this->_cellEnd[cell];
+
+  GridEntry *it = std::find_if(
+      begin, end, [i](const GridEntry &e) { return e.node == i; });
+  Q_ASSERT(it != end);
+  *it = end[-1];
+  --this->_cellEnd[cell];
+  this->_nodes[i].reflex = false;
+}
 
-      onLeftSide = QPointF::dotProduct(iTok, iTojNormal) > 0;
+void EarClipper::clip(QVector<std::uint32_t> &triangles) noexcept {
+  int n = this->_n;
+  int left = n;
+  int *ears = this->_scratch.allocate<int>(3 * n);
+  int front = 0;
+  int back = 0;
+  // ^ A queue that never wraps around: every vertex goes in once to start,
+  // and each cut adds at most its two neighbors
 
-      prevK = polygon[modK];
+  for (int i = 0; i < n; ++i) {
+    this->_nodes[i].ear = this->_isEar(i);
+    if (this->_nodes[i].ear) {
+      ears[back++] = i;
     }
   }
+  // ^ Cutting an ear only removes vertices, so every other ear stays an ear;
+  // only the two neighbors need to be looked at again.  Taking ears in FIFO
+  // order works around the polygon instead of fanning out from one corner.
 
-  return true;
+  int i = 0;
+  while (left > 3) {
+    if (front == back) {
+      // If no ears are left, the polygon wasn't quite simple (e.g. collinear
+      // edges that touch), so just cut whatever's next
+      while (this->_nodes[i].cut)
+        i = (i + 1) % n;
+    } else {
+      i = ears[front++];
+      if (this->_nodes[i].cut || !this->_nodes[i].ear)
+        continue;
+    }
+
+    const EarNode &node = this->_nodes[i];
+    int prev = node.prev;
+    int next = node.next;
+
+    if (cross(this->_nodes[prev].p, node.p, this->_nodes[next].p) != 0) {
+      triangles.append(this->_nodes[prev].index);
+      triangles.append(node.index);
+      triangles.append(this->_nodes[next].index);
+    }
+    // ^ Don't bother emitting triangles with no area
+
+    this->_cut(i);
+    --left;
+
+    for (int j : {prev, next}) {
+      bool ear = this->_isEar(j);
+      if (ear && !this->_nodes[j].ear) {
+        ears[back++] = j;
+      }
+      this->_nodes[j].ear = ear;
+    }
+  }
+
+  while (this->_nodes[i].cut)
+    i = (i + 1) % n;
+  // ^ Any of the last three will do
+
+  const EarNode &last = this->_nodes[i];
+  triangles.append(this->_nodes[last.prev].index);
+  triangles.append(last.index);
+  triangles.append(this->_nodes[last.next].index);
+}
 }
 
 /**
  * @brief decomposePolygon
- * @param polygon The polygon to decompose
- * @return A QPair containing a vertex buffer and an index buffer
+ * @param polygon The polygon to decompose; must be simple
+ * @return A QPair containing a vertex buffer (x, y for each of the polygon's
+ * vertices, in order) and an index buffer (three indices per triangle)
  */
-QPair<QVector<float>, QVector<uint16_t>>
+QPair<QVector<float>, QVector<uint32_t>>
 decomposePolygon(const QPolygonF &polygon) noexcept {
-  return QPair<QVector<float>, QVector<uint16_t>>();
+  QPair<QVector<float>, QVector<uint32_t>> result;
+  int n = polygon.size();
+
+  result.first.reserve(n * 2);
+  for (const QPointF &p : polygon) {
+    result.first.append(p.x());
+    result.first.append(p.y());
+  }
+
+  FrameArena scratch;
+  decomposePolygon(polygon, result.second, scratch);
+  return result;
+}
+
+void decomposePolygon(const QPolygonF &polygon,
+                      QVector<uint32_t> &triangles,
+                      FrameArena &scratch) noexcept {
+  int n = polygon.size();
+  triangles.clear();
+  // ^ Keeps its capacity (since Qt 5.7), so reusing one doesn't allocate
+  if (n < 3)
+    return;
+
+  triangles.reserve((n - 2) * 3);
+  scratch.reserve(n * (sizeof(EarNode) + sizeof(GridEntry) + 6 * sizeof(int)));
+  // ^ A node, at most one grid entry, about two cells, and three queue slots
+  // per vertex
+  EarClipper(polygon, scratch).clip(triangles);
 }
 }
@@ -1,15 +1,19 @@
 #ifndef UTILITY_HPP
 #define UTILITY_HPP
 
+#include <cstddef>
 #include <cstdint>
 
+class FrameArena;
 class QPoint;
+class QPointF;
 class QPolygonF;
 template <class T, class U> struct QPair;
 template <class T> class QVector;
 
 namespace jtg {
 using std::uint16_t;
+using std::uint32_t;
 
 template <class T>
 T map(T x, T in_min, T in_max, T out_min, T out_max) noexcept {
@@ -33,8 +37,38 @@ template <class T> T sign(T in) noexcept {
  */
 bool isSimplePolygon(const QPolygonF &polygon) noexcept;
 
-QPair<QVector<float>, QVector<uint16_t>>
+/**
+ * @brief segmentsIntersect
+ * @param adjacent Whether ab and cd are neighboring edges of a polygon (and so
+ * share exactly one endpoint)
+ * @return True if segment ab touches or crosses segment cd; adjacent edges only
+ * count if they overlap beyond their shared endpoint
+ */
+bool segmentsIntersect(const QPointF &a, const QPointF &b, const QPointF &c,
+                       const QPointF &d, const bool adjacent) noexcept;
+
+/**
+ * Hashes points by value, for unordered containers of vertices
+ */
+struct PointHash {
+  std::size_t operator()(const QPointF &p) const noexcept;
+};
+
+/**
+ * @brief decomposePolygon Triangulates a simple polygon by ear clipping
+ * @param polygon
+ * @return A vertex buffer and an index buffer for drawing polygon's interior
+ * with GL_TRIANGLES
+ */
+QPair<QVector<float>, QVector<uint32_t>>
 decomposePolygon(const QPolygonF &polygon) noexcept;
+
+/**
+ * Just the index buffer, into triangles (replacing whatever's there), with all
+ * of the ear clipper's bookkeeping allocated from scratch
+ */
+void decomposePolygon(const QPolygonF &polygon, QVector<uint32_t> &triangles,
+                      FrameArena &scratch) noexcept;
 }
 
 #endif // UTILITY_HPP
@@ -0,0 +1,30 @@
+#-------------------------------------------------
+#
+# The Shapely editor itself
+#
+#-------------------------------------------------
+
+include(../shapely.pri)
+include(../core/core.pri)
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = Shapely
+TEMPLATE = app
+
+SOURCES += ../main.cpp \
+    ../ShapelyWidget.cpp \
+    ../ShapelyWindow.cpp \
+    ../DragCoalescer.cpp
+
+HEADERS += \
+    ../ShapelyWidget.hpp \
+    ../ShapelyWindow.hpp \
+    ../DragCoalescer.hpp
+
+FORMS    += ../shapely.ui
+
+RESOURCES += \
+    ../resources.qrc
+
+QMAKE_RESOURCE_FLAGS += --compress 9
@@ -0,0 +1,108 @@
+// Scaling benchmark for banded, multi-threaded scan-line fill.
+//
+// Fills a spiky star (so the bands are very uneven) into a large framebuffer
+// with 1, 2, ..., N threads, the same way Rasterizer::fill splits the
+// work, and checks that every thread count gives the single-threaded image.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QPoint>
+
+#include "Benchmarks.hpp"
+#include "renderer/EdgeTable.hpp"
+#include "renderer/FrameArena.hpp"
+#include "renderer/Framebuffer.hpp"
+#include "renderer/WorkerPool.hpp"
+
+constexpr int SIZE = 4096;
+constexpr int SPIKES = 2000;
+constexpr int MIN_BAND_ROWS = 32;
+constexpr int BANDS_PER_THREAD = 8;
+constexpr Framebuffer::Pixel COLOR = 0xff00ff00;
+
+static void fill(const EdgeTable &edges, Framebuffer &fb, WorkerPool &pool) {
+  int y0 = std::max(edges.yMin(), 0);
+  int y1 = std::min(edges.yMax(), fb.height());
+  int rows = y1 - y0;
+  fb.markRows(y0, y1);
+
+  int bands = std::min(pool.threadCount() * BANDS_PER_THREAD,
+                       rows / MIN_BAND_ROWS);
+  pool.run(bands, [&](const int i) {
+    edges.scan(y0 + rows * i / bands, y0 + rows * (i + 1) / bands,
+               [&](const EdgeTable::Span &s) {
+                 fb.fillSpanUntracked(s.y, s.x0, s.x1, COLOR);
+               });
+  });
+}
+
+int bandBench(const Options &, QJsonArray &results) {
+  using namespace std::chrono;
+
+  std::vector<QPoint> star;
+  for (int i = 0; i < SPIKES * 2; ++i) {
+    double r = (i % 2) ? SIZE * 0.49 : SIZE * 0.05;
+    double a = M_PI * i / SPIKES;
+    star.push_back(QPoint(SIZE / 2 + r * std::cos(a), SIZE / 2 + r * std::sin(a)));
+  }
+
+  EdgeTable edges;
+  for (int i = 0; i < static_cast<int>(star.size()); ++i) {
+    edges.addEdge(star[i], star[(i + 1) % star.size()]);
+  }
+  FrameArena scratch;
+  edges.build(scratch);
+
+  int cores = std::max<int>(std::thread::hardware_concurrency(), 1);
+  std::vector<Framebuffer::Pixel> reference;
+  double baseline = 0;
+  int failed = 0;
+
+  std::fprintf(stderr, "star, %d spikes, %dx%d:\n", SPIKES, SIZE, SIZE);
+  for (int threads = 1; threads <= cores; ++threads) {
+    WorkerPool pool(threads);
+    Framebuffer fb;
+    fb.resize(SIZE, SIZE);
+
+    fill(edges, fb, pool); // Warm up
+
+    int reps = 0;
+    steady_clock::time_point start = steady_clock::now();
+    double elapsed = 0;
+    do {
+      fill(edges, fb, pool);
+      ++reps;
+      elapsed = duration<double>(steady_clock::now() - start).count();
+    } while (elapsed < 0.5);
+
+    double ms = elapsed * 1000 / reps;
+    if (threads == 1) {
+      baseline = ms;
+      reference.assign(fb.data(), fb.data() + SIZE * SIZE);
+    }
+
+    bool same = std::equal(reference.begin(), reference.end(), fb.data());
+    failed |= !same;
+
+    std::fprintf(stderr, "  %2d threads %8.2f ms  %5.2fx  %s\n", threads, ms,
+                 baseline / ms, same ? "identical" : "MISMATCH");
+
+    QJsonObject result;
+    result["benchmark"] = "bands";
+    result["threads"] = threads;
+    result["iterations"] = reps;
+    result["seconds_per_iteration"] = ms / 1000;
+    result["speedup"] = baseline / ms;
+    result["identical"] = same;
+    results.append(result);
+  }
+
+  return failed;
+}
@@ -0,0 +1,23 @@
+#ifndef BENCHMARKS_HPP
+#define BENCHMARKS_HPP
+
+class QJsonArray;
+
+struct Options {
+  int maxVertices;
+  // ^ The largest generated polygon the kernel benchmarks will use
+};
+
+/**
+ * Each benchmark prints what it's doing to stderr and appends one JSON object
+ * per measurement to results.
+ *
+ * @return Nonzero if something gave the wrong answer
+ */
+int fillBench(const Options &, QJsonArray &results);
+int bandBench(const Options &, QJsonArray &results);
+int kernelBench(const Options &, QJsonArray &results);
+int historyBench(const Options &, QJsonArray &results);
+int simplicityBench(const Options &, QJsonArray &results);
+
+#endif // BENCHMARKS_HPP
@@ -0,0 +1,113 @@
+// Fill-rate micro-benchmark for the software rasterizer's span writers.
+//
+// Fills the spans of a disc into a framebuffer-sized buffer with each span
+// writer, next to the per-pixel push_back loop that the fill used before it
+// drew into a framebuffer, and reports pixels per second.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include "Benchmarks.hpp"
+#include "renderer/SpanFill.hpp"
+
+struct Span {
+  int y;
+  int x0;
+  int x1;
+};
+
+static std::vector<Span> disc(const int size) {
+  std::vector<Span> spans;
+  double r = size / 2.0;
+  for (int y = 0; y < size; ++y) {
+    double dy = y + 0.5 - r;
+    double half = std::sqrt(r * r - dy * dy);
+    spans.push_back(Span{y, int(r - half), int(r + half)});
+  }
+  return spans;
+}
+
+template <class F>
+static void measure(const char *name, const int size,
+                    const std::vector<Span> &spans, F fill,
+                    QJsonArray &results) {
+  using namespace std::chrono;
+
+  long long pixels = 0;
+  for (const Span &s : spans) {
+    pixels += s.x1 - s.x0;
+  }
+
+  fill(); // Warm up caches and page in the destination
+
+  int reps = 0;
+  steady_clock::time_point start = steady_clock::now();
+  double elapsed = 0;
+  do {
+    fill();
+    ++reps;
+    elapsed = duration<double>(steady_clock::now() - start).count();
+  } while (elapsed < 0.5);
+
+  double rate = pixels * reps / elapsed;
+  std::fprintf(stderr, "  %-10s %10.1f Mpixels/s\n", name, rate / 1e6);
+
+  QJsonObject result;
+  result["benchmark"] = "fill";
+  result["writer"] = name;
+  result["size"] = size;
+  result["iterations"] = reps;
+  result["seconds_per_iteration"] = elapsed / reps;
+  result["items_per_second"] = rate;
+  results.append(result);
+}
+
+int fillBench(const Options &, QJsonArray &results) {
+  const int sizes[] = {16, 256, 1024, 4096};
+
+  std::fprintf(stderr, "SSE2: %s, AVX2: %s\n", jtg::hasSSE2() ? "yes" : "no",
+               jtg::hasAVX2() ? "yes" : "no");
+
+  for (int size : sizes) {
+    std::vector<Span> spans = disc(size);
+    std::vector<std::uint32_t> fb(size * size);
+    std::vector<float> points;
+    const std::uint32_t color = 0xff00ff00;
+
+    std::fprintf(stderr, "disc, %dx%d:\n", size, size);
+
+    measure("push_back", size, spans, [&]() {
+      points.clear();
+      for (const Span &s : spans) {
+        for (int x = s.x0; x < s.x1; ++x) {
+          points.push_back(x);
+          points.push_back(s.y);
+        }
+      }
+    }, results);
+
+    auto writer = [&](jtg::SpanFiller f) {
+      return [&, f]() {
+        for (const Span &s : spans) {
+          f(fb.data() + s.y * size + s.x0, s.x1 - s.x0, color);
+        }
+      };
+    };
+
+    measure("scalar", size, spans, writer(jtg::fillSpanScalar), results);
+#ifdef JTG_HAS_X86_SPAN_FILL
+    if (jtg::hasSSE2())
+      measure("sse2", size, spans, writer(jtg::fillSpanSSE2), results);
+    if (jtg::hasAVX2())
+      measure("avx2", size, spans, writer(jtg::fillSpanAVX2), results);
+#endif
+  }
+
+  return 0;
+}
@@ -0,0 +1,419 @@
+// Round-trip check and benchmark for undo and redo.
+//
+// Plays a long, randomly generated (but fixed) script of edits on a few
+// models, the way the editor makes them: inserting a vertex and dragging it
+// into place, dragging and deleting vertices, transforming, and adding and
+// removing models.  Each is recorded in an EditHistory.  Then everything is
+// undone and redone, and every model is checked against what it was at each
+// step.  The same script against a small budget checks that trimming only
+// forgets the oldest edits.  Finally, times undoing and redoing one edit of
+// each kind at 10, 100, ..., 1M vertices.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QPointF>
+#include <QPolygonF>
+#include <QSharedPointer>
+#include <QTransform>
+
+#include "Benchmarks.hpp"
+#include "Shapes.hpp"
+#include "Utility.hpp"
+#include "model/EditHistory.hpp"
+#include "model/ShapelyModel.hpp"
+
+constexpr unsigned SEED = 1729;
+constexpr int STEPS = 2000;
+constexpr int MODELS = 3;
+constexpr int VERTICES = 64;
+// ^ Of each model the script starts with or adds
+constexpr int DRAG_MOVES = 4;
+constexpr int TRANSFORM_STEPS = 3;
+constexpr std::size_t SMALL_BUDGET = 256 * sizeof(EditHistory::Edit);
+// ^ Small enough that the script overflows it many times over
+constexpr double MIN_SECONDS = 0.25;
+constexpr double MAX_SECONDS = 1;
+// ^ Don't try bigger polygons once an undo and redo take this long
+
+typedef QSharedPointer<ShapelyModel> ModelPtr;
+typedef std::vector<ModelPtr> List;
+// ^ Stands in for ShapelyWindow's list of polygons
+
+/**
+ * What every model in the list looked like at some point in the script.
+ */
+struct State {
+  List list;
+  std::vector<QPolygonF> polygons;
+  std::vector<QTransform> transforms;
+};
+
+static State capture(const List &list) {
+  State state;
+  state.list = list;
+  for (const ModelPtr &model : list) {
+    state.polygons.push_back(model->polygon);
+    state.transforms.push_back(model->transform);
+  }
+  return state;
+}
+
+/**
+ * @return Whether the list is as it was in state, including each model's
+ * simplicity, which undo and redo keep up to date vertex by vertex
+ */
+static bool matches(const State &state, const List &list) {
+  if (state.list != list)
+    return false;
+
+  for (std::size_t i = 0; i < list.size(); ++i) {
+    const ShapelyModel &model = *list[i];
+    if (model.polygon != state.polygons[i] ||
+        model.transform != state.transforms[i] ||
+        model.simplicity.size() != model.polygon.size() ||
+        model.simplicity.isSimple() != jtg::isSimplePolygon(model.polygon)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static ModelPtr makeModel(const QPolygonF &polygon) {
+  ModelPtr model = ModelPtr::create();
+  model->setPolygon(polygon);
+  return model;
+}
+
+/**
+ * Adds or removes the model, as ShapelyWindow::_showEdit() does; the history
+ * has already applied every other kind of edit.
+ */
+static void show(const EditHistory::Edit &edit, const bool undone,
+                 List &list) {
+  if (edit.kind != EditHistory::AddModel &&
+      edit.kind != EditHistory::RemoveModel)
+    return;
+
+  if ((edit.kind == EditHistory::AddModel) != undone) {
+    int row = std::min<int>(edit.index, list.size());
+    list.insert(list.begin() + row, edit.model);
+  } else {
+    list.erase(std::find(list.begin(), list.end(), edit.model));
+  }
+}
+
+/**
+ * Makes one edit the way ShapelyWidget and ShapelyWindow do, and records it.
+ * Drags are sealed when they're done, but transforms are left open, so that
+ * consecutive ones of the same kind get merged.
+ */
+static void step(List &list, EditHistory &history, std::mt19937 &random) {
+  std::uniform_real_distribution<double> coordinate(-1, 1);
+  std::uniform_real_distribution<double> factor(0.5, 2);
+  auto pick = [&random](const int n) {
+    return std::uniform_int_distribution<int>(0, n - 1)(random);
+  };
+  auto point = [&]() {
+    return QPointF(coordinate(random), coordinate(random));
+  };
+  auto drag = [&](const ModelPtr &model, const int index) {
+    for (int i = 0; i < DRAG_MOVES; ++i) {
+      QPointF from = model->polygon[index];
+      model->moveVertex(index, point());
+      history.moveVertex(model, index, from);
+    }
+    history.seal();
+  };
+
+  ModelPtr model = list.empty() ? ModelPtr() : list[pick(list.size())];
+  int n = model ? model->polygon.size() : 0;
+
+  int choice = model ? pick(6) : 5;
+  if (choice == 4 && list.size() < 2) {
+    choice = 5;
+  }
+  // ^ Always leave something to edit
+
+  switch (choice) {
+  case 0: {
+    int index = pick(n + 1);
+    model->insertVertex(index, point());
+    history.insertVertex(model, index);
+    drag(model, index);
+    break;
+  }
+  case 1:
+    drag(model, pick(n));
+    break;
+  case 2:
+    if (n > 3) {
+      int index = pick(n);
+      QPointF removed = model->polygon[index];
+      model->removeVertex(index);
+      history.removeVertex(model, index, removed);
+    } else {
+      drag(model, pick(n));
+    }
+    break;
+  case 3: {
+    auto kind = static_cast<EditHistory::TransformKind>(
+        pick(EditHistory::Reflect + 1));
+    int times = kind == EditHistory::Reflect ? 1 : 1 + pick(TRANSFORM_STEPS);
+    for (; times > 0; --times) {
+      QTransform from = model->transform;
+      switch (kind) {
+      case EditHistory::Translate:
+        model->transform.translate(coordinate(random), coordinate(random));
+        break;
+      case EditHistory::Rotate:
+        model->transform.rotateRadians(coordinate(random));
+        break;
+      case EditHistory::Scale:
+        model->transform.scale(factor(random), factor(random));
+        break;
+      case EditHistory::Shear:
+        model->transform.shear(coordinate(random), coordinate(random));
+        break;
+      case EditHistory::Reflect:
+        model->transform *= QTransform(-1, 0, 0, 1, 0, 0);
+        break;
+      }
+      history.transform(model, from, kind);
+    }
+    // ^ Like clicking a spin box's arrow a few times; those are one edit,
+    // but each reflection is an edit of its own
+    break;
+  }
+  case 4: {
+    int row = pick(list.size());
+    ModelPtr removed = list[row];
+    list.erase(list.begin() + row);
+    history.removeModel(removed, row);
+    break;
+  }
+  case 5: {
+    int row = pick(list.size() + 1);
+    ModelPtr added = makeModel(SHAPES[pick(SHAPE_COUNT)].make(VERTICES));
+    list.insert(list.begin() + row, added);
+    history.addModel(added, row);
+    break;
+  }
+  }
+}
+
+static List startingList() {
+  List list;
+  for (int i = 0; i < MODELS; ++i) {
+    list.push_back(makeModel(SHAPES[i % SHAPE_COUNT].make(VERTICES)));
+  }
+  return list;
+}
+
+/**
+ * Undoes the last count edits, checking the list against the states before
+ * each, then redoes them, checking it against the states after.
+ *
+ * @param states What the list was after each edit still in the history, and
+ * before the first of them
+ * @return Number of mismatches
+ */
+static int roundTrip(EditHistory &history, List &list,
+                     const std::vector<State> &states, const int count) {
+  int failed = 0;
+  int last = states.size() - 1;
+
+  for (int i = 0; i < count; ++i) {
+    const EditHistory::Edit *edit = history.undo();
+    if (!edit) {
+      ++failed;
+      break;
+    }
+    show(*edit, true, list);
+    failed += !matches(states[last - i - 1], list);
+  }
+
+  for (int i = count; i > 0; --i) {
+    const EditHistory::Edit *edit = history.redo();
+    if (!edit) {
+      ++failed;
+      break;
+    }
+    show(*edit, false, list);
+    failed += !matches(states[last - i + 1], list);
+  }
+
+  return failed;
+}
+
+/**
+ * Plays the script into a history with the default budget, then undoes and
+ * redoes all of it; then undoes half, makes a new edit (which should forget
+ * the rest), and round-trips that.
+ */
+static int checkRoundTrip() {
+  std::mt19937 random(SEED);
+  List list = startingList();
+  EditHistory history;
+  std::vector<State> states{capture(list)};
+
+  for (int i = 0; i < STEPS; ++i) {
+    step(list, history, random);
+    if (history.size() + 1 > states.size()) {
+      states.push_back(capture(list));
+    } else {
+      states.back() = capture(list);
+      // ^ Merged into the last edit, so that's what undoing it goes back from
+    }
+  }
+
+  int edits = history.size();
+  int failed = roundTrip(history, list, states, edits);
+  failed += history.canRedo();
+
+  int half = edits / 2;
+  for (int i = 0; i < half; ++i) {
+    show(*history.undo(), true, list);
+  }
+  states.resize(states.size() - half);
+  step(list, history, random);
+  history.seal();
+  states.push_back(capture(list));
+  failed += history.canRedo() || history.size() != states.size() - 1;
+  failed += roundTrip(history, list, states, history.size());
+
+  std::fprintf(stderr, "  %d steps, %d edits: %s\n", STEPS, edits,
+               failed ? "MISMATCH" : "round-trip");
+  return failed;
+}
+
+/**
+ * Plays the script into a history with a small budget, sealing after every
+ * step so that each is one edit, then undoes everything it still has.  That
+ * should lead back to the state after the edits it forgot.
+ */
+static int checkBudget() {
+  std::mt19937 random(SEED);
+  List list = startingList();
+  EditHistory history(SMALL_BUDGET);
+  std::vector<State> states{capture(list)};
+
+  for (int i = 0; i < STEPS; ++i) {
+    step(list, history, random);
+    history.seal();
+    states.push_back(capture(list));
+  }
+
+  int kept = history.size();
+  int failed = history.bytes() > history.budget() || kept >= STEPS;
+  failed += roundTrip(history, list, states, kept);
+  for (int i = 0; i < kept; ++i) {
+    show(*history.undo(), true, list);
+  }
+  failed += history.canUndo() || !matches(states[STEPS - kept], list);
+
+  std::fprintf(stderr, "  %zu byte budget: kept %d of %d edits: %s\n",
+               history.budget(), kept, STEPS, failed ? "MISMATCH" : "trimmed");
+  return failed;
+}
+
+struct Timed {
+  const char *name;
+  void (*make)(const ModelPtr &, EditHistory &);
+  // ^ Makes and records the edit that'll be undone and redone
+};
+
+static void timedMove(const ModelPtr &model, EditHistory &history) {
+  int index = model->polygon.size() / 2;
+  QPointF from = model->polygon[index];
+  model->moveVertex(index, (from + model->polygon[index + 1]) / 2);
+  history.moveVertex(model, index, from);
+}
+// ^ Not far, relative to the edges, as when dragging; how long the moved edges
+// are decides how many of SimplicityTracker's grid cells they're checked in
+
+static void timedInsert(const ModelPtr &model, EditHistory &history) {
+  int index = model->polygon.size() / 2;
+  model->insertVertex(index, model->polygon[index] * 0.5);
+  history.insertVertex(model, index);
+}
+
+static void timedRemove(const ModelPtr &model, EditHistory &history) {
+  int index = model->polygon.size() / 2;
+  QPointF removed = model->polygon[index];
+  model->removeVertex(index);
+  history.removeVertex(model, index, removed);
+}
+
+static void timedTransform(const ModelPtr &model, EditHistory &history) {
+  QTransform from = model->transform;
+  model->transform.rotateRadians(1);
+  history.transform(model, from, EditHistory::Rotate);
+}
+
+const Timed TIMED[] = {{"move", timedMove},
+                       {"transform", timedTransform},
+                       {"insert", timedInsert},
+                       {"remove", timedRemove}};
+
+/**
+ * @return Seconds per undo and redo
+ */
+static double measure(EditHistory &history, int &reps) {
+  using namespace std::chrono;
+
+  reps = 0;
+  steady_clock::time_point start = steady_clock::now();
+  double elapsed = 0;
+  do {
+    history.undo();
+    history.redo();
+    ++reps;
+    elapsed = duration<double>(steady_clock::now() - start).count();
+  } while (elapsed < MIN_SECONDS);
+
+  return elapsed / reps;
+}
+
+int historyBench(const Options &options, QJsonArray &results) {
+  int failed = 0;
+
+  std::fprintf(stderr, "round trips:\n");
+  failed |= checkRoundTrip();
+  failed |= checkBudget();
+
+  for (const Timed &timed : TIMED) {
+    std::fprintf(stderr, "%s:\n", timed.name);
+
+    for (int n = 10; n <= options.maxVertices; n *= 10) {
+      ModelPtr model = makeModel(SHAPES[0].make(n));
+      EditHistory history;
+      timed.make(model, history);
+
+      int reps = 0;
+      double seconds = measure(history, reps);
+
+      QJsonObject result;
+      result["benchmark"] = "history";
+      result["edit"] = timed.name;
+      result["vertices"] = model->polygon.size();
+      result["iterations"] = reps;
+      result["seconds_per_iteration"] = seconds;
+      results.append(result);
+
+      std::fprintf(stderr, "  %8d vertices %12.3f us per undo and redo\n",
+                   model->polygon.size(), seconds * 1e6);
+      if (seconds > MAX_SECONDS)
+        break;
+    }
+  }
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,201 @@
+// Benchmarks for the geometry and rasterization kernels.
+//
+// Runs each kernel on every generated shape at 10, 100, ..., 1M vertices and
+// records the time per call.  Kernels that get too slow on some shape (e.g.
+// ear clipping a big comb) are skipped at the sizes after that, and the skip
+// is recorded too, so a regression shows up either way.
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QPoint>
+#include <QPolygonF>
+#include <QRectF>
+
+#include "Benchmarks.hpp"
+#include "Shapes.hpp"
+#include "Utility.hpp"
+#include "geometry/VertexIndex.hpp"
+#include "renderer/Rasterizer.hpp"
+
+constexpr int SIZE = 1024;
+// ^ Width and height of the framebuffer the rasterizer kernels draw into
+constexpr double MIN_SECONDS = 0.25;
+constexpr double MAX_SECONDS = 5;
+// ^ Don't try bigger inputs once a single call takes this long
+constexpr int QUERIES = 1000;
+constexpr double QUERY_SIZE = 0.02;
+// ^ Side of a hit-test rectangle, relative to the shape; about a vertex
+// marker on a full-screen polygon
+constexpr double ZOOM = 64;
+// ^ How far the "zoomed" kernel magnifies the shape, so that most of it is off
+// the framebuffer
+constexpr unsigned SEED = 328;
+constexpr Framebuffer::Pixel COLOR = 0xff00ff00;
+
+struct Kernel {
+  const char *name;
+  std::function<void()> (*prepare)(const QPolygonF &);
+  // ^ Does the setup that shouldn't be timed, returns the call that should be
+  int itemsPerCall;
+  // ^ Zero means one item per vertex
+};
+
+static std::vector<QPoint> toPixels(const QPolygonF &polygon) {
+  std::vector<QPoint> pixels;
+  pixels.reserve(polygon.size());
+  for (const QPointF &p : polygon) {
+    pixels.push_back(QPoint((p.x() + 1) * 0.5 * (SIZE - 1),
+                            (p.y() + 1) * 0.5 * (SIZE - 1)));
+  }
+  return pixels;
+}
+
+static std::function<void()> simplicity(const QPolygonF &polygon) {
+  return [polygon]() { jtg::isSimplePolygon(polygon); };
+}
+
+static std::function<void()> triangulate(const QPolygonF &polygon) {
+  return [polygon]() { jtg::decomposePolygon(polygon); };
+}
+
+static std::function<void()> lines(const QPolygonF &polygon) {
+  auto rasterizer = std::make_shared<Rasterizer>();
+  rasterizer->framebuffer().resize(SIZE, SIZE);
+  std::vector<QPoint> pixels = toPixels(polygon);
+  return [rasterizer, pixels]() { rasterizer->drawOutline(pixels, COLOR); };
+}
+
+static std::function<void()> scanfill(const QPolygonF &polygon) {
+  auto rasterizer = std::make_shared<Rasterizer>();
+  rasterizer->framebuffer().resize(SIZE, SIZE);
+  std::vector<QPoint> pixels = toPixels(polygon);
+  return [rasterizer, pixels]() { rasterizer->fill(pixels, COLOR); };
+}
+
+static std::function<void()> zoomed(const QPolygonF &polygon) {
+  auto rasterizer = std::make_shared<Rasterizer>();
+  rasterizer->framebuffer().resize(SIZE, SIZE);
+  std::vector<QPointF> points;
+  points.reserve(polygon.size());
+  for (const QPointF &p : polygon) {
+    points.push_back(QPointF((p.x() * ZOOM + 1) * 0.5 * SIZE,
+                             (p.y() * ZOOM + 1) * 0.5 * SIZE));
+  }
+
+  return [rasterizer, points]() {
+    rasterizer->fill(points, COLOR);
+    rasterizer->drawOutline(points, COLOR);
+  };
+}
+
+static std::function<void()> hittest(const QPolygonF &polygon) {
+  auto index = std::make_shared<VertexIndex>();
+  index->reset(polygon);
+
+  std::mt19937 random(SEED);
+  std::uniform_real_distribution<double> coordinate(-1, 1 - QUERY_SIZE);
+  std::vector<QRectF> rects;
+  for (int i = 0; i < QUERIES; ++i) {
+    rects.push_back(QRectF(coordinate(random), coordinate(random), QUERY_SIZE,
+                           QUERY_SIZE));
+  }
+
+  return [index, rects]() {
+    volatile int found = 0;
+    for (const QRectF &rect : rects) {
+      index->query(rect, [&found](const int) { found = found + 1; });
+    }
+  };
+}
+
+static std::function<void()> indexing(const QPolygonF &polygon) {
+  return [polygon]() {
+    VertexIndex index;
+    index.reset(polygon);
+  };
+}
+
+const Kernel KERNELS[] = {{"simplicity", simplicity, 0},
+                          {"triangulate", triangulate, 0},
+                          {"lines", lines, 0},
+                          {"scanfill", scanfill, 0},
+                          {"zoomed", zoomed, 0},
+                          {"index", indexing, 0},
+                          {"hittest", hittest, QUERIES}};
+
+/**
+ * @return Seconds per call
+ */
+static double measure(const std::function<void()> &call, int &reps) {
+  using namespace std::chrono;
+
+  steady_clock::time_point start = steady_clock::now();
+  call(); // Warm up
+  double elapsed = duration<double>(steady_clock::now() - start).count();
+  if (elapsed >= MIN_SECONDS) {
+    reps = 1;
+    return elapsed;
+  }
+  // ^ If it's that slow, once is plenty
+
+  reps = 0;
+  start = steady_clock::now();
+  do {
+    call();
+    ++reps;
+    elapsed = duration<double>(steady_clock::now() - start).count();
+  } while (elapsed < MIN_SECONDS);
+
+  return elapsed / reps;
+}
+
+int kernelBench(const Options &options, QJsonArray &results) {
+  for (const Kernel &kernel : KERNELS) {
+    std::fprintf(stderr, "%s:\n", kernel.name);
+
+    for (int s = 0; s < SHAPE_COUNT; ++s) {
+      const Shape &shape = SHAPES[s];
+      bool tooSlow = false;
+
+      for (int n = 10; n <= options.maxVertices; n *= 10) {
+        QPolygonF polygon = shape.make(n);
+        int vertices = polygon.size();
+
+        QJsonObject result;
+        result["benchmark"] = "kernel";
+        result["kernel"] = kernel.name;
+        result["shape"] = shape.name;
+        result["vertices"] = vertices;
+
+        if (tooSlow) {
+          result["skipped"] = true;
+          results.append(result);
+          continue;
+        }
+
+        int reps = 0;
+        double seconds = measure(kernel.prepare(polygon), reps);
+        int items = kernel.itemsPerCall ? kernel.itemsPerCall : vertices;
+        tooSlow = seconds > MAX_SECONDS;
+
+        result["iterations"] = reps;
+        result["seconds_per_iteration"] = seconds;
+        result["items_per_second"] = items / seconds;
+        results.append(result);
+
+        std::fprintf(stderr, "  %-8s %8d vertices %12.3f us  %10.2f Mitems/s\n",
+                     shape.name, vertices, seconds * 1e6,
+                     items / seconds / 1e6);
+      }
+    }
+  }
+
+  return 0;
+}
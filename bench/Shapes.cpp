@@ -0,0 +1,114 @@
+#include "Shapes.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include <QPointF>
+
+constexpr unsigned SEED = 328;
+constexpr int POINTS_PER_TURN = 16;
+// ^ At least; any fewer and a spiral's arms can cut across each other
+
+/**
+ * A regular n-gon; convex, so the easy case for everything.
+ */
+static QPolygonF regular(const int n) {
+  QPolygonF polygon;
+  polygon.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    double a = 2 * M_PI * i / n;
+    polygon.append(QPointF(std::cos(a), std::sin(a)));
+  }
+  return polygon;
+}
+
+/**
+ * A star with n / 2 long, thin spikes; every other vertex is reflex.
+ */
+static QPolygonF star(const int n) {
+  QPolygonF polygon;
+  polygon.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    double r = (i % 2) ? 1 : 0.3;
+    double a = 2 * M_PI * i / n;
+    polygon.append(QPointF(r * std::cos(a), r * std::sin(a)));
+  }
+  return polygon;
+}
+
+/**
+ * A band wound into an Archimedean spiral; long, narrow, and its bounding box
+ * covers everything, so grids don't help much.
+ */
+static QPolygonF spiral(const int n) {
+  int arm = std::max(n / 2, 2);
+  int turns = std::max(1, std::min(arm / POINTS_PER_TURN, 64));
+  double end = M_PI + 2 * M_PI * turns;
+  double b = 1 / (end + M_PI);
+  // ^ So the outermost point is at radius 1
+
+  QPolygonF polygon;
+  polygon.reserve(arm * 2);
+  for (int i = 0; i < arm; ++i) {
+    double a = M_PI + (end - M_PI) * i / (arm - 1);
+    double r = b * (a + M_PI);
+    polygon.append(QPointF(r * std::cos(a), r * std::sin(a)));
+  }
+  for (int i = arm - 1; i >= 0; --i) {
+    double a = M_PI + (end - M_PI) * i / (arm - 1);
+    double r = b * a;
+    polygon.append(QPointF(r * std::cos(a), r * std::sin(a)));
+  }
+  // ^ Out along one edge of the band and back along the other, half a turn's
+  // spacing inside it
+  return polygon;
+}
+
+/**
+ * A random walk in radius as the angle goes once around, so it's star-shaped
+ * (and therefore simple) but irregular.
+ */
+static QPolygonF walk(const int n) {
+  std::mt19937 random(SEED);
+  std::normal_distribution<double> step(0, 2.0 / std::sqrt(n));
+
+  QPolygonF polygon;
+  polygon.reserve(n);
+  double r = 0.6;
+  for (int i = 0; i < n; ++i) {
+    r = std::max(0.2, std::min(r + step(random), 1.0));
+    double a = 2 * M_PI * i / n;
+    polygon.append(QPointF(r * std::cos(a), r * std::sin(a)));
+  }
+  return polygon;
+}
+
+/**
+ * A comb with (n - 2) / 4 teeth; lots of reflex vertices lined up in a row,
+ * the worst case for ear clipping.
+ */
+static QPolygonF comb(const int n) {
+  int teeth = std::max((n - 2) / 4, 1);
+  double w = 2.0 / teeth;
+
+  QPolygonF polygon;
+  polygon.reserve(teeth * 4 + 2);
+  polygon.append(QPointF(-1, -1));
+  polygon.append(QPointF(1, -1));
+  for (int t = teeth - 1; t >= 0; --t) {
+    double x = -1 + t * w;
+    polygon.append(QPointF(x + w, -0.8));
+    polygon.append(QPointF(x + w / 2, -0.8));
+    polygon.append(QPointF(x + w / 2, 1));
+    polygon.append(QPointF(x, 1));
+  }
+  return polygon;
+}
+
+const Shape SHAPES[] = {{"regular", regular},
+                        {"star", star},
+                        {"spiral", spiral},
+                        {"walk", walk},
+                        {"comb", comb}};
+const int SHAPE_COUNT = sizeof(SHAPES) / sizeof(SHAPES[0]);
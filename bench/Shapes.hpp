@@ -0,0 +1,18 @@
+#ifndef SHAPES_HPP
+#define SHAPES_HPP
+
+#include <QPolygonF>
+
+/**
+ * Simple polygons with about n vertices, for benchmarking.  Each fits in the
+ * square [-1, 1] x [-1, 1] and is the same every run.
+ */
+struct Shape {
+  const char *name;
+  QPolygonF (*make)(const int n);
+};
+
+extern const Shape SHAPES[];
+extern const int SHAPE_COUNT;
+
+#endif // SHAPES_HPP
@@ -0,0 +1,214 @@
+// Cross-check of jtg::isSimplePolygon's sweep against brute force.
+//
+// Tests every pair of edges of many small random polygons, some with vertices
+// anywhere and some on a small integer grid (so that collinear, touching and
+// repeated vertices are common), half of them with their vertices sorted by
+// angle so that they're mostly simple, and of every generated shape, plain and
+// with two vertices swapped across it.  Any polygon where the sweep and brute
+// force disagree is a failure; the kernels benchmark times the sweep itself.
+//
+// Then checks that every level of detail LevelOfDetail::selectSimple() picks
+// for the simple shapes, from a millionth of their size up, is simple too.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QPointF>
+#include <QPolygonF>
+#include <QRectF>
+
+#include "Benchmarks.hpp"
+#include "Shapes.hpp"
+#include "Utility.hpp"
+#include "geometry/LevelOfDetail.hpp"
+#include "renderer/FrameArena.hpp"
+
+constexpr unsigned SEED = 6;
+constexpr int POLYGONS = 20000;
+// ^ Of each kind of random polygon
+constexpr int MAX_VERTICES = 40;
+constexpr int GRID = 6;
+// ^ Width and height of the grid that degenerate polygons' vertices are on
+constexpr int SHAPE_VERTICES = 1000;
+// ^ The largest generated shapes to check; brute force is O(n^2)
+constexpr int LOD_VERTICES = 10000;
+// ^ The largest shapes whose levels of detail are checked, unless
+// --max-vertices is smaller
+constexpr double FINEST = 1e-6;
+// ^ The smallest tolerance checked, relative to the shape's size
+constexpr int SHOWN = 3;
+// ^ Disagreements to print in full
+
+/**
+ * The definition isSimplePolygon() has to agree with: no repeated vertices,
+ * and no two edges that touch (or, for neighboring ones, overlap) anywhere
+ * else.  Fewer than three vertices aren't a polygon, and three always are.
+ */
+static bool bruteForce(const QPolygonF &polygon) {
+  int n = polygon.size();
+  if (n < 3)
+    return false;
+
+  if (n == 3)
+    return true;
+
+  for (int i = 0; i < n; ++i) {
+    for (int j = i + 1; j < n; ++j) {
+      if (polygon[i] == polygon[j])
+        return false;
+
+      bool adjacent = j == i + 1 || (i == 0 && j == n - 1);
+      if (jtg::segmentsIntersect(polygon[i], polygon[(i + 1) % n], polygon[j],
+                                 polygon[(j + 1) % n], adjacent)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Sorts the vertices by angle around a point, which makes the polygon
+ * star-shaped, and so simple unless vertices repeat or line up with it.
+ */
+static void sortAround(QPolygonF &polygon, const QPointF &center) {
+  std::sort(polygon.begin(), polygon.end(),
+            [&center](const QPointF &a, const QPointF &b) {
+              return std::atan2(a.y() - center.y(), a.x() - center.x()) <
+                     std::atan2(b.y() - center.y(), b.x() - center.x());
+            });
+}
+
+/**
+ * @return 1 if the sweep disagrees with brute force on the polygon, else 0
+ */
+static int check(const char *kind, const QPolygonF &polygon, int &shown) {
+  bool sweep = jtg::isSimplePolygon(polygon);
+  if (sweep == bruteForce(polygon))
+    return 0;
+
+  if (shown++ < SHOWN) {
+    std::fprintf(stderr, "  %s polygon: sweep says %s, brute force doesn't:",
+                 kind, sweep ? "simple" : "not simple");
+    for (const QPointF &p : polygon) {
+      std::fprintf(stderr, " (%.17g, %.17g)", p.x(), p.y());
+    }
+    std::fprintf(stderr, "\n");
+  }
+  return 1;
+}
+
+int simplicityBench(const Options &options, QJsonArray &results) {
+  std::mt19937 random(SEED);
+  std::uniform_int_distribution<int> vertices(3, MAX_VERTICES);
+  std::uniform_real_distribution<double> anywhere(-1, 1);
+  std::uniform_int_distribution<int> onGrid(0, GRID - 1);
+
+  struct {
+    const char *kind;
+    int polygons;
+    int simple;
+    int disagreements;
+  } tally[] = {{"random", 0, 0, 0},
+               {"grid", 0, 0, 0},
+               {"shape", 0, 0, 0},
+               {"lod", 0, 0, 0}};
+  int shown = 0;
+
+  for (int i = 0; i < POLYGONS; ++i) {
+    QPolygonF general;
+    QPolygonF degenerate;
+    for (int n = vertices(random); n > 0; --n) {
+      general.append(QPointF(anywhere(random), anywhere(random)));
+      degenerate.append(QPointF(onGrid(random), onGrid(random)));
+    }
+
+    if (i % 2 != 0) {
+      sortAround(general, QPointF(0, 0));
+      sortAround(degenerate, QPointF(GRID / 2.0, GRID / 2.0));
+    }
+
+    const QPolygonF *polygons[] = {&general, &degenerate};
+    for (int k = 0; k < 2; ++k) {
+      ++tally[k].polygons;
+      tally[k].simple += bruteForce(*polygons[k]);
+      tally[k].disagreements += check(tally[k].kind, *polygons[k], shown);
+    }
+  }
+
+  for (int s = 0; s < SHAPE_COUNT; ++s) {
+    for (int n = 10; n <= SHAPE_VERTICES; n *= 10) {
+      QPolygonF shape = SHAPES[s].make(n);
+      QPolygonF crossed = shape;
+      std::swap(crossed[0], crossed[crossed.size() / 2]);
+      // ^ Its neighbors' edges now reach across the shape to it
+
+      for (const QPolygonF *polygon : {&shape, &crossed}) {
+        ++tally[2].polygons;
+        tally[2].simple += bruteForce(*polygon);
+        tally[2].disagreements += check("shape", *polygon, shown);
+      }
+    }
+  }
+
+  LevelOfDetail lod;
+  FrameArena scratch;
+  std::vector<int> kept;
+  QPolygonF selection;
+  for (int s = 0; s < SHAPE_COUNT; ++s) {
+    for (int n = 100; n <= std::min(LOD_VERTICES, options.maxVertices);
+         n *= 10) {
+      QPolygonF shape = SHAPES[s].make(n);
+      if (!jtg::isSimplePolygon(shape))
+        continue;
+
+      scratch.reset();
+      lod.rank(shape, n, scratch);
+      QRectF bounds = shape.boundingRect();
+      double size = std::max(bounds.width(), bounds.height());
+
+      for (double t = size * FINEST; t < size; t *= 2) {
+        lod.selectSimple(shape, t, kept);
+        selection.clear();
+        for (int i : kept) {
+          selection.append(shape[i]);
+        }
+        // ^ Empty means every vertex, which is simple
+
+        bool simple = kept.empty() || jtg::isSimplePolygon(selection);
+        ++tally[3].polygons;
+        tally[3].simple += simple;
+        if (!simple && shown++ < SHOWN) {
+          std::fprintf(stderr, "  %s, %d vertices: the %d kept at %g cross\n",
+                       SHAPES[s].name, n, selection.size(), t);
+        }
+        tally[3].disagreements += !simple;
+      }
+    }
+  }
+
+  int failed = 0;
+  for (const auto &t : tally) {
+    std::fprintf(stderr, "  %-6s %6d polygons, %6d simple: %d disagreements\n",
+                 t.kind, t.polygons, t.simple, t.disagreements);
+
+    QJsonObject result;
+    result["benchmark"] = "simplicity";
+    result["polygons"] = t.kind;
+    result["count"] = t.polygons;
+    result["simple"] = t.simple;
+    result["disagreements"] = t.disagreements;
+    results.append(result);
+
+    failed |= t.disagreements != 0;
+  }
+
+  return failed;
+}
@@ -0,0 +1,27 @@
+#-------------------------------------------------
+#
+# Benchmarks for the geometry and rasterization kernels; prints JSON
+#
+#-------------------------------------------------
+
+include(../shapely.pri)
+include(../core/core.pri)
+
+TARGET = ShapelyBench
+TEMPLATE = app
+
+CONFIG += console
+CONFIG -= app_bundle
+QMAKE_CXXFLAGS += -O2
+
+SOURCES += main.cpp \
+    FillBench.cpp \
+    BandBench.cpp \
+    KernelBench.cpp \
+    HistoryBench.cpp \
+    SimplicityBench.cpp \
+    Shapes.cpp
+
+HEADERS += \
+    Benchmarks.hpp \
+    Shapes.hpp
@@ -0,0 +1,64 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "Benchmarks.hpp"
+
+constexpr int MAX_VERTICES = 1000000;
+constexpr char MAX_VERTICES_FLAG[] = "--max-vertices=";
+
+struct Benchmark {
+  const char *name;
+  int (*run)(const Options &, QJsonArray &);
+};
+
+const Benchmark BENCHMARKS[] = {{"fill", fillBench},
+                                {"bands", bandBench},
+                                {"kernels", kernelBench},
+                                {"history", historyBench},
+                                {"simplicity", simplicityBench}};
+
+/**
+ * Prints the results of every benchmark named on the command line (or all of
+ * them) to stdout as one JSON document, for tracking regressions; progress
+ * goes to stderr.
+ */
+int main(int argc, char *argv[]) {
+  Options options{MAX_VERTICES};
+  const int flag = std::strlen(MAX_VERTICES_FLAG);
+  int named = 0;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strncmp(argv[i], MAX_VERTICES_FLAG, flag) == 0) {
+      options.maxVertices = std::atoi(argv[i] + flag);
+      argv[i] = nullptr;
+    } else {
+      ++named;
+    }
+  }
+
+  QJsonArray results;
+  int failed = 0;
+  for (const Benchmark &b : BENCHMARKS) {
+    bool wanted = named == 0;
+    for (int i = 1; i < argc; ++i) {
+      wanted |= argv[i] && std::strcmp(argv[i], b.name) == 0;
+    }
+    // No benchmarks named means run everything
+
+    if (wanted) {
+      std::fprintf(stderr, "== %s ==\n", b.name);
+      failed |= b.run(options, results);
+    }
+  }
+
+  QJsonObject document;
+  document["benchmarks"] = results;
+  document["failed"] = failed != 0;
+  std::fputs(QJsonDocument(document).toJson().constData(), stdout);
+
+  return failed;
+}
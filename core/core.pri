@@ -0,0 +1,11 @@
+# Links a subproject against the core library; include after shapely.pri
+
+win32:CONFIG(release, debug|release): CORE_DIR = $$OUT_PWD/../core/release
+else:win32:CONFIG(debug, debug|release): CORE_DIR = $$OUT_PWD/../core/debug
+else: CORE_DIR = $$OUT_PWD/../core
+
+LIBS += -L$$CORE_DIR -lShapelyCore
+
+win32-msvc*: PRE_TARGETDEPS += $$CORE_DIR/ShapelyCore.lib
+else: PRE_TARGETDEPS += $$CORE_DIR/libShapelyCore.a
+# ^ So the app relinks when the library changes
@@ -0,0 +1,75 @@
+#-------------------------------------------------
+#
+# Everything but the UI: models, geometry, and renderers
+#
+#-------------------------------------------------
+
+include(../shapely.pri)
+
+TARGET = ShapelyCore
+TEMPLATE = lib
+
+CONFIG += staticlib
+
+SOURCES += \
+    ../model/ShapelyModel.cpp \
+    ../model/SceneFile.cpp \
+    ../model/EditHistory.cpp \
+    ../renderer/ShaderRenderer.cpp \
+    ../exception/ShaderException.cpp \
+    ../exception/ShaderProgramException.cpp \
+    ../renderer/AbstractRenderer.cpp \
+    ../Constants.cpp \
+    ../renderer/MidpointRenderer.cpp \
+    ../renderer/Rasterizer.cpp \
+    ../renderer/FrameArena.cpp \
+    ../renderer/VertexStore.cpp \
+    ../renderer/EdgeTable.cpp \
+    ../renderer/Framebuffer.cpp \
+    ../renderer/SpanFill.cpp \
+    ../renderer/WorkerPool.cpp \
+    ../renderer/StreamBuffer.cpp \
+    ../renderer/GeometryPipeline.cpp \
+    ../renderer/SceneRenderer.cpp \
+    ../geometry/LevelOfDetail.cpp \
+    ../geometry/SimplicityTracker.cpp \
+    ../geometry/VertexIndex.cpp \
+    ../profiling/Profiler.cpp \
+    ../io/PolygonParser.cpp \
+    ../io/WktParser.cpp \
+    ../io/GeoJsonParser.cpp \
+    ../io/CsvParser.cpp \
+    ../io/Importer.cpp \
+    ../Utility.cpp
+
+HEADERS += \
+    ../model/ShapelyModel.hpp \
+    ../model/SceneFile.hpp \
+    ../model/EditHistory.hpp \
+    ../renderer/ShaderRenderer.hpp \
+    ../exception/ShaderException.hpp \
+    ../exception/ShaderProgramException.hpp \
+    ../renderer/AbstractRenderer.hpp \
+    ../Constants.hpp \
+    ../Utility.hpp \
+    ../renderer/MidpointRenderer.hpp \
+    ../renderer/Rasterizer.hpp \
+    ../renderer/FrameArena.hpp \
+    ../renderer/VertexStore.hpp \
+    ../renderer/EdgeTable.hpp \
+    ../renderer/Framebuffer.hpp \
+    ../renderer/SpanFill.hpp \
+    ../renderer/WorkerPool.hpp \
+    ../renderer/StreamBuffer.hpp \
+    ../renderer/GeometryPipeline.hpp \
+    ../renderer/SceneRenderer.hpp \
+    ../geometry/LevelOfDetail.hpp \
+    ../geometry/SimplicityTracker.hpp \
+    ../geometry/VertexIndex.hpp \
+    ../profiling/Profiler.hpp \
+    ../profiling/SampleRing.hpp \
+    ../io/PolygonParser.hpp \
+    ../io/WktParser.hpp \
+    ../io/GeoJsonParser.hpp \
+    ../io/CsvParser.hpp \
+    ../io/Importer.hpp
@@ -0,0 +1,218 @@
+#include "LevelOfDetail.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+#include <QMatrix4x4>
+#include <QPointF>
+#include <QPolygonF>
+#include <QSize>
+
+#include "Utility.hpp"
+#include "renderer/FrameArena.hpp"
+
+constexpr double ALWAYS = std::numeric_limits<double>::infinity();
+// ^ Importance of the last three vertices, which are never dropped
+constexpr int CANCEL_INTERVAL = 4096;
+// ^ Vertices dropped between checks for cancellation
+constexpr int MAX_REFINEMENTS = 8;
+// ^ Times selectSimple() halves the tolerance before it keeps every vertex
+
+namespace {
+struct Candidate {
+  double importance;
+  int vertex;
+  unsigned version;
+  // ^ Out of date if the vertex's neighbors have changed since
+
+  bool operator>(const Candidate &other) const noexcept {
+    return this->importance > other.importance;
+  }
+};
+
+double distanceToSegment(const QPointF &p, const QPointF &a,
+                         const QPointF &b) noexcept {
+  QPointF ab = b - a;
+  QPointF ap = p - a;
+  double length = QPointF::dotProduct(ab, ab);
+  double t = (length > 0) ? QPointF::dotProduct(ap, ab) / length : 0;
+  QPointF d = ap - std::max(0.0, std::min(1.0, t)) * ab;
+  return std::sqrt(QPointF::dotProduct(d, d));
+}
+}
+
+LevelOfDetail::LevelOfDetail() noexcept
+    : _ranked(false), _revision(0), _checked(false), _checkedTolerance(0),
+      _simpleAt(-1) {}
+
+bool LevelOfDetail::rank(const QPolygonF &polygon, const unsigned revision,
+                         FrameArena &scratch,
+                         const std::function<bool()> &cancelled) {
+  int n = polygon.size();
+  this->_ranked = false;
+  this->_checked = false;
+  this->_order.clear();
+  this->_importance.clear();
+  this->_order.reserve(n);
+  this->_importance.reserve(n);
+
+  if (n <= 3) {
+    for (int i = 0; i < n; ++i) {
+      this->_order.push_back(i);
+      this->_importance.push_back(ALWAYS);
+    }
+    this->_ranked = true;
+    this->_revision = revision;
+    return true;
+  }
+
+  int *prev = scratch.allocate<int>(n);
+  int *next = scratch.allocate<int>(n);
+  unsigned *version = scratch.allocate<unsigned>(n);
+  Candidate *queue = scratch.allocate<Candidate>(3 * n);
+  int queued = 0;
+  // ^ A min-heap; every vertex goes in once to start, and each drop adds its
+  // two neighbors again.  Out-of-date candidates are left in, and skipped
+  // when they come up.
+  std::greater<Candidate> later;
+
+  for (int i = 0; i < n; ++i) {
+    prev[i] = (i + n - 1) % n;
+    next[i] = (i + 1) % n;
+    version[i] = 0;
+    queue[queued++] = {
+        distanceToSegment(polygon[i], polygon[prev[i]], polygon[next[i]]), i,
+        0};
+  }
+  std::make_heap(queue, queue + queued, later);
+
+  int *dropped = scratch.allocate<int>(n - 3);
+  double *at = scratch.allocate<double>(n - 3);
+  int drops = 0;
+  double floor = 0;
+  int survivor = 0;
+
+  while (drops < n - 3) {
+    std::pop_heap(queue, queue + queued, later);
+    Candidate c = queue[--queued];
+    if (c.version != version[c.vertex])
+      continue;
+
+    floor = std::max(floor, c.importance);
+    // ^ Dropping a vertex can bring its neighbors closer to the outline, but
+    // they still have to rank above it
+    dropped[drops] = c.vertex;
+    at[drops++] = floor;
+
+    int p = prev[c.vertex];
+    int q = next[c.vertex];
+    next[p] = q;
+    prev[q] = p;
+    survivor = q;
+
+    for (int j : {p, q}) {
+      queue[queued++] = {distanceToSegment(polygon[j], polygon[prev[j]],
+                                           polygon[next[j]]),
+                         j, ++version[j]};
+      std::push_heap(queue, queue + queued, later);
+    }
+
+    if (cancelled && drops % CANCEL_INTERVAL == 0 && cancelled()) {
+      this->_order.clear();
+      this->_importance.clear();
+      return false;
+    }
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    this->_order.push_back(survivor);
+    this->_importance.push_back(ALWAYS);
+    survivor = next[survivor];
+  }
+
+  for (int i = drops - 1; i >= 0; --i) {
+    this->_order.push_back(dropped[i]);
+    this->_importance.push_back(at[i]);
+  }
+  // ^ Last dropped is the most important
+
+  this->_ranked = true;
+  this->_revision = revision;
+  return true;
+}
+
+bool LevelOfDetail::ranks(const unsigned revision) const noexcept {
+  return this->_ranked && this->_revision == revision;
+}
+
+void LevelOfDetail::select(const double tolerance,
+                           std::vector<int> &indices) const {
+  int keep = std::lower_bound(this->_importance.begin(),
+                              this->_importance.end(), tolerance,
+                              std::greater<double>()) -
+             this->_importance.begin();
+  keep = std::max(keep, std::min(this->size(), 3));
+
+  indices.assign(this->_order.begin(), this->_order.begin() + keep);
+  std::sort(indices.begin(), indices.end());
+}
+
+void LevelOfDetail::selectSimple(const QPolygonF &polygon,
+                                 const double tolerance,
+                                 std::vector<int> &indices) {
+  if (!this->_checked || this->_checkedTolerance != tolerance) {
+    this->_checked = true;
+    this->_checkedTolerance = tolerance;
+    this->_simpleAt = -1;
+
+    double t = tolerance;
+    for (int i = 0; i < MAX_REFINEMENTS; ++i, t /= 2) {
+      this->select(t, indices);
+      if (static_cast<int>(indices.size()) >= polygon.size()) {
+        this->_simpleAt = t;
+        break;
+      }
+      // ^ Nothing was dropped, so there's nothing to check
+
+      this->_subset.resize(indices.size());
+      for (int j = 0; j < this->_subset.size(); ++j) {
+        this->_subset[j] = polygon[indices[j]];
+      }
+      if (jtg::isSimplePolygon(this->_subset)) {
+        this->_simpleAt = t;
+        break;
+      }
+    }
+  }
+
+  if (this->_simpleAt < 0) {
+    indices.clear();
+  } else {
+    this->select(this->_simpleAt, indices);
+  }
+}
+
+double LevelOfDetail::tolerance(const QMatrix4x4 &worldToScreen,
+                                const QSize &viewport) noexcept {
+  double sx = viewport.width() * 0.5;
+  double sy = viewport.height() * 0.5;
+  double a = worldToScreen(0, 0) * sx;
+  double b = worldToScreen(0, 1) * sx;
+  double c = worldToScreen(1, 0) * sy;
+  double d = worldToScreen(1, 1) * sy;
+  // ^ From world units to pixels; translation doesn't change distances
+
+  double sum = a * a + b * b + c * c + d * d;
+  double det = a * d - b * c;
+  double stretch =
+      std::sqrt((sum + std::sqrt(std::max(sum * sum - 4 * det * det, 0.0))) /
+                2);
+  // ^ The larger singular value
+
+  if (!(stretch > 0))
+    return ALWAYS;
+
+  return std::exp2(std::floor(std::log2(1 / stretch)));
+}
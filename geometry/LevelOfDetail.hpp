@@ -0,0 +1,156 @@
+#ifndef LEVELOFDETAIL_HPP
+#define LEVELOFDETAIL_HPP
+
+#include <functional>
+#include <vector>
+
+#include <QPolygonF>
+
+#include "renderer/FrameArena.hpp"
+
+class QMatrix4x4;
+class QSize;
+
+/**
+ * Ranks a polygon's vertices by how much they matter to its shape, so that
+ * drawing it at any scale only needs the ones that are at least a pixel's
+ * worth of detail there.
+ *
+ * The ranking is Visvalingam-Whyatt's elimination order: repeatedly drop the
+ * vertex that's closest to the segment joining its neighbors, and remember how
+ * far that was.  (It's usually done with the triangle's area instead; the
+ * distance doesn't lose thin spikes, which are tiny in area but not on screen.)
+ * A vertex never ranks below one dropped before it, so the vertices above any
+ * threshold are exactly what's left at the point it was reached.
+ *
+ * Ranking takes O(n log n) and is done once per change to the polygon;
+ * selecting for a given tolerance then takes O(k log k) for the k vertices
+ * kept, however many there are in total.
+ *
+ * Dropping vertices doesn't respect topology: an edge that skips over some
+ * can cut across others, so a simple polygon's selection might not be.  See
+ * selectSimple().
+ */
+class LevelOfDetail {
+public:
+  LevelOfDetail() noexcept;
+
+  /**
+   * Ranks the polygon's vertices, replacing the last ranking, with all of its
+   * bookkeeping allocated from scratch.  Gives up (leaving nothing ranked) if
+   * cancelled() ever returns true; it's checked every few thousand vertices.
+   *
+   * @param revision Whatever the caller uses to tell versions of the polygon
+   * apart (see ranks())
+   * @return false if cancelled
+   */
+  bool rank(const QPolygonF &, const unsigned revision, FrameArena &scratch,
+            const std::function<bool()> &cancelled = std::function<bool()>());
+
+  int size() const noexcept { return this->_order.size(); }
+  bool ranks(const unsigned revision) const noexcept;
+  // ^ Whether this is the ranking of that revision of the polygon, so it's
+  // safe to select from for it
+
+  /**
+   * Replaces indices with the vertices to draw (in the polygon's order) so
+   * that none of the others were further than tolerance from the outline
+   * when they were dropped.  Always keeps at least three, if there are that
+   * many.
+   */
+  void select(const double tolerance, std::vector<int> &indices) const;
+
+  /**
+   * Like select(), for a simple polygon, but makes sure the selection is
+   * simple too, so it can still be triangulated and filled: if it isn't,
+   * tries again at half the tolerance, a few times, and then gives up and
+   * leaves indices empty (for every vertex).  Checking takes O(k log k), and
+   * the outcome is remembered for the ranking and tolerance, since panning
+   * asks for the same selection again and again.
+   */
+  void selectSimple(const QPolygonF &, const double tolerance,
+                    std::vector<int> &indices);
+
+  /**
+   * Has draw() draw the polygon at the given tolerance as soon as it can:
+   * with what's selected from this ranking if it's of that revision, else
+   * with every vertex (ranking takes longer than drawing them all), and then,
+   * once the polygon's been ranked, again with only the vertices that show, if
+   * that's fewer.  While the polygon is being edited, each edit cancels the
+   * ranking for the one before, so that only starts once it's left alone.
+   *
+   * @param simple Whether the polygon is; if so, so is everything drawn (see
+   * selectSimple())
+   * @param kept Replaced before each draw() with the vertices it should use;
+   * empty means all of them
+   * @return Whether this ranked the polygon, i.e. used scratch
+   */
+  template <class F>
+  bool refine(const QPolygonF &, const unsigned revision,
+              const double tolerance, const bool simple,
+              std::vector<int> &kept, FrameArena &scratch,
+              const std::function<bool()> &cancelled, F draw);
+
+  /**
+   * @return The size of a pixel in world units, along whichever direction the
+   * transform stretches most, rounded down to a power of two (so that small
+   * changes in scale don't change what's selected); infinite if the
+   * transform collapses everything to a point
+   */
+  static double tolerance(const QMatrix4x4 &worldToScreen,
+                          const QSize &viewport) noexcept;
+
+private:
+  bool _ranked;
+  unsigned _revision;
+  // ^ Of what was ranked, if anything
+  std::vector<int> _order;
+  // ^ Vertex indices, most important first
+  std::vector<double> _importance;
+  // ^ Of each vertex in _order, so never increasing
+
+  bool _checked;
+  double _checkedTolerance;
+  double _simpleAt;
+  // ^ What selectSimple() last found for this ranking: the largest tolerance
+  // up to _checkedTolerance whose selection is simple, or negative for none
+  QPolygonF _subset;
+  // ^ Where selections are copied to be checked
+};
+
+template <class F>
+bool LevelOfDetail::refine(const QPolygonF &polygon, const unsigned revision,
+                           const double tolerance, const bool simple,
+                           std::vector<int> &kept, FrameArena &scratch,
+                           const std::function<bool()> &cancelled, F draw) {
+  auto pick = [this, &polygon, tolerance, simple, &kept]() {
+    if (simple) {
+      this->selectSimple(polygon, tolerance, kept);
+    } else {
+      this->select(tolerance, kept);
+    }
+  };
+
+  bool ranked = this->ranks(revision);
+  if (ranked) {
+    pick();
+  } else {
+    kept.clear();
+  }
+
+  draw();
+  if (ranked || cancelled())
+    return false;
+
+  scratch.reset();
+  if (!this->rank(polygon, revision, scratch, cancelled))
+    return false;
+
+  pick();
+  if (!kept.empty() && static_cast<int>(kept.size()) < polygon.size()) {
+    draw();
+  }
+  return true;
+}
+
+#endif // LEVELOFDETAIL_HPP
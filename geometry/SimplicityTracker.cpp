@@ -0,0 +1,432 @@
+#include "SimplicityTracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <QPolygonF>
+
+constexpr int NONE = -1;
+constexpr double DEFAULT_CELL_SIZE = 64;
+// ^ For polygons that are too small to guess a better one from
+constexpr double CELL_EPSILON = 1e-7;
+// ^ Fraction of a cell to pad each edge's extent by, so that rounding can
+// never leave out a cell that the edge touches
+constexpr double GRID_MARGIN = 1;
+// ^ How far the grid reaches past the polygon on each side, relative to the
+// polygon's size; cells only take memory once an edge is in them
+constexpr int OUTSIDE = -1;
+// ^ Both coordinates of the cell that holds every edge that leaves the grid
+constexpr int MIN_OUTSIDE_LIMIT = 16;
+// ^ Edges allowed in that cell before the grid is laid out again; more, for
+// big polygons (see _gridIsStale())
+
+SimplicityTracker::SimplicityTracker() noexcept
+    : _layout{0, 0, DEFAULT_CELL_SIZE, 1, 1}, _gridBuiltFor(0), _stamp(0),
+      _pairs(0), _duplicates(0) {}
+
+void SimplicityTracker::reset(const QPolygonF &polygon) {
+  int n = polygon.size();
+
+  this->_vertices.clear();
+  this->_free.clear();
+  this->_order.clear();
+  this->_grid.clear();
+  this->_points.clear();
+  this->_stamps.clear();
+  this->_pairs = 0;
+  this->_duplicates = 0;
+
+  this->_vertices.resize(n);
+  this->_order.resize(n);
+  this->_points.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    Vertex &v = this->_vertices[i];
+    v.point = polygon[i];
+    v.prev = (i + n - 1) % n;
+    v.next = (i + 1) % n;
+    this->_order[i] = i;
+    this->_addPoint(v.point);
+  }
+
+  this->_layoutGrid();
+  // ^ The edges go in below, one at a time, so that each one is tested against
+  // the ones before it
+
+  for (int i = 0; i < n; ++i) {
+    this->_addEdge(i);
+  }
+}
+
+void SimplicityTracker::moveVertex(const int index, const QPointF &point) {
+  Q_ASSERT(0 <= index && index < this->size());
+
+  int id = this->_order[index];
+  int prev = this->_vertices[id].prev;
+
+  if (prev != id)
+    this->_removeEdge(prev);
+  this->_removeEdge(id);
+
+  this->_removePoint(this->_vertices[id].point);
+  this->_vertices[id].point = point;
+  this->_addPoint(point);
+
+  if (prev != id)
+    this->_addEdge(prev);
+  this->_addEdge(id);
+
+  if (this->_gridIsStale()) {
+    this->_rebuildGrid();
+  }
+}
+
+void SimplicityTracker::insertVertex(const int index, const QPointF &point) {
+  Q_ASSERT(0 <= index && index <= this->size());
+
+  int n = this->size();
+  int id;
+
+  if (n == 0) {
+    id = this->_newVertex(point);
+    this->_vertices[id].prev = id;
+    this->_vertices[id].next = id;
+  } else {
+    int next = this->_order[index % n];
+    int prev = this->_vertices[next].prev;
+    this->_removeEdge(prev);
+    // ^ This edge is being split in two
+
+    id = this->_newVertex(point);
+    this->_vertices[id].prev = prev;
+    this->_vertices[id].next = next;
+    this->_vertices[prev].next = id;
+    this->_vertices[next].prev = id;
+    this->_addEdge(prev);
+  }
+
+  this->_order.insert(this->_order.begin() + index, id);
+  this->_addPoint(point);
+  this->_addEdge(id);
+
+  if (this->_gridIsStale()) {
+    this->_rebuildGrid();
+  }
+}
+
+void SimplicityTracker::appendVertex(const QPointF &point) {
+  this->insertVertex(this->size(), point);
+}
+
+void SimplicityTracker::removeVertex(const int index) {
+  Q_ASSERT(0 <= index && index < this->size());
+
+  int id = this->_order[index];
+  int prev = this->_vertices[id].prev;
+  int next = this->_vertices[id].next;
+
+  if (prev != id)
+    this->_removeEdge(prev);
+  this->_removeEdge(id);
+
+  this->_removePoint(this->_vertices[id].point);
+  this->_order.erase(this->_order.begin() + index);
+  this->_free.push_back(id);
+
+  if (prev != id) {
+    this->_vertices[prev].next = next;
+    this->_vertices[next].prev = prev;
+    this->_addEdge(prev);
+  }
+
+  if (this->_gridIsStale()) {
+    this->_rebuildGrid();
+  }
+}
+
+bool SimplicityTracker::isSimple() const noexcept {
+  int n = this->size();
+  if (n < 3)
+    return false;
+
+  if (n == 3)
+    return true;
+
+  return this->_pairs == 0 && this->_duplicates == 0;
+}
+
+SimplicityTracker::Cell SimplicityTracker::_cell(const int x,
+                                                 const int y) const noexcept {
+  return (static_cast<Cell>(static_cast<std::uint32_t>(x)) << 32) |
+         static_cast<std::uint32_t>(y);
+}
+
+/**
+ * Calls f(cx, cy) for every grid cell that the given edge passes through, and
+ * f(OUTSIDE, OUTSIDE) if any of it lies outside the grid.  Walks the part
+ * inside one column of cells at a time, so long diagonal edges only visit the
+ * cells they cross rather than their whole bounding box, and no edge visits
+ * more than a row and a column's worth.
+ */
+template <class F>
+void SimplicityTracker::_forEachCell(const QPointF &a, const QPointF &b,
+                                     F f) const {
+  const Layout &grid = this->_layout;
+
+  if (!std::isfinite(a.x()) || !std::isfinite(a.y()) ||
+      !std::isfinite(b.x()) || !std::isfinite(b.y())) {
+    f(OUTSIDE, OUTSIDE);
+    return;
+  }
+
+  double t0 = 0;
+  double t1 = 1;
+  QPointF d = b - a;
+  const double p[] = {-d.x(), d.x(), -d.y(), d.y()};
+  const double q[] = {a.x() - grid.left,
+                      grid.left + grid.columns * grid.cellSize - a.x(),
+                      a.y() - grid.top,
+                      grid.top + grid.rows * grid.cellSize - a.y()};
+  for (int i = 0; i < 4; ++i) {
+    if (p[i] == 0) {
+      if (q[i] < 0)
+        t0 = 2;
+      // ^ Parallel to that side of the grid, and beyond it
+    } else if (p[i] < 0) {
+      t0 = std::max(t0, q[i] / p[i]);
+    } else {
+      t1 = std::min(t1, q[i] / p[i]);
+    }
+  }
+  // ^ Clips the edge to the grid (Liang-Barsky), so t0 to t1 is what's inside
+
+  if (t0 > 0 || t1 < 1) {
+    f(OUTSIDE, OUTSIDE);
+  }
+  if (t0 > t1)
+    return;
+
+  QPointF origin(grid.left, grid.top);
+  QPointF ca = a + d * t0 - origin;
+  QPointF cb = a + d * t1 - origin;
+  // ^ Relative to the grid, so the cell coordinates stay small however far
+  // the polygon is from (0, 0)
+  const QPointF &l = (ca.x() <= cb.x()) ? ca : cb;
+  const QPointF &r = (ca.x() <= cb.x()) ? cb : ca;
+  double size = grid.cellSize;
+  double pad = size * CELL_EPSILON;
+  double dx = r.x() - l.x();
+
+  auto cell = [size](const double x, const int count) {
+    int c = std::floor(std::max(x / size, 0.0));
+    return std::min(c, count - 1);
+  };
+  // ^ The clipped edge can only be past the grid by a rounding error
+
+  int cx0 = cell(l.x() - pad, grid.columns);
+  int cx1 = cell(r.x() + pad, grid.columns);
+
+  for (int cx = cx0; cx <= cx1; ++cx) {
+    double xa = std::max(l.x(), cx * size);
+    double xb = std::min(r.x(), (cx + 1) * size);
+    double ya, yb;
+
+    if (dx == 0 || cx0 == cx1) {
+      ya = l.y();
+      yb = r.y();
+    } else {
+      ya = l.y() + (r.y() - l.y()) * ((xa - l.x()) / dx);
+      yb = l.y() + (r.y() - l.y()) * ((xb - l.x()) / dx);
+    }
+
+    int cy0 = cell(std::min(ya, yb) - pad, grid.rows);
+    int cy1 = cell(std::max(ya, yb) + pad, grid.rows);
+    for (int cy = cy0; cy <= cy1; ++cy) {
+      f(cx, cy);
+    }
+  }
+}
+
+void SimplicityTracker::_addEdge(const int edge) {
+  const Vertex &v = this->_vertices[edge];
+  if (v.next == edge)
+    return;
+  // ^ A lone vertex's "edge" goes nowhere
+
+  if (++this->_stamp == 0) {
+    // If the stamp wrapped around, old stamps could be mistaken for new ones
+    std::fill(this->_stamps.begin(), this->_stamps.end(), 0);
+    this->_stamp = 1;
+  }
+
+  this->_stamps.resize(this->_vertices.size(), 0);
+  this->_stamps[edge] = this->_stamp;
+
+  const QPointF &a = v.point;
+  const QPointF &b = this->_vertices[v.next].point;
+
+  this->_forEachCell(a, b, [&](const int cx, const int cy) {
+    std::vector<int> &cell = this->_grid[this->_cell(cx, cy)];
+
+    for (int other : cell) {
+      if (this->_stamps[other] == this->_stamp)
+        continue;
+      this->_stamps[other] = this->_stamp;
+
+      const Vertex &o = this->_vertices[other];
+      bool adjacent = v.next == other || o.next == edge;
+      if (jtg::segmentsIntersect(a, b, o.point, this->_vertices[o.next].point,
+                                 adjacent)) {
+        this->_vertices[edge].crossings.push_back(other);
+        this->_vertices[other].crossings.push_back(edge);
+        ++this->_pairs;
+      }
+    }
+
+    cell.push_back(edge);
+  });
+}
+
+void SimplicityTracker::_removeEdge(const int edge) {
+  Vertex &v = this->_vertices[edge];
+
+  if (v.next != edge) {
+    const QPointF &a = v.point;
+    const QPointF &b = this->_vertices[v.next].point;
+
+    this->_forEachCell(a, b, [&](const int cx, const int cy) {
+      auto it = this->_grid.find(this->_cell(cx, cy));
+      if (it == this->_grid.end())
+        return;
+
+      std::vector<int> &cell = it->second;
+      auto e = std::find(cell.begin(), cell.end(), edge);
+      if (e != cell.end()) {
+        *e = cell.back();
+        cell.pop_back();
+      }
+
+      if (cell.empty()) {
+        this->_grid.erase(it);
+      }
+    });
+  }
+
+  for (int other : v.crossings) {
+    std::vector<int> &theirs = this->_vertices[other].crossings;
+    auto e = std::find(theirs.begin(), theirs.end(), edge);
+    Q_ASSERT(e != theirs.end());
+    *e = theirs.back();
+    theirs.pop_back();
+  }
+
+  this->_pairs -= v.crossings.size();
+  v.crossings.clear();
+}
+
+void SimplicityTracker::_addPoint(const QPointF &point) {
+  if (++this->_points[point] > 1) {
+    ++this->_duplicates;
+  }
+}
+
+void SimplicityTracker::_removePoint(const QPointF &point) {
+  auto it = this->_points.find(point);
+  Q_ASSERT(it != this->_points.end());
+
+  if (--it->second > 0) {
+    --this->_duplicates;
+  } else {
+    this->_points.erase(it);
+  }
+}
+
+int SimplicityTracker::_newVertex(const QPointF &point) {
+  int id;
+  if (this->_free.empty()) {
+    id = this->_vertices.size();
+    this->_vertices.push_back(Vertex());
+  } else {
+    id = this->_free.back();
+    this->_free.pop_back();
+  }
+
+  Vertex &v = this->_vertices[id];
+  v.point = point;
+  v.prev = v.next = NONE;
+  v.crossings.clear();
+  return id;
+}
+
+void SimplicityTracker::_layoutGrid() {
+  int n = this->size();
+  this->_grid.clear();
+  this->_gridBuiltFor = std::max(n, 1);
+
+  Layout &grid = this->_layout;
+  grid = {0, 0, DEFAULT_CELL_SIZE, 1, 1};
+
+  if (n >= 2) {
+    double left = this->_vertices[this->_order[0]].point.x();
+    double right = left;
+    double top = this->_vertices[this->_order[0]].point.y();
+    double bottom = top;
+    for (int id : this->_order) {
+      const QPointF &p = this->_vertices[id].point;
+      left = std::min(left, p.x());
+      right = std::max(right, p.x());
+      top = std::min(top, p.y());
+      bottom = std::max(bottom, p.y());
+    }
+
+    double extent = std::max(right - left, bottom - top);
+    if (std::isfinite(extent)) {
+      if (extent > 0) {
+        grid.cellSize = extent / std::ceil(std::sqrt(n));
+      }
+      // ^ About one vertex per cell, if they were spread out evenly
+
+      double margin = std::max(extent, grid.cellSize) * GRID_MARGIN;
+      grid.left = left - margin;
+      grid.top = top - margin;
+      grid.columns = std::ceil((right - left + margin * 2) / grid.cellSize);
+      grid.rows = std::ceil((bottom - top + margin * 2) / grid.cellSize);
+      // ^ At most (1 + 2 * GRID_MARGIN) * sqrt(n) cells, plus one, across
+    }
+    // ^ Otherwise some vertex isn't finite, and any layout will do
+  }
+}
+
+void SimplicityTracker::_rebuildGrid() {
+  this->_layoutGrid();
+
+  for (int id : this->_order) {
+    const Vertex &v = this->_vertices[id];
+    if (v.next == id)
+      continue;
+
+    this->_forEachCell(v.point, this->_vertices[v.next].point,
+                       [this, id](const int cx, const int cy) {
+                         this->_grid[this->_cell(cx, cy)].push_back(id);
+                       });
+  }
+}
+
+/**
+ * @return Whether the grid should be laid out again: the polygon has doubled
+ * or quartered in size since it was, or more edges have strayed outside it
+ * than it has cells across (so each new one there is tested against more
+ * edges than walking across the grid would visit)
+ */
+bool SimplicityTracker::_gridIsStale() const noexcept {
+  int n = this->size();
+  if (n > this->_gridBuiltFor * 2 || n * 4 < this->_gridBuiltFor)
+    return true;
+
+  auto outside = this->_grid.find(this->_cell(OUTSIDE, OUTSIDE));
+  if (outside == this->_grid.end())
+    return false;
+
+  int limit = std::max(this->_layout.columns + this->_layout.rows,
+                       MIN_OUTSIDE_LIMIT);
+  return static_cast<int>(outside->second.size()) > limit;
+}
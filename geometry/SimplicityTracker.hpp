@@ -0,0 +1,110 @@
+#ifndef SIMPLICITYTRACKER_HPP
+#define SIMPLICITYTRACKER_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <QPointF>
+
+#include "Utility.hpp"
+
+class QPolygonF;
+
+/**
+ * Keeps track of whether a polygon is simple while it's being edited one
+ * vertex at a time, without re-testing every edge against every other edge.
+ *
+ * Edges live in a uniform grid, keyed by the cells their bounding boxes cover.
+ * Moving, inserting or removing a vertex only changes the two edges that touch
+ * it, so only those two are taken out of the grid and tested against whatever
+ * they share cells with.  The set of intersecting edge pairs is kept up to
+ * date, so the answer is always available in constant time.
+ *
+ * The grid only covers the polygon as it was when the grid was laid out, with
+ * a generous margin; edges that stray past that also go in one extra cell, so
+ * dragging a vertex far away costs no more than dragging it across the
+ * polygon.  The grid is laid out again once the polygon grows or shrinks a
+ * lot, or too many edges have strayed.
+ *
+ * Vertices and edges have stable IDs that survive other vertices being added
+ * or removed; edge e runs from vertex e to the vertex after it.
+ */
+class SimplicityTracker {
+public:
+  SimplicityTracker() noexcept;
+
+  void reset(const QPolygonF &polygon);
+  void moveVertex(const int index, const QPointF &point);
+  void insertVertex(const int index, const QPointF &point);
+  void appendVertex(const QPointF &point);
+  void removeVertex(const int index);
+
+  /**
+   * @return Same as jtg::isSimplePolygon() on the tracked polygon
+   */
+  bool isSimple() const noexcept;
+
+  int size() const noexcept { return this->_order.size(); }
+  int intersectionCount() const noexcept { return this->_pairs; }
+  // ^ Number of pairs of edges that intersect
+
+private:
+  typedef std::uint64_t Cell;
+
+  struct Layout {
+    double left;
+    double top;
+    // ^ Of cell (0, 0)
+    double cellSize;
+    int columns;
+    int rows;
+    // ^ Anything past these is only in the extra cell
+  };
+
+  struct Vertex {
+    QPointF point;
+    int prev;
+    int next;
+    std::vector<int> crossings;
+    // ^ IDs of the edges that this vertex's outgoing edge intersects
+  };
+
+  Cell _cell(const int x, const int y) const noexcept;
+  template <class F>
+  void _forEachCell(const QPointF &a, const QPointF &b, F f) const;
+  void _addEdge(const int edge);
+  void _removeEdge(const int edge);
+  void _addPoint(const QPointF &point);
+  void _removePoint(const QPointF &point);
+  int _newVertex(const QPointF &point);
+  void _layoutGrid();
+  // ^ Empties the grid and lays it out for the vertices as they are now
+  void _rebuildGrid();
+  // ^ Lays it out again and puts every edge back in
+  bool _gridIsStale() const noexcept;
+
+  std::vector<Vertex> _vertices;
+  // ^ Indexed by ID; some may be free
+  std::vector<int> _free;
+  std::vector<int> _order;
+  // ^ The polygon's vertex IDs, in order
+
+  std::unordered_map<Cell, std::vector<int>> _grid;
+  Layout _layout;
+  int _gridBuiltFor;
+  // ^ Vertex count the layout was chosen for
+
+  std::unordered_map<QPointF, int, jtg::PointHash> _points;
+  // ^ How many vertices are at each point
+
+  std::vector<unsigned> _stamps;
+  unsigned _stamp;
+  // ^ For skipping edges that show up in more than one cell of a query
+
+  int _pairs;
+  int _duplicates;
+  // ^ Number of vertices that are equal to an earlier one
+};
+
+#endif // SIMPLICITYTRACKER_HPP
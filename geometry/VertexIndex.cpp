@@ -0,0 +1,140 @@
+#include "VertexIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <QPolygonF>
+
+constexpr double DEFAULT_CELL_SIZE = 1;
+// ^ In world units; for polygons too small to guess a better one from
+
+VertexIndex::VertexIndex() noexcept
+    : _cellSize(DEFAULT_CELL_SIZE), _builtFor(0) {}
+
+void VertexIndex::reset(const QPolygonF &polygon) {
+  this->_points.assign(polygon.begin(), polygon.end());
+  this->_rebuild();
+}
+
+void VertexIndex::moveVertex(const int index, const QPointF &point) {
+  Q_ASSERT(0 <= index && index < this->size());
+
+  if (this->_cell(this->_points[index]) != this->_cell(point)) {
+    this->_remove(index);
+    this->_points[index] = point;
+    this->_add(index);
+  } else {
+    this->_points[index] = point;
+  }
+}
+
+void VertexIndex::insertVertex(const int index, const QPointF &point) {
+  Q_ASSERT(0 <= index && index <= this->size());
+
+  this->_renumber(index, 1);
+  this->_points.insert(this->_points.begin() + index, point);
+
+  if (this->size() > this->_builtFor * 2) {
+    this->_rebuild();
+  } else {
+    this->_add(index);
+  }
+}
+
+void VertexIndex::appendVertex(const QPointF &point) {
+  this->insertVertex(this->size(), point);
+}
+
+void VertexIndex::removeVertex(const int index) {
+  Q_ASSERT(0 <= index && index < this->size());
+
+  this->_remove(index);
+  this->_renumber(index + 1, -1);
+  this->_points.erase(this->_points.begin() + index);
+
+  if (this->size() * 4 < this->_builtFor) {
+    this->_rebuild();
+  }
+}
+
+int VertexIndex::_coordinate(const double x) const noexcept {
+  double c = std::floor(x / this->_cellSize);
+  return std::max<double>(std::min<double>(c, std::numeric_limits<int>::max()),
+                          std::numeric_limits<int>::min());
+  // ^ Clamped, in case someone queries out at infinity
+}
+
+VertexIndex::Cell VertexIndex::_cell(const int x, const int y) const noexcept {
+  return (static_cast<Cell>(static_cast<std::uint32_t>(x)) << 32) |
+         static_cast<std::uint32_t>(y);
+}
+
+VertexIndex::Cell VertexIndex::_cell(const QPointF &point) const noexcept {
+  return this->_cell(this->_coordinate(point.x()),
+                     this->_coordinate(point.y()));
+}
+
+void VertexIndex::_add(const int index) {
+  this->_grid[this->_cell(this->_points[index])].push_back(index);
+}
+
+void VertexIndex::_remove(const int index) {
+  auto it = this->_grid.find(this->_cell(this->_points[index]));
+  Q_ASSERT(it != this->_grid.end());
+
+  std::vector<int> &cell = it->second;
+  auto i = std::find(cell.begin(), cell.end(), index);
+  Q_ASSERT(i != cell.end());
+  *i = cell.back();
+  cell.pop_back();
+
+  if (cell.empty()) {
+    this->_grid.erase(it);
+  }
+}
+
+void VertexIndex::_renumber(const int from, const int delta) {
+  if (from >= this->size())
+    return;
+  // ^ Appending, or removing the last vertex, is the common case
+
+  for (auto &cell : this->_grid) {
+    for (int &i : cell.second) {
+      if (i >= from) {
+        i += delta;
+      }
+    }
+  }
+}
+
+void VertexIndex::_rebuild() {
+  int n = this->size();
+  this->_grid.clear();
+  this->_builtFor = std::max(n, 1);
+
+  if (n >= 2) {
+    double left = this->_points[0].x();
+    double right = left;
+    double top = this->_points[0].y();
+    double bottom = top;
+    for (const QPointF &p : this->_points) {
+      left = std::min(left, p.x());
+      right = std::max(right, p.x());
+      top = std::min(top, p.y());
+      bottom = std::max(bottom, p.y());
+    }
+
+    double extent = std::max(right - left, bottom - top);
+    this->_cellSize = (extent > 0) ? extent / std::ceil(std::sqrt(n))
+                                   : DEFAULT_CELL_SIZE;
+    // ^ About one vertex per cell, if they were spread out evenly
+  } else {
+    this->_cellSize = DEFAULT_CELL_SIZE;
+  }
+
+  this->_grid.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    this->_add(i);
+  }
+}
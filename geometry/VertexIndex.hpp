@@ -0,0 +1,91 @@
+#ifndef VERTEXINDEX_HPP
+#define VERTEXINDEX_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <QPointF>
+#include <QRectF>
+
+class QPolygonF;
+
+/**
+ * A uniform grid over a polygon's vertices, for finding the ones near a point
+ * (e.g. the mouse) without looking at all of them.
+ *
+ * Moving or appending a vertex only touches its cell.  Inserting or removing
+ * one in the middle renumbers everything after it, which costs about as much
+ * as the QPolygonF's own insert or remove.
+ */
+class VertexIndex {
+public:
+  VertexIndex() noexcept;
+
+  void reset(const QPolygonF &polygon);
+  void moveVertex(const int index, const QPointF &point);
+  void insertVertex(const int index, const QPointF &point);
+  void appendVertex(const QPointF &point);
+  void removeVertex(const int index);
+
+  /**
+   * Calls f(index) for every vertex that might be in the given rectangle (and
+   * maybe a few others nearby); the caller does the exact test.
+   */
+  template <class F> void query(const QRectF &rect, F f) const;
+
+  int size() const noexcept { return this->_points.size(); }
+
+private:
+  typedef std::uint64_t Cell;
+
+  Cell _cell(const QPointF &point) const noexcept;
+  Cell _cell(const int x, const int y) const noexcept;
+  int _coordinate(const double x) const noexcept;
+  void _add(const int index);
+  void _remove(const int index);
+  void _renumber(const int from, const int delta);
+  void _rebuild();
+
+  std::unordered_map<Cell, std::vector<int>> _grid;
+  std::vector<QPointF> _points;
+  double _cellSize;
+  int _builtFor;
+  // ^ Vertex count the cell size was chosen for; rebuilt when it doubles
+};
+
+template <class F> void VertexIndex::query(const QRectF &rect, F f) const {
+  int x0 = this->_coordinate(rect.left());
+  int x1 = this->_coordinate(rect.right());
+  int y0 = this->_coordinate(rect.top());
+  int y1 = this->_coordinate(rect.bottom());
+
+  double cells = (double(x1) - x0 + 1) * (double(y1) - y0 + 1);
+  if (cells > this->_grid.size()) {
+    // If the rectangle covers more cells than are occupied (e.g. we're zoomed
+    // way out), just look at the occupied ones
+    for (const auto &cell : this->_grid) {
+      int x = static_cast<std::int32_t>(cell.first >> 32);
+      int y = static_cast<std::int32_t>(cell.first & 0xFFFFFFFF);
+      if (x0 <= x && x <= x1 && y0 <= y && y <= y1) {
+        for (int i : cell.second) {
+          f(i);
+        }
+      }
+    }
+    return;
+  }
+
+  for (int x = x0; x <= x1; ++x) {
+    for (int y = y0; y <= y1; ++y) {
+      auto it = this->_grid.find(this->_cell(x, y));
+      if (it != this->_grid.end()) {
+        for (int i : it->second) {
+          f(i);
+        }
+      }
+    }
+  }
+}
+
+#endif // VERTEXINDEX_HPP
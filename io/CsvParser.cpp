@@ -0,0 +1,75 @@
+#include "CsvParser.hpp"
+
+#include <sstream>
+#include <stdexcept>
+
+#include <QByteArray>
+#include <QList>
+
+CsvParser::CsvParser(const QString &name, const Sink &sink)
+    : PolygonParser(name, sink), _first(true) {}
+
+void CsvParser::feed(const char *data, const int size) {
+  for (int i = 0; i < size; ++i) {
+    char c = data[i];
+
+    if (c == '\n') {
+      this->_endLine();
+      ++this->line;
+    } else if (this->_line.size() < MAX_LINE) {
+      this->_line += c;
+    } else {
+      std::ostringstream e;
+      e << "Line " << this->line << " is too long";
+      throw std::runtime_error(e.str());
+    }
+  }
+}
+
+void CsvParser::finish() {
+  this->_endLine();
+  this->_endPolygon();
+}
+
+void CsvParser::_endLine() {
+  QByteArray row = QByteArray::fromStdString(this->_line).trimmed();
+  this->_line.clear();
+  bool first = this->_first;
+  this->_first = false;
+
+  if (row.isEmpty()) {
+    this->_endPolygon();
+    return;
+  }
+
+  QList<QByteArray> fields = row.split(',');
+  int n = fields.size();
+  bool ok = n == 2 || n == 3;
+  double x = ok ? fields[n - 2].trimmed().toDouble(&ok) : 0;
+  double y = ok ? fields[n - 1].trimmed().toDouble(&ok) : 0;
+
+  if (!ok) {
+    if (first)
+      return;
+    // ^ A header
+
+    std::ostringstream e;
+    e << "Line " << this->line << ": Expected \"x,y\" or \"id,x,y\"";
+    throw std::runtime_error(e.str());
+  }
+
+  if (n == 3) {
+    QString id = QString::fromUtf8(fields[0].trimmed());
+    if (id != this->_id) {
+      this->_endPolygon();
+      this->_id = id;
+    }
+  }
+
+  this->addVertex(x, y);
+}
+
+void CsvParser::_endPolygon() {
+  this->endRing(this->_id);
+  this->_id.clear();
+}
@@ -0,0 +1,34 @@
+#ifndef CSVPARSER_HPP
+#define CSVPARSER_HPP
+
+#include <string>
+
+#include "PolygonParser.hpp"
+
+/**
+ * One vertex per row, as either "id,x,y" (consecutive rows with the same id
+ * are one polygon, named after it) or "x,y" (polygons are separated by blank
+ * lines).  A first row that isn't numbers is taken as a header.
+ */
+class CsvParser : public PolygonParser {
+public:
+  CsvParser(const QString &name, const Sink &sink);
+
+  void feed(const char *data, const int size) override;
+  void finish() override;
+
+private:
+  static constexpr std::size_t MAX_LINE = 4096;
+
+  void _endLine();
+  void _endPolygon();
+
+  std::string _line;
+  // ^ So far; rows are short, so this never gets big
+  QString _id;
+  // ^ Of the polygon being read, if the rows have ids
+  bool _first;
+  // ^ Whether this is the first row, which may be a header
+};
+
+#endif // CSVPARSER_HPP
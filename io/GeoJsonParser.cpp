@@ -0,0 +1,143 @@
+#include "GeoJsonParser.hpp"
+
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+
+constexpr int NOT_IN_COORDINATES = -1;
+constexpr std::size_t MAX_KEY = 16;
+constexpr int POLYGON_POINT_LEVEL = 3;
+// ^ coordinates: [ring: [point: [x, y]]]
+
+GeoJsonParser::GeoJsonParser(const QString &name, const Sink &sink)
+    : PolygonParser(name, sink), _inString(false), _escaped(false),
+      _isKey(false), _arrays(0), _coordinates(NOT_IN_COORDINATES),
+      _pointLevel(0), _coordinate(0), _x(0), _y(0) {}
+
+void GeoJsonParser::feed(const char *data, const int size) {
+  for (int i = 0; i < size; ++i) {
+    char c = data[i];
+
+    if (c == '\n') {
+      ++this->line;
+    }
+
+    if (this->_inString) {
+      if (this->_escaped) {
+        this->_escaped = false;
+      } else if (c == '\\') {
+        this->_escaped = true;
+      } else if (c == '"') {
+        this->_inString = false;
+      } else if (this->_string.size() < MAX_KEY) {
+        this->_string += c;
+      }
+      continue;
+    }
+
+    if (std::isspace(static_cast<unsigned char>(c))) {
+      this->_endNumber();
+      continue;
+    }
+
+    if (c == ':') {
+      this->_isKey = true;
+      continue;
+    }
+
+    if (this->_isKey && this->_string == "coordinates" &&
+        this->_coordinates == NOT_IN_COORDINATES && c == '[') {
+      this->_coordinates = this->_arrays;
+      this->_pointLevel = 0;
+      this->_children[0] = 0;
+    }
+    this->_isKey = false;
+
+    if (c == '"') {
+      this->_endNumber();
+      this->_inString = true;
+      this->_string.clear();
+    } else if (c == '[') {
+      this->_open();
+    } else if (c == ']') {
+      this->_endNumber();
+      this->_close();
+    } else if (c == ',') {
+      this->_endNumber();
+    } else if (NumberToken::accepts(c) &&
+               this->_coordinates != NOT_IN_COORDINATES) {
+      this->_number.append(c);
+    }
+    // ^ Anything else (objects, other values) doesn't matter to us
+  }
+}
+
+void GeoJsonParser::finish() {
+  if (this->_inString || this->_arrays != 0) {
+    throw std::runtime_error("GeoJSON ended in the middle of a value");
+  }
+}
+
+int GeoJsonParser::_level() const noexcept {
+  return this->_arrays - this->_coordinates;
+}
+
+void GeoJsonParser::_open() {
+  ++this->_arrays;
+  if (this->_coordinates == NOT_IN_COORDINATES)
+    return;
+
+  int level = this->_level();
+  if (level >= MAX_DEPTH) {
+    std::ostringstream e;
+    e << "Line " << this->line << ": \"coordinates\" nested too deeply";
+    throw std::runtime_error(e.str());
+  }
+
+  ++this->_children[level - 1];
+  this->_children[level] = 0;
+  this->_coordinate = 0;
+}
+
+void GeoJsonParser::_close() {
+  if (this->_arrays == 0) {
+    std::ostringstream e;
+    e << "Line " << this->line << ": Unmatched ']' in GeoJSON";
+    throw std::runtime_error(e.str());
+  }
+
+  if (this->_coordinates != NOT_IN_COORDINATES &&
+      this->_pointLevel >= POLYGON_POINT_LEVEL) {
+    int level = this->_level();
+    bool outer = this->_children[this->_pointLevel - 2] == 1;
+    // ^ The first ring of its polygon
+
+    if (level == this->_pointLevel && outer && this->_coordinate >= 2) {
+      this->addVertex(this->_x, this->_y);
+    } else if (level == this->_pointLevel - 1 && outer) {
+      this->endRing();
+    }
+  }
+
+  --this->_arrays;
+  if (this->_arrays == this->_coordinates) {
+    this->_coordinates = NOT_IN_COORDINATES;
+  }
+}
+
+void GeoJsonParser::_endNumber() {
+  if (this->_number.isEmpty())
+    return;
+
+  double value = this->_number.take(this->line);
+  if (this->_pointLevel == 0) {
+    this->_pointLevel = this->_level();
+  }
+
+  if (this->_coordinate == 0) {
+    this->_x = value;
+  } else if (this->_coordinate == 1) {
+    this->_y = value;
+  }
+  ++this->_coordinate;
+}
@@ -0,0 +1,51 @@
+#ifndef GEOJSONPARSER_HPP
+#define GEOJSONPARSER_HPP
+
+#include <string>
+
+#include "PolygonParser.hpp"
+
+/**
+ * GeoJSON, or really any JSON: every "coordinates" array nested deeply enough
+ * to be a Polygon's or a MultiPolygon's is read, wherever it is.  Nothing else
+ * is looked at, so features don't have to be in any particular order, and the
+ * whole document is never held in memory (as QJsonDocument would).
+ */
+class GeoJsonParser : public PolygonParser {
+public:
+  GeoJsonParser(const QString &name, const Sink &sink);
+
+  void feed(const char *data, const int size) override;
+  void finish() override;
+
+private:
+  static constexpr int MAX_DEPTH = 8;
+  // ^ Of arrays within "coordinates"; a MultiPolygon only needs 4
+
+  void _open();
+  void _close();
+  void _endNumber();
+  int _level() const noexcept;
+
+  bool _inString;
+  bool _escaped;
+  std::string _string;
+  // ^ The last string, if it's short enough to be "coordinates"
+  bool _isKey;
+  // ^ Whether _string was just followed by ':'
+  int _arrays;
+  // ^ Depth of brackets
+  int _coordinates;
+  // ^ The bracket depth "coordinates" was found at, or -1 outside it
+  int _pointLevel;
+  // ^ How many arrays deep the numbers are in this "coordinates"; 3 for a
+  // Polygon, 4 for a MultiPolygon, or 0 until we get to the first one
+  int _children[MAX_DEPTH];
+  // ^ How many arrays have been opened in the array at each level so far
+  NumberToken _number;
+  int _coordinate;
+  double _x;
+  double _y;
+};
+
+#endif // GEOJSONPARSER_HPP
@@ -0,0 +1,154 @@
+#include "Importer.hpp"
+
+#include <exception>
+#include <memory>
+#include <stdexcept>
+
+#include <QByteArray>
+#include <QFile>
+#include <QMetaType>
+
+#include "PolygonParser.hpp"
+#include "model/SceneFile.hpp"
+
+constexpr int CHUNK_SIZE = 1 << 20;
+constexpr int PUBLISH_INTERVAL = 100;
+// ^ Milliseconds between batches, so the list isn't updated for every polygon
+// of a file with millions of small ones
+
+Importer::Importer(const QString &path, const Format format, QObject *parent)
+    : QThread(parent), _path(path), _format(format), _cancelled(false) {
+  qRegisterMetaType<Importer::Models>("Importer::Models");
+  // ^ To send them across threads
+}
+
+Importer::~Importer() {
+  this->cancel();
+  this->wait();
+}
+
+void Importer::cancel() noexcept { this->_cancelled = true; }
+
+void Importer::run() {
+  this->_published.start();
+
+  if (this->_format == Scene) {
+    this->_readScene();
+  } else {
+    this->_readPolygons();
+  }
+
+  this->_publish();
+  // ^ Whatever's left, even if we stopped early
+}
+
+void Importer::_readPolygons() {
+  QFile file(this->_path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    emit failed(QString("Could not open %1: %2")
+                    .arg(this->_path)
+                    .arg(file.errorString()));
+    return;
+  }
+
+  std::unique_ptr<PolygonParser> parser = PolygonParser::create(
+      this->_path, [this](const QString &name, const QPolygonF &polygon) {
+        this->_add(name, polygon);
+      });
+  if (!parser) {
+    emit failed(QString("Don't know how to read %1").arg(this->_path));
+    return;
+  }
+
+  qint64 total = file.size();
+  qint64 read = 0;
+  QByteArray chunk(CHUNK_SIZE, Qt::Uninitialized);
+  // ^ Reused for every chunk
+
+  try {
+    while (!this->_cancelled) {
+      qint64 n = file.read(chunk.data(), CHUNK_SIZE);
+      if (n < 0) {
+        throw std::runtime_error(file.errorString().toStdString());
+      } else if (n == 0) {
+        parser->finish();
+        break;
+      }
+
+      parser->feed(chunk.constData(), n);
+      read += n;
+      emit progress(read, total);
+    }
+  } catch (const std::exception &e) {
+    emit failed(
+        QString("Could not import %1: %2").arg(this->_path).arg(e.what()));
+  }
+}
+
+void Importer::_readScene() {
+  try {
+    QSharedPointer<const SceneFile> file(new SceneFile(this->_path));
+
+    qint64 total = 0;
+    for (int i = 0; i < file->size(); ++i) {
+      total += file->model(i).vertexCount * qint64(sizeof(QPointF));
+    }
+    // ^ Progress is in bytes of vertices, which is what takes the time for
+    // older files
+    qint64 read = 0;
+
+    for (int i = 0; i < file->size() && !this->_cancelled; ++i) {
+      SceneFile::Model saved = file->model(i);
+      QSharedPointer<ShapelyModel> model =
+          QSharedPointer<ShapelyModel>::create();
+      model->name = saved.name;
+      model->transform = saved.transform;
+      model->cameraCoords = saved.cameraCoords;
+      model->zoom = saved.zoom;
+      if (saved.checked) {
+        model->setMapped(file, saved.vertices, saved.vertexCount,
+                         saved.simple);
+        // ^ Nothing's copied or tracked until the model's shown or edited
+      } else {
+        model->setPolygon(saved.polygon());
+        // ^ The file doesn't say whether it's simple, and finding out is most
+        // of the trackers' work anyway
+      }
+      this->_append(model);
+
+      read += saved.vertexCount * qint64(sizeof(QPointF));
+      emit progress(read, total);
+    }
+  } catch (const std::exception &e) {
+    emit failed(e.what());
+  }
+  // ^ The file was already checked once, but it could have changed since
+}
+
+void Importer::_add(const QString &name, const QPolygonF &polygon) {
+  if (this->_cancelled)
+    return;
+
+  QSharedPointer<ShapelyModel> model = QSharedPointer<ShapelyModel>::create();
+  model->name = name;
+  model->setPolygon(polygon);
+  // ^ Shares polygon's storage rather than copying it
+  this->_append(model);
+}
+
+void Importer::_append(const QSharedPointer<ShapelyModel> &model) {
+  this->_batch.append(model);
+
+  if (this->_published.elapsed() >= PUBLISH_INTERVAL) {
+    this->_publish();
+  }
+}
+
+void Importer::_publish() {
+  if (!this->_batch.isEmpty()) {
+    emit imported(this->_batch);
+    this->_batch.clear();
+  }
+
+  this->_published.restart();
+}
@@ -0,0 +1,73 @@
+#ifndef IMPORTER_HPP
+#define IMPORTER_HPP
+
+#include <atomic>
+
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include <QString>
+#include <QThread>
+#include <QVector>
+
+#include "model/ShapelyModel.hpp"
+
+/**
+ * Reads polygons from a WKT, GeoJSON, or CSV file on its own thread, a chunk
+ * at a time, and builds a ShapelyModel for each one (including its simplicity
+ * and vertex index, which are the expensive part).  Finished models are handed
+ * over in batches as they're ready, so they can be shown before the rest of
+ * the file is read.
+ *
+ * Only one chunk of the file is in memory at a time, on top of the polygons
+ * themselves.
+ *
+ * Saved scenes come through here too, though their models keep drawing from
+ * the mapped file, and only copy their vertices and build their trackers once
+ * they're shown or edited.  Scenes saved before the file recorded which models
+ * are simple still have every model tracked up front, which takes seconds at
+ * ten million vertices.
+ */
+class Importer : public QThread {
+  Q_OBJECT
+
+public:
+  typedef QVector<QSharedPointer<ShapelyModel>> Models;
+
+  enum Format {
+    Polygons,
+    // ^ WKT, GeoJSON, or CSV, going by the file's extension
+    Scene
+    // ^ A SceneFile, whose models keep their names, transforms, and cameras
+  };
+
+  Importer(const QString &path, const Format = Polygons,
+           QObject *parent = nullptr);
+  ~Importer();
+  // ^ Cancels the import and waits for it to stop
+
+  void cancel() noexcept;
+  // ^ Thread-safe; models already sent stay sent
+
+signals:
+  void progress(qint64 bytesRead, qint64 bytesTotal);
+  void imported(Importer::Models models);
+  void failed(const QString &error);
+
+protected:
+  void run() override;
+
+private:
+  void _readPolygons();
+  void _readScene();
+  void _add(const QString &name, const QPolygonF &);
+  void _append(const QSharedPointer<ShapelyModel> &);
+  void _publish();
+
+  QString _path;
+  Format _format;
+  std::atomic<bool> _cancelled;
+  Models _batch;
+  QElapsedTimer _published;
+};
+
+#endif // IMPORTER_HPP
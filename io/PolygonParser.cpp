@@ -0,0 +1,91 @@
+#include "PolygonParser.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <QByteArray>
+#include <QFileInfo>
+
+#include "CsvParser.hpp"
+#include "GeoJsonParser.hpp"
+#include "WktParser.hpp"
+
+constexpr int MIN_VERTICES = 3;
+// ^ Anything less isn't worth a model
+
+PolygonParser::PolygonParser(const QString &name, const Sink &sink)
+    : line(1), _name(name), _count(0), _sink(sink) {}
+
+PolygonParser::~PolygonParser() {}
+
+std::unique_ptr<PolygonParser> PolygonParser::create(const QString &path,
+                                                     const Sink &sink) {
+  QFileInfo info(path);
+  QString suffix = info.suffix().toLower();
+  QString name = info.completeBaseName();
+
+  if (suffix == "wkt") {
+    return std::unique_ptr<PolygonParser>(new WktParser(name, sink));
+  } else if (suffix == "geojson" || suffix == "json") {
+    return std::unique_ptr<PolygonParser>(new GeoJsonParser(name, sink));
+  } else if (suffix == "csv") {
+    return std::unique_ptr<PolygonParser>(new CsvParser(name, sink));
+  }
+
+  return nullptr;
+}
+
+void PolygonParser::addVertex(const double x, const double y) {
+  this->_ring.push_back(QPointF(x, y));
+}
+
+void PolygonParser::endRing(const QString &name) {
+  std::vector<QPointF> &ring = this->_ring;
+  if (ring.size() > 1 && ring.front() == ring.back()) {
+    ring.pop_back();
+  }
+
+  if (ring.size() >= MIN_VERTICES) {
+    QPolygonF polygon(ring.size());
+    std::copy(ring.begin(), ring.end(), polygon.begin());
+    this->_sink(name.isEmpty() ? this->_nextName() : name, polygon);
+  }
+
+  ring.clear();
+  // ^ Keeps its capacity for the next one
+}
+
+QString PolygonParser::_nextName() {
+  return QString("%1 %2").arg(this->_name).arg(++this->_count);
+}
+
+bool NumberToken::accepts(const char c) noexcept {
+  return ('0' <= c && c <= '9') || c == '-' || c == '+' || c == '.' ||
+         c == 'e' || c == 'E';
+}
+
+void NumberToken::append(const char c) {
+  if (this->_length == CAPACITY) {
+    throw std::runtime_error("Number too long");
+  }
+
+  this->_chars[this->_length++] = c;
+}
+
+double NumberToken::take(const int line) {
+  bool ok = false;
+  double value = QByteArray(this->_chars, this->_length).toDouble(&ok);
+  // ^ Not strtod(), which would go by the user's locale
+
+  if (!ok) {
+    std::ostringstream e;
+    e << "Line " << line << ": \"" << std::string(this->_chars, this->_length)
+      << "\" is not a number";
+    throw std::runtime_error(e.str());
+  }
+
+  this->_length = 0;
+  return value;
+}
@@ -0,0 +1,84 @@
+#ifndef POLYGONPARSER_HPP
+#define POLYGONPARSER_HPP
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <QPointF>
+#include <QPolygonF>
+#include <QString>
+
+/**
+ * Turns a stream of text into polygons, a chunk at a time, so a file never has
+ * to be in memory all at once.  Chunks can end anywhere, even in the middle of
+ * a number; each parser keeps just enough state to pick up where it left off.
+ *
+ * Only outer boundaries are kept; holes are skipped, since a ShapelyModel is a
+ * single ring.  The closing vertex that many formats repeat is dropped.
+ */
+class PolygonParser {
+public:
+  typedef std::function<void(const QString &name, const QPolygonF &)> Sink;
+
+  /**
+   * @param name What to call polygons the file doesn't name; they're numbered
+   * after it
+   * @param sink Called with each polygon as soon as it's complete
+   */
+  PolygonParser(const QString &name, const Sink &sink);
+  virtual ~PolygonParser();
+
+  virtual void feed(const char *data, const int size) = 0;
+  // ^ Throws std::runtime_error if the text isn't what it should be
+  virtual void finish() = 0;
+  // ^ No more input; throws std::runtime_error if it stopped mid-polygon
+
+  /**
+   * A parser for the file's format, going by its suffix (.wkt, .geojson or
+   * .json, .csv), or null if it's none of those.
+   */
+  static std::unique_ptr<PolygonParser> create(const QString &path,
+                                               const Sink &sink);
+
+protected:
+  void addVertex(const double x, const double y);
+  void endRing(const QString &name = QString());
+  // ^ Hands the ring built so far to the sink (numbered after the file, if it
+  // has no name of its own) and starts a new one
+
+  int line;
+  // ^ For error messages
+
+private:
+  QString _nextName();
+
+  std::vector<QPointF> _ring;
+  // ^ Scratch space, reused for every ring so only the finished polygon is
+  // allocated exactly once
+  QString _name;
+  int _count;
+  Sink _sink;
+};
+
+/**
+ * Accumulates the characters of a number that may be split across chunks.
+ */
+class NumberToken {
+public:
+  NumberToken() noexcept : _length(0) {}
+
+  static bool accepts(const char c) noexcept;
+  bool isEmpty() const noexcept { return this->_length == 0; }
+  void append(const char c);
+  double take(const int line);
+  // ^ Parses and clears it; throws std::runtime_error if it isn't a number
+
+private:
+  static constexpr int CAPACITY = 64;
+
+  char _chars[CAPACITY];
+  int _length;
+};
+
+#endif // POLYGONPARSER_HPP
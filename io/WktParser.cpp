@@ -0,0 +1,127 @@
+#include "WktParser.hpp"
+
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+
+WktParser::WktParser(const QString &name, const Sink &sink)
+    : PolygonParser(name, sink), _depth(0), _ringDepth(0), _ring(0),
+      _coordinate(0), _x(0), _y(0) {}
+
+void WktParser::feed(const char *data, const int size) {
+  for (int i = 0; i < size; ++i) {
+    char c = data[i];
+
+    if (c == '(') {
+      this->_endNumber();
+      this->_open();
+    } else if (c == ')') {
+      this->_close();
+    } else if (c == ',') {
+      this->_endNumber();
+      if (this->_depth == this->_ringDepth) {
+        this->_endVertex();
+      }
+    } else if (this->_depth == 0) {
+      if (std::isalpha(static_cast<unsigned char>(c))) {
+        this->_keyword += std::toupper(static_cast<unsigned char>(c));
+        const std::string &k = this->_keyword;
+        if (k.size() >= 5 && k.compare(k.size() - 5, 5, "EMPTY") == 0) {
+          this->_keyword.clear();
+        }
+        // ^ A geometry with no parentheses
+      } else if (c == ';') {
+        this->_keyword.clear();
+        // ^ After an SRID
+      }
+    } else if (NumberToken::accepts(c)) {
+      if (this->_depth == this->_ringDepth) {
+        this->_number.append(c);
+      }
+    } else if (std::isspace(static_cast<unsigned char>(c))) {
+      this->_endNumber();
+    } else {
+      std::ostringstream e;
+      e << "Line " << this->line << ": Unexpected '" << c << "' in WKT";
+      throw std::runtime_error(e.str());
+    }
+
+    if (c == '\n') {
+      ++this->line;
+    }
+  }
+}
+
+void WktParser::finish() {
+  if (this->_depth != 0) {
+    throw std::runtime_error("WKT ended in the middle of a geometry");
+  }
+}
+
+void WktParser::_open() {
+  if (this->_depth == 0) {
+    const std::string &k = this->_keyword;
+    if (k.compare(0, 12, "MULTIPOLYGON") == 0) {
+      this->_ringDepth = 3;
+    } else if (k.compare(0, 7, "POLYGON") == 0) {
+      this->_ringDepth = 2;
+    } else {
+      this->_ringDepth = 0;
+    }
+  }
+
+  ++this->_depth;
+  if (this->_depth == this->_ringDepth - 1) {
+    this->_ring = 0;
+  } else if (this->_depth == this->_ringDepth) {
+    this->_coordinate = 0;
+  }
+}
+
+void WktParser::_close() {
+  if (this->_depth == 0) {
+    std::ostringstream e;
+    e << "Line " << this->line << ": Unmatched ')' in WKT";
+    throw std::runtime_error(e.str());
+  }
+
+  this->_endNumber();
+  if (this->_depth == this->_ringDepth) {
+    this->_endVertex();
+    if (this->_ring++ == 0) {
+      this->endRing();
+    }
+  }
+
+  --this->_depth;
+  if (this->_depth == 0) {
+    this->_keyword.clear();
+  }
+}
+
+void WktParser::_endNumber() {
+  if (this->_number.isEmpty())
+    return;
+
+  double value = this->_number.take(this->line);
+  if (this->_coordinate == 0) {
+    this->_x = value;
+  } else if (this->_coordinate == 1) {
+    this->_y = value;
+  }
+  // ^ Any Z or M is ignored
+
+  ++this->_coordinate;
+}
+
+void WktParser::_endVertex() {
+  if (this->_coordinate >= 2 && this->_ring == 0) {
+    this->addVertex(this->_x, this->_y);
+  } else if (this->_coordinate == 1) {
+    std::ostringstream e;
+    e << "Line " << this->line << ": Vertex with only one coordinate";
+    throw std::runtime_error(e.str());
+  }
+
+  this->_coordinate = 0;
+}
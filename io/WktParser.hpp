@@ -0,0 +1,42 @@
+#ifndef WKTPARSER_HPP
+#define WKTPARSER_HPP
+
+#include <string>
+
+#include "PolygonParser.hpp"
+
+/**
+ * Well-known text: any number of POLYGON and MULTIPOLYGON geometries (with or
+ * without Z or M, or an SRID= prefix), one after another.  Other geometries
+ * are skipped.
+ */
+class WktParser : public PolygonParser {
+public:
+  WktParser(const QString &name, const Sink &sink);
+
+  void feed(const char *data, const int size) override;
+  void finish() override;
+
+private:
+  void _open();
+  void _close();
+  void _endNumber();
+  void _endVertex();
+
+  std::string _keyword;
+  // ^ Letters since the last geometry, upper-cased
+  NumberToken _number;
+  int _depth;
+  // ^ Of parentheses
+  int _ringDepth;
+  // ^ The depth rings are at in this geometry: 2 in a POLYGON, 3 in a
+  // MULTIPOLYGON, or 0 to skip it
+  int _ring;
+  // ^ Which ring of the current polygon we're in; 0 is the outer boundary
+  int _coordinate;
+  // ^ Which coordinate of the current vertex is next
+  double _x;
+  double _y;
+};
+
+#endif // WKTPARSER_HPP
@@ -0,0 +1,251 @@
+#include "EditHistory.hpp"
+
+#include "ShapelyModel.hpp"
+
+constexpr std::size_t EditHistory::DEFAULT_BUDGET;
+
+EditHistory::EditHistory(const std::size_t budget)
+    : _done(0), _transformsDone(0), _bytes(0), _budget(budget),
+      _sealed(true) {}
+
+void EditHistory::setListener(const Listener &listener) {
+  this->_listener = listener;
+}
+
+void EditHistory::insertVertex(const QSharedPointer<ShapelyModel> &model,
+                               const int index) {
+  Q_ASSERT(0 <= index && index < model->polygon.size());
+
+  Edit edit;
+  edit.model = model;
+  edit.to = model->polygon[index];
+  edit.bytes = sizeof(Edit);
+  edit.index = index;
+  edit.kind = InsertVertex;
+  this->_push(edit);
+  this->_sealed = false;
+  // ^ In case it's dragged before the mouse is released
+}
+
+void EditHistory::moveVertex(const QSharedPointer<ShapelyModel> &model,
+                             const int index, const QPointF &from) {
+  Q_ASSERT(0 <= index && index < model->polygon.size());
+
+  if (Edit *open = this->_open(model, MoveVertex, index)) {
+    open->to = model->polygon[index];
+    return;
+  }
+  // ^ Part of the same drag; the edit keeps where it started
+
+  Edit edit;
+  edit.model = model;
+  edit.from = from;
+  edit.to = model->polygon[index];
+  edit.bytes = sizeof(Edit);
+  edit.index = index;
+  edit.kind = MoveVertex;
+  this->_push(edit);
+  this->_sealed = false;
+}
+
+void EditHistory::removeVertex(const QSharedPointer<ShapelyModel> &model,
+                               const int index, const QPointF &removed) {
+  Edit edit;
+  edit.model = model;
+  edit.from = removed;
+  edit.bytes = sizeof(Edit);
+  edit.index = index;
+  edit.kind = RemoveVertex;
+  this->_push(edit);
+}
+
+void EditHistory::transform(const QSharedPointer<ShapelyModel> &model,
+                            const QTransform &from, const TransformKind kind) {
+  if (model->transform == from)
+    return;
+
+  if (this->_open(model, Transform, kind)) {
+    this->_transforms.back().to = model->transform;
+    return;
+  }
+  // ^ The last edit, so its matrices are the last ones too; it keeps where it
+  // started
+
+  this->_truncate();
+  this->_transforms.push_back({from, model->transform});
+  // ^ _push() counts these as done along with the edit
+
+  Edit edit;
+  edit.model = model;
+  edit.bytes = sizeof(Edit) + sizeof(Matrices);
+  edit.index = kind;
+  edit.kind = Transform;
+  this->_push(edit);
+  this->_sealed = kind == Reflect;
+  // ^ Reflecting twice is two edits, or else the second would leave nothing to
+  // undo
+}
+
+void EditHistory::addModel(const QSharedPointer<ShapelyModel> &model,
+                           const int row) {
+  Edit edit;
+  edit.model = model;
+  edit.bytes = sizeof(Edit);
+  edit.index = row;
+  edit.kind = AddModel;
+  this->_push(edit);
+}
+
+void EditHistory::removeModel(const QSharedPointer<ShapelyModel> &model,
+                              const int row) {
+  Edit edit;
+  edit.model = model;
+  edit.bytes = sizeof(Edit) + model->polygon.size() * sizeof(QPointF);
+  edit.index = row;
+  edit.kind = RemoveModel;
+  this->_push(edit);
+}
+
+void EditHistory::seal() noexcept { this->_sealed = true; }
+
+const EditHistory::Edit *EditHistory::undo() {
+  this->_sealed = true;
+  if (!this->canUndo())
+    return nullptr;
+
+  const Edit &edit = this->_edits[--this->_done];
+  ShapelyModel &model = *edit.model;
+
+  switch (edit.kind) {
+  case InsertVertex:
+    model.removeVertex(edit.index);
+    break;
+  case MoveVertex:
+    model.moveVertex(edit.index, edit.from);
+    break;
+  case RemoveVertex:
+    model.insertVertex(edit.index, edit.from);
+    break;
+  case Transform:
+    model.transform = this->_transforms[--this->_transformsDone].from;
+    break;
+  case AddModel:
+  case RemoveModel:
+    break;
+  }
+
+  if (this->_listener) {
+    this->_listener();
+  }
+  return &edit;
+}
+
+const EditHistory::Edit *EditHistory::redo() {
+  this->_sealed = true;
+  if (!this->canRedo())
+    return nullptr;
+
+  const Edit &edit = this->_edits[this->_done++];
+  ShapelyModel &model = *edit.model;
+
+  switch (edit.kind) {
+  case InsertVertex:
+    model.insertVertex(edit.index, edit.to);
+    break;
+  case MoveVertex:
+    model.moveVertex(edit.index, edit.to);
+    break;
+  case RemoveVertex:
+    model.removeVertex(edit.index);
+    break;
+  case Transform:
+    model.transform = this->_transforms[this->_transformsDone++].to;
+    break;
+  case AddModel:
+  case RemoveModel:
+    break;
+  }
+
+  if (this->_listener) {
+    this->_listener();
+  }
+  return &edit;
+}
+
+void EditHistory::clear() noexcept {
+  this->_edits.clear();
+  this->_transforms.clear();
+  this->_done = 0;
+  this->_transformsDone = 0;
+  this->_bytes = 0;
+  this->_sealed = true;
+
+  if (this->_listener) {
+    this->_listener();
+  }
+}
+
+/**
+ * @return The last edit, if it hasn't been sealed and another edit of the
+ * given kind and index to the given model would continue it, else nullptr.  A
+ * move continues an insert.
+ */
+EditHistory::Edit *
+EditHistory::_open(const QSharedPointer<ShapelyModel> &model, const Kind kind,
+                   const int index) noexcept {
+  if (this->_sealed || !this->canUndo() || this->canRedo())
+    return nullptr;
+
+  Edit &last = this->_edits.back();
+  bool continues =
+      last.kind == kind || (kind == MoveVertex && last.kind == InsertVertex);
+  if (continues && last.model == model && last.index == index) {
+    return &last;
+  }
+
+  return nullptr;
+}
+
+void EditHistory::_push(const Edit &edit) {
+  this->_truncate();
+  this->_edits.push_back(edit);
+  this->_bytes += edit.bytes;
+  ++this->_done;
+  if (edit.kind == Transform) {
+    ++this->_transformsDone;
+  }
+  this->_sealed = true;
+  this->_trim();
+
+  if (this->_listener) {
+    this->_listener();
+  }
+}
+
+/**
+ * Forgets whatever could have been redone, since a new edit's been made.
+ */
+void EditHistory::_truncate() noexcept {
+  while (this->canRedo()) {
+    if (this->_edits.back().kind == Transform) {
+      this->_transforms.pop_back();
+    }
+    this->_bytes -= this->_edits.back().bytes;
+    this->_edits.pop_back();
+  }
+}
+
+/**
+ * Forgets the oldest edits until the rest fit in the budget.
+ */
+void EditHistory::_trim() noexcept {
+  while (this->_bytes > this->_budget && this->canUndo()) {
+    if (this->_edits.front().kind == Transform) {
+      this->_transforms.pop_front();
+      --this->_transformsDone;
+    }
+    this->_bytes -= this->_edits.front().bytes;
+    this->_edits.pop_front();
+    --this->_done;
+  }
+}
@@ -0,0 +1,131 @@
+#ifndef EDITHISTORY_HPP
+#define EDITHISTORY_HPP
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+
+#include <QPointF>
+#include <QSharedPointer>
+#include <QTransform>
+#include <QtGlobal>
+
+struct ShapelyModel;
+
+/**
+ * Undo and redo, as a log of the edits themselves rather than of what they
+ * left behind.  Each one records only what it changed (one vertex, or one
+ * model's transform, or where a model went in the list), so recording one, or
+ * undoing or redoing a move or a transform, costs the same whether the polygon
+ * has ten vertices or a million.  Undoing or redoing an inserted or removed
+ * vertex doesn't: the model shifts every vertex after it, which is O(n).
+ *
+ * A vertex being dragged is a single edit however many moves it takes; moves
+ * of the same vertex of the same model are merged into the last edit until
+ * seal() is called.  Inserting a vertex leaves it open as well, so adding a
+ * vertex and dragging it into place is one edit too.  Likewise, consecutive
+ * transforms of the same kind to the same model (e.g. each step of a spin box)
+ * are one edit, except for reflections.
+ *
+ * The log holds on to at most budget bytes (counting a removed model's
+ * vertices, since the log is what keeps them alive); past that, the oldest
+ * edits are forgotten.
+ *
+ * Vertex and transform edits are applied to the model by undo() and redo();
+ * adding and removing models is left to whoever owns the list.
+ */
+class EditHistory {
+public:
+  enum Kind : quint8 {
+    InsertVertex,
+    MoveVertex,
+    RemoveVertex,
+    Transform,
+    AddModel,
+    RemoveModel
+  };
+
+  enum TransformKind : quint8 { Translate, Rotate, Scale, Shear, Reflect };
+
+  struct Edit {
+    QSharedPointer<ShapelyModel> model;
+    QPointF from;
+    QPointF to;
+    // ^ The vertex before and after; an inserted one only has to, and a
+    // removed one only from
+    quint32 bytes;
+    // ^ What this counts for against the budget
+    int index;
+    // ^ Of the vertex, or of the model in the list; for Transform, its
+    // TransformKind (the matrices are kept on the side)
+    Kind kind;
+  };
+
+  typedef std::function<void()> Listener;
+
+  static constexpr std::size_t DEFAULT_BUDGET = 16 << 20;
+
+  explicit EditHistory(const std::size_t budget = DEFAULT_BUDGET);
+
+  void setListener(const Listener &);
+  // ^ Called whenever an edit is recorded, undone, or redone, or the history
+  // is cleared, e.g. to enable or disable the Undo and Redo actions
+
+  // Recording, after the edit's been made //////////////////////////////////
+  void insertVertex(const QSharedPointer<ShapelyModel> &, const int index);
+  void moveVertex(const QSharedPointer<ShapelyModel> &, const int index,
+                  const QPointF &from);
+  void removeVertex(const QSharedPointer<ShapelyModel> &, const int index,
+                    const QPointF &removed);
+  void transform(const QSharedPointer<ShapelyModel> &, const QTransform &from,
+                 const TransformKind);
+  void addModel(const QSharedPointer<ShapelyModel> &, const int row);
+  void removeModel(const QSharedPointer<ShapelyModel> &, const int row);
+  void seal() noexcept;
+  // ^ Whatever's being dragged was dropped; the next move is a new edit
+  ////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * Reverts the last edit, or re-applies the last one reverted.
+   *
+   * @return That edit (valid until the next call that changes the history),
+   * or nullptr if there's nothing to undo or redo
+   */
+  const Edit *undo();
+  const Edit *redo();
+
+  bool canUndo() const noexcept { return this->_done > 0; }
+  bool canRedo() const noexcept { return this->_done < this->_edits.size(); }
+  void clear() noexcept;
+  // ^ Forgets everything, e.g. because every model was replaced
+
+  std::size_t size() const noexcept { return this->_edits.size(); }
+  std::size_t bytes() const noexcept { return this->_bytes; }
+  std::size_t budget() const noexcept { return this->_budget; }
+
+private:
+  struct Matrices {
+    QTransform from;
+    QTransform to;
+  };
+
+  Edit *_open(const QSharedPointer<ShapelyModel> &, const Kind,
+              const int index) noexcept;
+  void _push(const Edit &);
+  void _truncate() noexcept;
+  void _trim() noexcept;
+
+  std::deque<Edit> _edits;
+  // ^ Oldest first; the first _done can be undone, and the rest redone
+  std::deque<Matrices> _transforms;
+  // ^ One for each Transform edit, in the same order
+  std::size_t _done;
+  std::size_t _transformsDone;
+  // ^ How many of _transforms belong to the first _done edits
+  std::size_t _bytes;
+  std::size_t _budget;
+  bool _sealed;
+  Listener _listener;
+};
+
+#endif // EDITHISTORY_HPP
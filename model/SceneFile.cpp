@@ -0,0 +1,305 @@
+#include "SceneFile.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <QByteArray>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include "ShapelyModel.hpp"
+
+constexpr char MAGIC[8] = {'S', 'H', 'A', 'P', 'E', 'L', 'Y', '\0'};
+constexpr quint32 VERSION = 1;
+constexpr qint64 ALIGNMENT = 8;
+constexpr quint32 CHECKED = 1;
+constexpr quint32 SIMPLE = 2;
+// ^ Record flags
+
+static_assert(sizeof(QPointF) == 2 * sizeof(double),
+              "Vertices are mapped straight into QPointFs, so qreal has to "
+              "be double");
+
+struct Header {
+  char magic[8];
+  quint32 version;
+  quint32 modelCount;
+  quint64 tableOffset;
+  quint64 fileSize;
+};
+
+struct Record {
+  quint64 verticesOffset;
+  quint64 vertexCount;
+  quint64 nameOffset;
+  quint32 nameSize;
+  float zoom;
+  double transform[9];
+  // ^ m11, m12, m13, m21, m22, m23, m31, m32, m33
+  double cameraCoords[2];
+  quint32 flags;
+  // ^ CHECKED if SIMPLE says whether the polygon was simple when it was saved;
+  // files from before there were flags have neither
+  quint32 reserved;
+};
+
+static_assert(sizeof(Header) == 32, "Header must have no padding");
+static_assert(sizeof(Record) == 128, "Record must have no padding");
+
+static qint64 align(const qint64 offset) noexcept {
+  return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+/**
+ * Reads a T stored little-endian at p, which may not be aligned for it.
+ */
+template <class T> static T read(const uchar *p) noexcept {
+  return qFromLittleEndian<T>(p);
+}
+
+template <> double read<double>(const uchar *p) noexcept {
+  quint64 bits = qFromLittleEndian<quint64>(p);
+  double d;
+  std::memcpy(&d, &bits, sizeof(d));
+  return d;
+}
+
+template <> float read<float>(const uchar *p) noexcept {
+  quint32 bits = qFromLittleEndian<quint32>(p);
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+template <class T> static void write(uchar *p, const T value) noexcept {
+  qToLittleEndian<T>(value, p);
+}
+
+template <> void write<double>(uchar *p, const double value) noexcept {
+  quint64 bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  qToLittleEndian<quint64>(bits, p);
+}
+
+template <> void write<float>(uchar *p, const float value) noexcept {
+  quint32 bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  qToLittleEndian<quint32>(bits, p);
+}
+
+SceneFile::SceneFile(const QString &path)
+    : _file(path), _data(nullptr), _size(0), _count(0) {
+  using std::ostringstream;
+  using std::runtime_error;
+
+  if (Q_BYTE_ORDER != Q_LITTLE_ENDIAN) {
+    throw runtime_error("Scene files can only be mapped on little-endian "
+                        "machines");
+  }
+
+  if (!this->_file.open(QIODevice::ReadOnly)) {
+    ostringstream e;
+    e << "Could not open " << path.toStdString() << ": "
+      << this->_file.errorString().toStdString();
+    throw runtime_error(e.str());
+  }
+
+  this->_size = this->_file.size();
+  if (this->_size < static_cast<qint64>(sizeof(Header))) {
+    throw runtime_error("Not a scene file (too short)");
+  }
+
+  this->_data = this->_file.map(0, this->_size);
+  if (!this->_data) {
+    ostringstream e;
+    e << "Could not map " << path.toStdString() << ": "
+      << this->_file.errorString().toStdString();
+    throw runtime_error(e.str());
+  }
+
+  const uchar *header = this->_data;
+  if (std::memcmp(header + offsetof(Header, magic), MAGIC, sizeof(MAGIC))) {
+    throw runtime_error("Not a scene file (bad magic number)");
+  }
+
+  quint32 version = read<quint32>(header + offsetof(Header, version));
+  if (version != VERSION) {
+    ostringstream e;
+    e << "Unsupported scene file version " << version;
+    throw runtime_error(e.str());
+  }
+
+  quint64 size = this->_size;
+  quint64 count = read<quint32>(header + offsetof(Header, modelCount));
+  quint64 table = read<quint64>(header + offsetof(Header, tableOffset));
+  if (read<quint64>(header + offsetof(Header, fileSize)) != size) {
+    throw runtime_error("Scene file is truncated");
+  }
+
+  if (table > size || count > (size - table) / sizeof(Record) ||
+      count > quint64(std::numeric_limits<int>::max())) {
+    throw runtime_error("Scene file's model table is out of bounds");
+  }
+
+  this->_count = count;
+  for (quint64 i = 0; i < count; ++i) {
+    const uchar *r = this->_data + table + i * sizeof(Record);
+    quint64 vertices = read<quint64>(r + offsetof(Record, verticesOffset));
+    quint64 n = read<quint64>(r + offsetof(Record, vertexCount));
+    quint64 name = read<quint64>(r + offsetof(Record, nameOffset));
+    quint64 nameSize = read<quint32>(r + offsetof(Record, nameSize));
+
+    if (vertices % ALIGNMENT || vertices > size ||
+        n > (size - vertices) / sizeof(QPointF) ||
+        n > quint64(std::numeric_limits<int>::max()) || name > size ||
+        nameSize > size - name) {
+      ostringstream e;
+      e << "Scene file's model #" << i << " is out of bounds";
+      throw runtime_error(e.str());
+    }
+  }
+  // ^ Checked once here, so model() doesn't have to
+}
+
+SceneFile::~SceneFile() {
+  if (this->_data) {
+    this->_file.unmap(const_cast<uchar *>(this->_data));
+  }
+}
+
+SceneFile::Model SceneFile::model(const int index) const {
+  Q_ASSERT(0 <= index && index < this->_count);
+
+  quint64 table = read<quint64>(this->_data + offsetof(Header, tableOffset));
+  const uchar *r = this->_data + table + index * sizeof(Record);
+
+  Model model;
+  model.name = QString::fromUtf8(
+      reinterpret_cast<const char *>(
+          this->_data + read<quint64>(r + offsetof(Record, nameOffset))),
+      read<quint32>(r + offsetof(Record, nameSize)));
+
+  const uchar *m = r + offsetof(Record, transform);
+  double t[9];
+  for (int j = 0; j < 9; ++j) {
+    t[j] = read<double>(m + j * sizeof(double));
+  }
+  model.transform =
+      QTransform(t[0], t[1], t[2], t[3], t[4], t[5], t[6], t[7], t[8]);
+
+  const uchar *c = r + offsetof(Record, cameraCoords);
+  model.cameraCoords = QPointF(read<double>(c), read<double>(c + 8));
+  model.zoom = read<float>(r + offsetof(Record, zoom));
+
+  model.vertices = reinterpret_cast<const QPointF *>(
+      this->_data + read<quint64>(r + offsetof(Record, verticesOffset)));
+  model.vertexCount = read<quint64>(r + offsetof(Record, vertexCount));
+  // ^ Aligned, and already in QPointF's layout on a little-endian machine
+
+  quint32 flags = read<quint32>(r + offsetof(Record, flags));
+  model.checked = flags & CHECKED;
+  model.simple = flags & SIMPLE;
+
+  return model;
+}
+
+QPolygonF SceneFile::Model::polygon() const {
+  QPolygonF polygon(this->vertexCount);
+  if (this->vertexCount) {
+    std::memcpy(polygon.data(), this->vertices,
+                this->vertexCount * sizeof(QPointF));
+  }
+  return polygon;
+}
+
+void SceneFile::save(const QString &path,
+                     const QVector<QSharedPointer<ShapelyModel>> &models) {
+  using std::ostringstream;
+  using std::runtime_error;
+
+  if (Q_BYTE_ORDER != Q_LITTLE_ENDIAN) {
+    throw runtime_error("Scene files can only be written on little-endian "
+                        "machines");
+  }
+
+  int count = models.size();
+  std::vector<QByteArray> names;
+  names.reserve(count);
+
+  qint64 offset = sizeof(Header) + count * sizeof(Record);
+  std::vector<uchar> table(offset, 0);
+  // ^ The header, then the model table
+
+  for (int i = 0; i < count; ++i) {
+    names.push_back(models[i]->name.toUtf8());
+    uchar *r = table.data() + sizeof(Header) + i * sizeof(Record);
+    write<quint64>(r + offsetof(Record, nameOffset), offset);
+    write<quint32>(r + offsetof(Record, nameSize), names[i].size());
+    offset += names[i].size();
+  }
+
+  for (int i = 0; i < count; ++i) {
+    const ShapelyModel &model = *models[i];
+    const QTransform &t = model.transform;
+    uchar *r = table.data() + sizeof(Header) + i * sizeof(Record);
+
+    offset = align(offset);
+    write<quint64>(r + offsetof(Record, verticesOffset), offset);
+    write<quint64>(r + offsetof(Record, vertexCount), model.vertexCount());
+    offset += model.vertexCount() * sizeof(QPointF);
+    write<quint32>(r + offsetof(Record, flags),
+                   CHECKED | (model.isSimple() ? SIMPLE : 0));
+
+    write<float>(r + offsetof(Record, zoom), model.zoom);
+    const double m[9] = {t.m11(), t.m12(), t.m13(), t.m21(), t.m22(),
+                         t.m23(), t.m31(), t.m32(), t.m33()};
+    for (int j = 0; j < 9; ++j) {
+      write<double>(r + offsetof(Record, transform) + j * sizeof(double), m[j]);
+    }
+    write<double>(r + offsetof(Record, cameraCoords), model.cameraCoords.x());
+    write<double>(r + offsetof(Record, cameraCoords) + sizeof(double),
+                  model.cameraCoords.y());
+  }
+
+  uchar *header = table.data();
+  std::memcpy(header + offsetof(Header, magic), MAGIC, sizeof(MAGIC));
+  write<quint32>(header + offsetof(Header, version), VERSION);
+  write<quint32>(header + offsetof(Header, modelCount), count);
+  write<quint64>(header + offsetof(Header, tableOffset), sizeof(Header));
+  write<quint64>(header + offsetof(Header, fileSize), offset);
+
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    ostringstream e;
+    e << "Could not open " << path.toStdString() << ": "
+      << file.errorString().toStdString();
+    throw runtime_error(e.str());
+  }
+
+  const char padding[ALIGNMENT] = {};
+  bool ok = file.write(reinterpret_cast<const char *>(table.data()),
+                       table.size()) >= 0;
+  for (const QByteArray &name : names) {
+    ok = ok && file.write(name) >= 0;
+  }
+  for (const QSharedPointer<ShapelyModel> &model : models) {
+    qint64 pad = align(file.pos()) - file.pos();
+    ok = ok && file.write(padding, pad) >= 0;
+    ok = ok &&
+         file.write(reinterpret_cast<const char *>(model->vertexData()),
+                    model->vertexCount() * sizeof(QPointF)) >= 0;
+    // ^ Already little-endian (x, y) doubles, even if they're still mapped from
+    // the file being replaced
+  }
+
+  if (!ok || !file.commit()) {
+    ostringstream e;
+    e << "Could not write " << path.toStdString() << ": "
+      << file.errorString().toStdString();
+    throw runtime_error(e.str());
+  }
+}
@@ -0,0 +1,77 @@
+#ifndef SCENEFILE_HPP
+#define SCENEFILE_HPP
+
+#include <QFile>
+#include <QPointF>
+#include <QPolygonF>
+#include <QSharedPointer>
+#include <QString>
+#include <QTransform>
+#include <QVector>
+
+struct ShapelyModel;
+
+/**
+ * A saved scene, read through a memory map so that opening it costs about the
+ * same however many vertices it has.
+ *
+ * The format is little-endian throughout:
+ *
+ *   header       magic "SHAPELY\0", version, model count, offset of the model
+ *                table, and the size of the whole file
+ *   model table  one fixed-size record per model: where its vertices and name
+ *                are, how many vertices it has, its zoom, transform, and
+ *                camera coordinates, and whether it's simple
+ *   names        UTF-8, back to back
+ *   vertices     each model's vertices as (x, y) doubles, back to back, and
+ *                8-byte aligned; i.e. exactly how a QPolygonF stores them
+ *
+ * The constructor only checks that the header and table are consistent; no
+ * vertex is touched until someone asks for it, and the OS pages them in as
+ * they're read.  Models can keep drawing from the mapped vertices for as long
+ * as they hold a reference to the SceneFile.
+ */
+class SceneFile {
+public:
+  /**
+   * One model in the file.  vertices points straight into the mapped file,
+   * and is only valid as long as the SceneFile is.
+   */
+  struct Model {
+    QString name;
+    QTransform transform;
+    QPointF cameraCoords;
+    float zoom;
+    const QPointF *vertices;
+    int vertexCount;
+    bool checked;
+    bool simple;
+    // ^ Whether the polygon was simple when it was saved, if the file says
+    // (checked); older files don't
+
+    QPolygonF polygon() const;
+    // ^ A copy of the vertices, in one memcpy
+  };
+
+  explicit SceneFile(const QString &path);
+  // ^ Throws std::runtime_error if the file can't be mapped or isn't a scene
+  ~SceneFile();
+
+  int size() const noexcept { return this->_count; }
+  Model model(const int index) const;
+
+  /**
+   * Writes models to path, replacing it only once the whole scene is written.
+   * Throws std::runtime_error if it couldn't.
+   */
+  static void save(const QString &path,
+                   const QVector<QSharedPointer<ShapelyModel>> &models);
+
+private:
+  QFile _file;
+  const uchar *_data;
+  qint64 _size;
+  int _count;
+};
+
+#endif // SCENEFILE_HPP
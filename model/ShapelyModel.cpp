@@ -1 +1,95 @@
 #include "ShapelyModel.hpp"
+
+#include <cstring>
+
+void ShapelyModel::setPolygon(const QPolygonF &polygon) {
+  this->polygon = polygon;
+  this->_mapped = nullptr;
+  this->_mappedCount = 0;
+  this->simplicity.reset(polygon);
+  this->vertices.reset(polygon);
+  this->_tracked = true;
+  ++this->revision;
+}
+
+void ShapelyModel::appendVertex(const QPointF &point) {
+  this->track();
+  this->polygon.append(point);
+  this->simplicity.appendVertex(point);
+  this->vertices.appendVertex(point);
+  ++this->revision;
+}
+
+void ShapelyModel::insertVertex(const int index, const QPointF &point) {
+  this->track();
+  this->polygon.insert(index, point);
+  this->simplicity.insertVertex(index, point);
+  this->vertices.insertVertex(index, point);
+  ++this->revision;
+}
+
+void ShapelyModel::moveVertex(const int index, const QPointF &point) {
+  this->track();
+  this->polygon[index] = point;
+  this->simplicity.moveVertex(index, point);
+  this->vertices.moveVertex(index, point);
+  ++this->revision;
+}
+
+void ShapelyModel::removeVertex(const int index) {
+  this->track();
+  this->polygon.remove(index);
+  this->simplicity.removeVertex(index);
+  this->vertices.removeVertex(index);
+  ++this->revision;
+}
+
+void ShapelyModel::setMapped(const QSharedPointer<const SceneFile> &file,
+                             const QPointF *vertices, const int count,
+                             const bool simple) {
+  this->polygon.clear();
+  this->_file = file;
+  this->_mapped = vertices;
+  this->_mappedCount = count;
+  this->simplicity.reset(this->polygon);
+  this->vertices.reset(this->polygon);
+  this->_tracked = false;
+  this->_simple = simple;
+  ++this->revision;
+}
+
+void ShapelyModel::load() {
+  if (!this->_mapped)
+    return;
+
+  this->polygon.resize(this->_mappedCount);
+  if (this->_mappedCount) {
+    std::memcpy(this->polygon.data(), this->_mapped,
+                this->_mappedCount * sizeof(QPointF));
+  }
+  this->_mapped = nullptr;
+  this->_mappedCount = 0;
+  // ^ Same vertices, so revision stays put
+}
+
+void ShapelyModel::track() {
+  if (this->_tracked)
+    return;
+
+  this->load();
+  this->simplicity.reset(this->polygon);
+  this->vertices.reset(this->polygon);
+  this->_tracked = true;
+}
+
+bool ShapelyModel::isSimple() const noexcept {
+  return this->_tracked ? this->simplicity.isSimple() : this->_simple;
+}
+
+int ShapelyModel::vertexCount() const noexcept {
+  return this->_mapped ? this->_mappedCount : this->polygon.size();
+}
+
+const QPointF *ShapelyModel::vertexData() const noexcept {
+  return this->_mapped ? this->_mapped : this->polygon.constData();
+}
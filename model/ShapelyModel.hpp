@@ -7,12 +7,62 @@
 #include <QString>
 #include <QTransform>
 
+#include "geometry/SimplicityTracker.hpp"
+#include "geometry/VertexIndex.hpp"
+
+class SceneFile;
+
 struct ShapelyModel {
   QPolygonF polygon;
   QPointF cameraCoords;
   QTransform transform;
   QString name;
   float zoom;
+
+  SimplicityTracker simplicity;
+  VertexIndex vertices;
+  // ^ Kept in sync with polygon by the functions below, once track() has
+  // built them; if you change polygon any other way, call setPolygon()
+  // afterwards
+  unsigned revision = 0;
+  // ^ Bumped by each of the functions below, so renderers that cache the
+  // polygon can tell when theirs is stale
+
+  void setPolygon(const QPolygonF &);
+  void appendVertex(const QPointF &);
+  void insertVertex(const int index, const QPointF &);
+  void moveVertex(const int index, const QPointF &);
+  void removeVertex(const int index);
+
+  /**
+   * Shows count vertices straight from an opened scene, without copying them
+   * or building the trackers; simple is what the file says about them.
+   * polygon stays empty until load().
+   */
+  void setMapped(const QSharedPointer<const SceneFile> &, const QPointF *,
+                 const int count, const bool simple);
+  void load();
+  // ^ Copies the mapped vertices into polygon, if they aren't already; for
+  // showing the model in the canvas
+  void track();
+  // ^ Loads it, and builds simplicity and vertices if they aren't already; for
+  // editing it (the edits above do this themselves)
+
+  bool isSimple() const noexcept;
+  // ^ simplicity's answer, or the scene file's if it isn't built yet
+  int vertexCount() const noexcept;
+  const QPointF *vertexData() const noexcept;
+  // ^ polygon's, or the mapped ones if it isn't loaded yet
+
+private:
+  QSharedPointer<const SceneFile> _file;
+  // ^ Kept even once it's loaded, since the scene renderer's pipeline may
+  // still be reading the mapped vertices
+  const QPointF *_mapped = nullptr;
+  int _mappedCount = 0;
+  bool _tracked = true;
+  bool _simple = false;
+  // ^ What the scene file said, until the trackers are built
 };
 
 Q_DECLARE_METATYPE(QSharedPointer<ShapelyModel>)
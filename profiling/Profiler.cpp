@@ -0,0 +1,226 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+
+#include <QFile>
+#include <QOpenGLTimerQuery>
+#include <QStringList>
+#include <QTextStream>
+
+constexpr int NONE = -1;
+constexpr int WINDOW = 512;
+// ^ Samples per phase that the percentiles are taken over
+constexpr int GPU_QUERIES = 4;
+// ^ Frames the GPU can be behind before we stop timing some of them
+
+Profiler::Scope::Scope(Profiler *profiler, const Phase phase) noexcept
+    : _profiler(profiler), _phase(phase) {
+  if (profiler) {
+    this->_timer.start();
+  }
+}
+
+Profiler::Scope::~Scope() {
+  if (this->_profiler) {
+    this->_profiler->record(this->_phase, this->_timer.nsecsElapsed());
+  }
+}
+
+Profiler::Profiler() : _current(NONE), _scratch(0), _scratchPeak(0) {
+  for (int p = 0; p < PHASES; ++p) {
+    this->_windows[p].reserve(WINDOW);
+    this->_next[p] = 0;
+  }
+}
+
+Profiler::~Profiler() {}
+
+const char *Profiler::name(const Phase phase) noexcept {
+  switch (phase) {
+  case UpdateData:
+    return "Update data";
+  case UpdateView:
+    return "Update view";
+  case Simplicity:
+    return "Simplicity";
+  case Rasterize:
+    return "Rasterize";
+  case Triangulate:
+    return "Triangulate";
+  case Upload:
+    return "Upload";
+  case Draw:
+    return "Draw";
+  case Frame:
+    return "Frame";
+  case Gpu:
+    return "GPU";
+  default:
+    return "?";
+  }
+}
+
+void Profiler::record(const Phase phase, const qint64 nanoseconds) noexcept {
+  this->_rings[phase].push(nanoseconds);
+}
+
+void Profiler::recordScratch(const std::size_t bytes) noexcept {
+  this->_scratch = bytes;
+
+  std::size_t peak = this->_scratchPeak;
+  while (bytes > peak && !this->_scratchPeak.compare_exchange_weak(peak, bytes))
+    ;
+  // ^ Renderers may be reporting from more than one pipeline
+}
+
+bool Profiler::initializeGpu() {
+  this->releaseGpu();
+
+  for (int i = 0; i < GPU_QUERIES; ++i) {
+    std::unique_ptr<QOpenGLTimerQuery> query(new QOpenGLTimerQuery);
+    if (!query->create()) {
+      this->_queries.clear();
+      return false;
+    }
+    this->_queries.push_back(std::move(query));
+  }
+
+  this->_pending.assign(GPU_QUERIES, false);
+  return true;
+}
+
+void Profiler::releaseGpu() {
+  for (std::unique_ptr<QOpenGLTimerQuery> &query : this->_queries) {
+    query->destroy();
+  }
+
+  this->_queries.clear();
+  this->_pending.clear();
+  this->_current = NONE;
+}
+
+void Profiler::beginGpu() {
+  this->_pollGpu();
+
+  int n = this->_queries.size();
+  for (int i = 0; i < n; ++i) {
+    if (!this->_pending[i]) {
+      this->_current = i;
+      this->_queries[i]->begin();
+      return;
+    }
+  }
+  // ^ If they're all still waiting on the GPU, don't time this frame
+}
+
+void Profiler::endGpu() {
+  if (this->_current == NONE)
+    return;
+
+  this->_queries[this->_current]->end();
+  this->_pending[this->_current] = true;
+  this->_current = NONE;
+}
+
+/**
+ * Records the result of every query that has one, without waiting for the
+ * ones that don't.
+ */
+void Profiler::_pollGpu() {
+  int n = this->_queries.size();
+  for (int i = 0; i < n; ++i) {
+    if (this->_pending[i] && this->_queries[i]->isResultAvailable()) {
+      this->record(Gpu, this->_queries[i]->waitForResult());
+      // ^ Doesn't actually wait, since it's available
+      this->_pending[i] = false;
+    }
+  }
+}
+
+void Profiler::_collect() {
+  for (int p = 0; p < PHASES; ++p) {
+    std::vector<qint64> &window = this->_windows[p];
+    int &next = this->_next[p];
+
+    this->_rings[p].drain([&window, &next](const qint64 sample) {
+      if (static_cast<int>(window.size()) < WINDOW) {
+        window.push_back(sample);
+      } else {
+        window[next] = sample;
+        next = (next + 1) % WINDOW;
+      }
+    });
+  }
+}
+
+Profiler::Stats Profiler::stats(const Phase phase) {
+  this->_collect();
+
+  std::vector<qint64> samples = this->_windows[phase];
+  int n = samples.size();
+  Stats stats{n, 0, 0, 0};
+  if (n == 0)
+    return stats;
+
+  auto percentile = [&samples, n](const int p) {
+    auto nth = samples.begin() + std::min(n - 1, p * n / 100);
+    std::nth_element(samples.begin(), nth, samples.end());
+    return *nth;
+  };
+
+  stats.p50 = percentile(50);
+  stats.p95 = percentile(95);
+  stats.p99 = percentile(99);
+  return stats;
+}
+
+QString Profiler::summary() {
+  QStringList phases;
+
+  for (int p = 0; p < PHASES; ++p) {
+    Stats s = this->stats(static_cast<Phase>(p));
+    if (s.count == 0)
+      continue;
+
+    phases << QString("%1 %2/%3/%4")
+                  .arg(name(static_cast<Phase>(p)))
+                  .arg(s.p50 / 1e6, 0, 'f', 2)
+                  .arg(s.p95 / 1e6, 0, 'f', 2)
+                  .arg(s.p99 / 1e6, 0, 'f', 2);
+  }
+
+  if (phases.isEmpty())
+    return QString();
+
+  QString summary = "p50/p95/p99 ms: " + phases.join("  |  ");
+  if (this->_scratchPeak) {
+    summary += QString("  |  scratch %1/%2 KiB")
+                   .arg(this->_scratch / 1024)
+                   .arg(this->_scratchPeak / 1024);
+  }
+  return summary;
+}
+
+bool Profiler::exportCsv(const QString &path) {
+  this->_collect();
+
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    return false;
+
+  QTextStream out(&file);
+  out << "phase,sample,nanoseconds\n";
+
+  for (int p = 0; p < PHASES; ++p) {
+    const std::vector<qint64> &window = this->_windows[p];
+    int n = window.size();
+    int oldest = (n < WINDOW) ? 0 : this->_next[p];
+
+    for (int i = 0; i < n; ++i) {
+      out << name(static_cast<Phase>(p)) << ',' << i << ','
+          << window[(oldest + i) % n] << '\n';
+    }
+  }
+
+  return out.status() == QTextStream::Ok;
+}
@@ -0,0 +1,116 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QtGlobal>
+
+#include "SampleRing.hpp"
+
+class QOpenGLTimerQuery;
+
+/**
+ * Collects how long each phase of editing and drawing takes, so we can tell
+ * whether a slowdown is on the CPU (e.g. rasterization) or the GPU (fill).
+ *
+ * CPU phases are timed with Scope, which pushes a sample into a lock-free ring
+ * for that phase.  GPU time is measured with a small pool of timer queries
+ * around each frame; results are only read once the GPU says they're ready,
+ * so measuring never stalls the pipeline (it just reports a few frames late,
+ * and skips frames if the GPU falls too far behind).
+ *
+ * Reading statistics drains the rings into a rolling window of the most recent
+ * samples per phase, from which the percentiles are taken.
+ */
+class Profiler {
+public:
+  enum Phase {
+    UpdateData,
+    UpdateView,
+    Simplicity,
+    Rasterize,
+    Triangulate,
+    Upload,
+    Draw,
+    Frame,
+    Gpu,
+    PHASES
+  };
+
+  struct Stats {
+    int count;
+    qint64 p50;
+    qint64 p95;
+    qint64 p99;
+    // ^ In nanoseconds
+  };
+
+  /**
+   * Times from construction to destruction.  Does nothing if the profiler is
+   * null, so instrumented code doesn't have to care whether anyone's watching.
+   */
+  class Scope {
+  public:
+    Scope(Profiler *profiler, const Phase phase) noexcept;
+    ~Scope();
+
+  private:
+    Profiler *_profiler;
+    Phase _phase;
+    QElapsedTimer _timer;
+  };
+
+  Profiler();
+  ~Profiler();
+
+  static const char *name(const Phase) noexcept;
+
+  void record(const Phase, const qint64 nanoseconds) noexcept;
+  void recordScratch(const std::size_t bytes) noexcept;
+  // ^ How much scratch memory a frame just took (see FrameArena).  Unlike
+  // record(), whose ring for each phase takes samples from one thread only,
+  // this is safe to call from any thread
+  std::size_t scratchBytes() const noexcept { return this->_scratch; }
+  std::size_t scratchPeak() const noexcept { return this->_scratchPeak; }
+  // ^ The last frame's, and the most any frame has taken
+
+  bool initializeGpu();
+  // ^ Needs a current context; false if timer queries aren't supported
+  void releaseGpu();
+  // ^ Also needs a current context
+  void beginGpu();
+  void endGpu();
+
+  Stats stats(const Phase);
+  QString summary();
+  // ^ p50/p95/p99 of every phase that has samples, for the status bar
+  bool exportCsv(const QString &path);
+  // ^ Every sample in the rolling windows, one per line
+
+private:
+  static constexpr unsigned RING_SIZE = 1024;
+
+  void _collect();
+  void _pollGpu();
+
+  SampleRing<qint64, RING_SIZE> _rings[PHASES];
+  std::vector<qint64> _windows[PHASES];
+  int _next[PHASES];
+  // ^ Where the next sample goes in each (circular) window, once it's full
+
+  std::vector<std::unique_ptr<QOpenGLTimerQuery>> _queries;
+  std::vector<bool> _pending;
+  // ^ Whether each query has a result on the way
+  int _current;
+  // ^ The query timing this frame, if any
+
+  std::atomic<std::size_t> _scratch;
+  std::atomic<std::size_t> _scratchPeak;
+};
+
+#endif // PROFILER_HPP
@@ -0,0 +1,61 @@
+#ifndef SAMPLERING_HPP
+#define SAMPLERING_HPP
+
+#include <array>
+#include <atomic>
+
+/**
+ * A fixed-size single-producer, single-consumer queue that never locks or
+ * allocates, so timing code can push into it without perturbing what it's
+ * timing.  If the consumer falls behind and the ring fills up, new samples are
+ * dropped rather than blocking the producer.
+ *
+ * N must be a power of two.
+ */
+template <class T, unsigned N> class SampleRing {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+  SampleRing() noexcept : _head(0), _tail(0) {}
+
+  /**
+   * Producer only.
+   *
+   * @return false if the ring was full and the sample was dropped
+   */
+  bool push(const T &item) noexcept {
+    unsigned head = this->_head.load(std::memory_order_relaxed);
+    if (head - this->_tail.load(std::memory_order_acquire) == N)
+      return false;
+
+    this->_items[head % N] = item;
+    this->_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Consumer only.  Calls f(item) for everything pushed so far, oldest first.
+   *
+   * @return How many items there were
+   */
+  template <class F> int drain(F f) {
+    unsigned tail = this->_tail.load(std::memory_order_relaxed);
+    unsigned head = this->_head.load(std::memory_order_acquire);
+
+    for (unsigned i = tail; i != head; ++i) {
+      f(this->_items[i % N]);
+    }
+
+    this->_tail.store(head, std::memory_order_release);
+    return head - tail;
+  }
+
+private:
+  std::array<T, N> _items;
+  std::atomic<unsigned> _head;
+  // ^ Next slot to write; only the producer changes it
+  std::atomic<unsigned> _tail;
+  // ^ Next slot to read; only the consumer changes it
+};
+
+#endif // SAMPLERING_HPP
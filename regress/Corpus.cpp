@@ -0,0 +1,53 @@
+#include "Corpus.hpp"
+
+#include <cstring>
+
+#include "bench/Shapes.hpp"
+
+constexpr double RADIUS = 200;
+// ^ In world units; the harness's viewport shows a bit more than this
+
+static QPolygonF shape(const char *name, const int n) {
+  for (int s = 0; s < SHAPE_COUNT; ++s) {
+    if (std::strcmp(SHAPES[s].name, name) == 0) {
+      return QTransform::fromScale(RADIUS, RADIUS).map(SHAPES[s].make(n));
+    }
+  }
+
+  Q_ASSERT(false);
+  return QPolygonF();
+}
+
+std::vector<Case> corpus() {
+  QPolygonF triangle;
+  triangle << QPointF(-150, -100) << QPointF(150, -100) << QPointF(0, 150);
+
+  QPolygonF square;
+  square << QPointF(-100, -100) << QPointF(100, -100) << QPointF(100, 100)
+         << QPointF(-100, 100);
+
+  QPolygonF bowtie;
+  bowtie << QPointF(-150, -150) << QPointF(150, 150) << QPointF(150, -150)
+         << QPointF(-150, 150);
+  // ^ Self-intersecting, so only the outline is drawn
+
+  QTransform rotated;
+  rotated.rotate(30);
+  rotated.scale(1.5, 0.75);
+
+  return {
+      {"triangle", triangle, QTransform(), QPointF()},
+      {"octagon", shape("regular", 8), QTransform(), QPointF()},
+      {"star-24", shape("star", 24), QTransform(), QPointF()},
+      {"comb-42", shape("comb", 42), QTransform(), QPointF()},
+      {"spiral-400", shape("spiral", 400), QTransform(), QPointF()},
+      {"walk-1000", shape("walk", 1000), QTransform(), QPointF()},
+      {"bowtie", bowtie, QTransform(), QPointF()},
+      {"rotated-square", square, rotated, QPointF()},
+      {"panned-star", shape("star", 24), QTransform(), QPointF(120, -80)},
+      // ^ Partly off-screen
+      {"circle-20000", shape("regular", 20000), QTransform(), QPointF()},
+      {"comb-2000", shape("comb", 2000), QTransform(), QPointF()},
+      // ^ Big enough that their timings mean something
+  };
+}
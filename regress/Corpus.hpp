@@ -0,0 +1,26 @@
+#ifndef CORPUS_HPP
+#define CORPUS_HPP
+
+#include <vector>
+
+#include <QPointF>
+#include <QPolygonF>
+#include <QTransform>
+
+/**
+ * One polygon the regression harness renders, and how it's viewed.
+ */
+struct Case {
+  const char *name;
+  QPolygonF polygon;
+  QTransform transform;
+  QPointF cameraCoords;
+};
+
+/**
+ * The fixed set of polygons the harness checks.  Never change a case in
+ * place; add a new one, so old goldens and timings stay comparable.
+ */
+std::vector<Case> corpus();
+
+#endif // CORPUS_HPP
@@ -0,0 +1,179 @@
+#include "Harness.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <QColor>
+#include <QElapsedTimer>
+#include <QOpenGLFramebufferObject>
+#include <QPair>
+#include <QSurfaceFormat>
+
+#include "Constants.hpp"
+#include "model/ShapelyModel.hpp"
+#include "profiling/Profiler.hpp"
+#include "renderer/MidpointRenderer.hpp"
+#include "renderer/ShaderRenderer.hpp"
+
+constexpr int MAJOR_VERSION = 3;
+constexpr int MINOR_VERSION = 2;
+constexpr int STENCIL_BITS = 8;
+// ^ As in ShapelyWidget
+constexpr int WARMUP = 2;
+
+constexpr Profiler::Phase PHASES[] = {Profiler::Rasterize,
+                                      Profiler::Triangulate, Profiler::Upload};
+
+Harness::Harness(const QSize &size)
+    : _size(size), _vbo(QOpenGLBuffer::VertexBuffer) {
+  using std::ostringstream;
+  using std::runtime_error;
+
+  QSurfaceFormat format;
+  format.setRenderableType(QSurfaceFormat::OpenGL);
+  format.setProfile(QSurfaceFormat::CoreProfile);
+  format.setVersion(MAJOR_VERSION, MINOR_VERSION);
+  format.setStencilBufferSize(STENCIL_BITS);
+
+  this->_surface.setFormat(format);
+  this->_surface.create();
+  this->_context.setFormat(format);
+
+  if (!this->_context.create()) {
+    throw runtime_error("Could not create an OpenGL context");
+  }
+
+  if (!this->_context.makeCurrent(&this->_surface)) {
+    throw runtime_error("Could not make the OpenGL context current");
+  }
+
+  QSurfaceFormat actual = this->_context.format();
+  if (actual.version() < qMakePair(MAJOR_VERSION, MINOR_VERSION)) {
+    ostringstream e;
+    e << "Need OpenGL " << MAJOR_VERSION << "." << MINOR_VERSION << ", got "
+      << actual.majorVersion() << "." << actual.minorVersion();
+    throw runtime_error(e.str());
+  }
+
+  this->initializeOpenGLFunctions();
+
+  QOpenGLFramebufferObjectFormat fboFormat;
+  fboFormat.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+  // ^ For the stencil fill modes
+  this->_fbo.reset(new QOpenGLFramebufferObject(size, fboFormat));
+  if (!this->_fbo->isValid()) {
+    ostringstream e;
+    e << "Could not create FBO (ID: " << this->_fbo->handle() << ")";
+    throw runtime_error(e.str());
+  }
+
+  if (!this->_vao.create()) {
+    ostringstream e;
+    e << "Could not create VAO (ID: " << this->_vao.objectId() << ")";
+    throw runtime_error(e.str());
+  }
+
+  if (!this->_vbo.create()) {
+    ostringstream e;
+    e << "Could not create VBO (ID: " << this->_vbo.bufferId() << ")";
+    throw runtime_error(e.str());
+  }
+  this->_vbo.setUsagePattern(QOpenGLBuffer::StreamDraw);
+}
+
+Harness::~Harness() {
+  this->_context.makeCurrent(&this->_surface);
+  this->_fbo.reset();
+  this->_vbo.destroy();
+  this->_vao.destroy();
+  this->_context.doneCurrent();
+}
+
+const char *Harness::name(const Renderer renderer) noexcept {
+  switch (renderer) {
+  case Shader:
+    return "shader";
+  case Midpoint:
+    return "midpoint";
+  default:
+    return "?";
+  }
+}
+
+QString Harness::glRenderer() {
+  this->_context.makeCurrent(&this->_surface);
+  return reinterpret_cast<const char *>(this->glGetString(GL_RENDERER));
+}
+
+AbstractRenderer *Harness::_create(const Renderer renderer) {
+  if (renderer == Shader) {
+    ShaderRenderer *r =
+        new ShaderRenderer(":/shader/shader.vert", ":/shader/shader.frag",
+                           &this->_context, this, &this->_vbo);
+    r->setMarkersVisible(false);
+    // ^ MidpointRenderer doesn't draw them, so they'd never compare equal
+    return r;
+  }
+
+  return new MidpointRenderer(":/shader/framebuffer.vert",
+                              ":/shader/framebuffer.frag", &this->_context,
+                              this, &this->_vbo);
+}
+
+Harness::Frame Harness::render(const Renderer kind, const ShapelyModel &model,
+                               const int reps) {
+  this->_context.makeCurrent(&this->_surface);
+  this->_fbo->bind();
+  this->_vao.bind();
+  this->_vbo.bind();
+  this->glViewport(0, 0, this->_size.width(), this->_size.height());
+
+  const QColor &background = Constants::BACKGROUND_COLOR;
+  this->glClearColor(background.redF(), background.greenF(),
+                     background.blueF(), 1);
+
+  std::unique_ptr<AbstractRenderer> renderer(this->_create(kind));
+  Profiler profiler;
+  renderer->updateSize(this->_size.width(), this->_size.height());
+
+  std::vector<qint64> times;
+  for (int i = 0; i < WARMUP + reps; ++i) {
+    renderer->setProfiler(i < WARMUP ? nullptr : &profiler);
+
+    QElapsedTimer timer;
+    timer.start();
+    this->glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    renderer->updateData(model);
+    renderer->updateView(model);
+    renderer->finish();
+    // ^ Otherwise we'd draw whatever the pipeline had finished so far
+    renderer->drawPolygon();
+    this->glFinish();
+    // ^ So the time includes the GPU's share
+
+    if (i >= WARMUP) {
+      times.push_back(timer.nsecsElapsed());
+    }
+  }
+
+  Frame frame;
+  std::nth_element(times.begin(), times.begin() + times.size() / 2,
+                   times.end());
+  frame.ms = times.empty() ? 0 : times[times.size() / 2] / 1e6;
+
+  for (Profiler::Phase phase : PHASES) {
+    Profiler::Stats stats = profiler.stats(phase);
+    if (stats.count) {
+      frame.phases[Profiler::name(phase)] = stats.p50 / 1e6;
+    }
+  }
+
+  frame.image = this->_fbo->toImage().convertToFormat(QImage::Format_RGB32);
+
+  renderer.reset();
+  // ^ While the context is still current
+  this->_fbo->release();
+  return frame;
+}
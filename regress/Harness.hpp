@@ -0,0 +1,62 @@
+#ifndef HARNESS_HPP
+#define HARNESS_HPP
+
+#include <memory>
+
+#include <QImage>
+#include <QJsonObject>
+#include <QOffscreenSurface>
+#include <QOpenGLBuffer>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QOpenGLVertexArrayObject>
+#include <QSize>
+
+class AbstractRenderer;
+class QOpenGLFramebufferObject;
+struct ShapelyModel;
+
+/**
+ * Drives the renderers without a window: an offscreen surface just to make a
+ * context current, and a framebuffer object to draw into and read back.  Set
+ * up the same way ShapelyWidget sets up its context, so this runs anywhere
+ * the editor does, including Mesa's llvmpipe with no GPU.
+ */
+class Harness : protected QOpenGLFunctions {
+public:
+  enum Renderer { Shader, Midpoint, RENDERERS };
+
+  struct Frame {
+    QImage image;
+    double ms;
+    // ^ Median time for a whole update and draw, GPU included
+    QJsonObject phases;
+    // ^ Median time of each phase the renderer reports to the profiler
+  };
+
+  Harness(const QSize &size);
+  // ^ Needs a QGuiApplication; throws if there's no usable OpenGL
+  ~Harness();
+
+  static const char *name(const Renderer) noexcept;
+  QString glRenderer();
+  // ^ e.g. "llvmpipe (LLVM 15.0.7, 256 bits)"
+
+  /**
+   * Updates and draws the model with the given renderer reps times (after a
+   * couple to warm up), and reads back the last frame.
+   */
+  Frame render(const Renderer, const ShapelyModel &, const int reps);
+
+private:
+  AbstractRenderer *_create(const Renderer);
+
+  QSize _size;
+  QOffscreenSurface _surface;
+  QOpenGLContext _context;
+  std::unique_ptr<QOpenGLFramebufferObject> _fbo;
+  QOpenGLBuffer _vbo;
+  QOpenGLVertexArrayObject _vao;
+};
+
+#endif // HARNESS_HPP
@@ -0,0 +1,62 @@
+#include "ImageDiff.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <QColor>
+
+static bool close(const QRgb a, const QRgb b, const int tolerance) noexcept {
+  return std::abs(qRed(a) - qRed(b)) <= tolerance &&
+         std::abs(qGreen(a) - qGreen(b)) <= tolerance &&
+         std::abs(qBlue(a) - qBlue(b)) <= tolerance;
+}
+
+/**
+ * @return Whether pixel (x, y) of a has a match within radius in b
+ */
+static bool matches(const QImage &a, const QImage &b, const int x, const int y,
+                    const int tolerance, const int radius) noexcept {
+  QRgb pixel = reinterpret_cast<const QRgb *>(a.constScanLine(y))[x];
+  int x0 = std::max(x - radius, 0);
+  int x1 = std::min(x + radius, b.width() - 1);
+  int y0 = std::max(y - radius, 0);
+  int y1 = std::min(y + radius, b.height() - 1);
+
+  for (int j = y0; j <= y1; ++j) {
+    const QRgb *row = reinterpret_cast<const QRgb *>(b.constScanLine(j));
+    for (int i = x0; i <= x1; ++i) {
+      if (close(pixel, row[i], tolerance))
+        return true;
+    }
+  }
+
+  return false;
+}
+
+ImageDiff diffImages(const QImage &first, const QImage &second,
+                     const int tolerance, const int radius) {
+  QImage a = first.convertToFormat(QImage::Format_RGB32);
+  QImage b = second.convertToFormat(QImage::Format_RGB32);
+  ImageDiff diff{0, a.width() * a.height(), a};
+
+  if (a.size() != b.size()) {
+    diff.mismatched = diff.pixels;
+    return diff;
+  }
+
+  for (int y = 0; y < a.height(); ++y) {
+    QRgb *out = reinterpret_cast<QRgb *>(diff.image.scanLine(y));
+    for (int x = 0; x < a.width(); ++x) {
+      if (matches(a, b, x, y, tolerance, radius) &&
+          matches(b, a, x, y, tolerance, radius)) {
+        QRgb p = out[x];
+        out[x] = qRgb(qRed(p) / 4, qGreen(p) / 4, qBlue(p) / 4);
+      } else {
+        out[x] = qRgb(255, 0, 0);
+        ++diff.mismatched;
+      }
+    }
+  }
+
+  return diff;
+}
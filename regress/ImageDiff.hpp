@@ -0,0 +1,30 @@
+#ifndef IMAGEDIFF_HPP
+#define IMAGEDIFF_HPP
+
+#include <QImage>
+
+/**
+ * How two renderings of the same thing differ.
+ */
+struct ImageDiff {
+  int mismatched;
+  int pixels;
+  QImage image;
+  // ^ The first image, dimmed, with the mismatched pixels in red
+
+  double fraction() const noexcept {
+    return this->pixels ? double(this->mismatched) / this->pixels : 1;
+  }
+};
+
+/**
+ * Compares two images pixel by pixel.  A pixel matches if some pixel within
+ * radius of it in the other image is within tolerance of it in every channel,
+ * both ways around; so a radius of 1 forgives edges that land one pixel over,
+ * which is all two correct rasterizers can be expected to agree on.  Images of
+ * different sizes don't match at all.
+ */
+ImageDiff diffImages(const QImage &a, const QImage &b, const int tolerance,
+                     const int radius);
+
+#endif // IMAGEDIFF_HPP
@@ -0,0 +1,242 @@
+#include <cstdio>
+#include <exception>
+#include <map>
+#include <memory>
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QGuiApplication>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QSize>
+#include <QString>
+
+#include "Corpus.hpp"
+#include "Harness.hpp"
+#include "ImageDiff.hpp"
+#include "model/ShapelyModel.hpp"
+
+constexpr int WIDTH = 256;
+constexpr int HEIGHT = 256;
+constexpr int REPS = 15;
+
+constexpr int CROSS_TOLERANCE = 8;
+constexpr int CROSS_RADIUS = 1;
+constexpr double CROSS_MISMATCH = 0.002;
+// ^ The two renderers rasterize edges differently, so they only have to agree
+// to within a pixel
+constexpr int GOLDEN_TOLERANCE = 2;
+constexpr int GOLDEN_RADIUS = 0;
+constexpr double GOLDEN_MISMATCH = 0.001;
+// ^ The same renderer on the same driver should be all but identical
+
+constexpr double THRESHOLD = 0.25;
+// ^ How much slower than the baseline a case can get before it fails
+constexpr double MIN_REGRESSION_MS = 0.5;
+// ^ Anything less is noise, however big it is relative to the baseline
+
+constexpr char TIMINGS_FILE[] = "timings.json";
+
+static QString key(const char *name, const Harness::Renderer renderer) {
+  return QString("%1-%2").arg(name).arg(Harness::name(renderer));
+}
+
+static std::map<QString, double> readBaseline(const QString &path) {
+  std::map<QString, double> baseline;
+  QFile file(path);
+  if (file.open(QIODevice::ReadOnly)) {
+    QJsonArray cases =
+        QJsonDocument::fromJson(file.readAll()).object()["cases"].toArray();
+    for (const QJsonValue &value : cases) {
+      QJsonObject c = value.toObject();
+      QString id = c["case"].toString() + "-" + c["renderer"].toString();
+      baseline[id] = c["ms"].toDouble();
+    }
+  }
+  return baseline;
+}
+
+static bool writeJson(const QString &path, const QJsonObject &object) {
+  QFile file(path);
+  return file.open(QIODevice::WriteOnly) &&
+         file.write(QJsonDocument(object).toJson()) >= 0;
+}
+
+/**
+ * Renders every case in the corpus with both renderers, then checks that they
+ * agree with each other, with the golden images, and with the baseline
+ * timings.  A missing golden image or baseline timing is a failure, not a
+ * skipped check.  Exits with 1 if any check failed, and with 2 if there's no
+ * OpenGL to run them on.
+ */
+int main(int argc, char *argv[]) {
+  if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
+  // ^ No display needed, unless one is asked for
+
+  QGuiApplication app(argc, argv);
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Renders a fixed set of polygons offscreen "
+                                   "and checks the results.");
+  parser.addHelpOption();
+
+  QCommandLineOption update("update",
+                            "Replace the golden images and baseline timings "
+                            "with this run's.");
+  QCommandLineOption goldens("goldens", "Where the golden images are.", "dir",
+                             GOLDEN_DIR);
+  QCommandLineOption output("output", "Where to put images that don't match.",
+                            "dir", "regress-output");
+  QCommandLineOption timings("timings", "Also write this run's timings here.",
+                             "file");
+  QCommandLineOption threshold("threshold",
+                               "Allowed slowdown over the baseline, e.g. 0.25 "
+                               "for 25%; negative to not check timings.",
+                               "fraction", QString::number(THRESHOLD));
+  QCommandLineOption reps("reps", "Frames to time per case.", "n",
+                          QString::number(REPS));
+  parser.addOptions({update, goldens, output, timings, threshold, reps});
+  parser.process(app);
+
+  QDir goldenDir(parser.value(goldens));
+  QDir outputDir(parser.value(output));
+  bool updating = parser.isSet(update);
+  double slowdown = parser.value(threshold).toDouble();
+  int frames = qMax(parser.value(reps).toInt(), 1);
+
+  std::unique_ptr<Harness> harness;
+  try {
+    harness.reset(new Harness(QSize(WIDTH, HEIGHT)));
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 2;
+  }
+
+  std::printf("OpenGL renderer: %s\n", qPrintable(harness->glRenderer()));
+
+  std::map<QString, double> baseline =
+      readBaseline(goldenDir.filePath(TIMINGS_FILE));
+  if (!updating && slowdown >= 0 && baseline.empty()) {
+    std::fprintf(stderr,
+                 "No baseline timings in %s; run with --update to record "
+                 "them, or with --threshold=-1 to not check timings\n",
+                 qPrintable(goldenDir.filePath(TIMINGS_FILE)));
+  }
+  // ^ Every case will fail for it, but this says why once
+  QJsonArray results;
+  int failures = 0;
+
+  auto save = [&outputDir](const QString &name, const QImage &image) {
+    outputDir.mkpath(".");
+    image.save(outputDir.filePath(name + ".png"));
+  };
+  auto fail = [&failures, &save](const QString &name, const ImageDiff &diff,
+                                 const QImage &actual) {
+    save(name, actual);
+    save(name + "-diff", diff.image);
+    ++failures;
+  };
+
+  try {
+    for (const Case &c : corpus()) {
+      ShapelyModel model;
+      model.name = c.name;
+      model.transform = c.transform;
+      model.cameraCoords = c.cameraCoords;
+      model.zoom = 1;
+      model.setPolygon(c.polygon);
+
+      Harness::Frame frame[Harness::RENDERERS];
+      for (int r = 0; r < Harness::RENDERERS; ++r) {
+        Harness::Renderer renderer = static_cast<Harness::Renderer>(r);
+        QString id = key(c.name, renderer);
+        frame[r] = harness->render(renderer, model, frames);
+
+        QJsonObject result;
+        result["case"] = c.name;
+        result["renderer"] = Harness::name(renderer);
+        result["vertices"] = c.polygon.size();
+        result["ms"] = frame[r].ms;
+        result["phases"] = frame[r].phases;
+        results.append(result);
+
+        std::printf("%-16s %-9s %8.2f ms", c.name, Harness::name(renderer),
+                    frame[r].ms);
+
+        if (updating) {
+          goldenDir.mkpath(".");
+          frame[r].image.save(goldenDir.filePath(id + ".png"));
+          std::printf("  updated\n");
+          continue;
+        }
+
+        QImage golden(goldenDir.filePath(id + ".png"));
+        if (golden.isNull()) {
+          std::printf("  FAILED: no golden image (run with --update)");
+          save(id, frame[r].image);
+          ++failures;
+          // ^ Saved so it can be looked at, and copied to the goldens if it's
+          // right
+        } else {
+          ImageDiff diff = diffImages(frame[r].image, golden, GOLDEN_TOLERANCE,
+                                      GOLDEN_RADIUS);
+          if (diff.fraction() > GOLDEN_MISMATCH) {
+            std::printf("  FAILED: %d pixels differ from golden",
+                        diff.mismatched);
+            fail(id, diff, frame[r].image);
+          }
+        }
+
+        if (slowdown >= 0) {
+          auto base = baseline.find(id);
+          double ms = frame[r].ms;
+          if (base == baseline.end()) {
+            std::printf("  FAILED: no baseline timing (run with --update)");
+            ++failures;
+          } else if (ms > base->second * (1 + slowdown) &&
+                     ms - base->second > MIN_REGRESSION_MS) {
+            std::printf("  FAILED: was %.2f ms", base->second);
+            ++failures;
+          }
+        }
+        std::printf("\n");
+      }
+
+      ImageDiff diff = diffImages(frame[Harness::Shader].image,
+                                  frame[Harness::Midpoint].image,
+                                  CROSS_TOLERANCE, CROSS_RADIUS);
+      if (diff.fraction() > CROSS_MISMATCH) {
+        std::printf("%-16s FAILED: renderers disagree on %d pixels\n", c.name,
+                    diff.mismatched);
+        fail(QString(c.name) + "-cross", diff, frame[Harness::Midpoint].image);
+      }
+    }
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  // ^ e.g. a shader that doesn't compile on this driver
+
+  QJsonObject document;
+  document["renderer"] = harness->glRenderer();
+  document["cases"] = results;
+
+  if (updating && !writeJson(goldenDir.filePath(TIMINGS_FILE), document)) {
+    std::fprintf(stderr, "Could not write %s\n", TIMINGS_FILE);
+    ++failures;
+  }
+
+  if (parser.isSet(timings) && !writeJson(parser.value(timings), document)) {
+    std::fprintf(stderr, "Could not write %s\n",
+                 qPrintable(parser.value(timings)));
+    ++failures;
+  }
+
+  std::printf("%d failed\n", failures);
+  return failures ? 1 : 0;
+}
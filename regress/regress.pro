@@ -0,0 +1,31 @@
+#-------------------------------------------------
+#
+# Headless rendering and performance regression checks
+#
+#-------------------------------------------------
+
+include(../shapely.pri)
+include(../core/core.pri)
+
+TARGET = ShapelyRegress
+TEMPLATE = app
+
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += GOLDEN_DIR=\\\"$$PWD/golden\\\"
+
+SOURCES += main.cpp \
+    Corpus.cpp \
+    Harness.cpp \
+    ImageDiff.cpp \
+    ../bench/Shapes.cpp
+
+HEADERS += \
+    Corpus.hpp \
+    Harness.hpp \
+    ImageDiff.hpp \
+    ../bench/Shapes.hpp
+
+RESOURCES += \
+    ../resources.qrc
@@ -5,9 +5,10 @@
 
 AbstractRenderer::AbstractRenderer(QOpenGLContext *context,
                                    QOpenGLFunctions *gl, QOpenGLBuffer *vbo)
-    : gl(gl), context(context), vert(QOpenGLShader::Vertex),
-      frag(QOpenGLShader::Fragment), shader(context), vbo(vbo),
-      dataChanged(false), viewChanged(false), shouldFillPolygon(false) {}
+    : gl(gl), context(context), vbo(vbo), vert(QOpenGLShader::Vertex),
+      frag(QOpenGLShader::Fragment), shader(context), fillMode(Triangulate),
+      profiler(nullptr), dataChanged(false), viewChanged(false),
+      shouldFillPolygon(false) {}
 
 AbstractRenderer::~AbstractRenderer() {
   Q_ASSERT(shader.isLinked());
@@ -29,7 +30,29 @@ QPointF AbstractRenderer::project(const float x, const float y) const noexcept {
   return this->worldToScreen.map(QPointF(x, y));
 }
 
+void AbstractRenderer::updateVertex(const ShapelyModel &model, const int) {
+  this->updateData(model);
+}
+
 void AbstractRenderer::updateSize(const int w, const int h) {
   this->size.setWidth(w);
   this->size.setHeight(h);
 }
+
+void AbstractRenderer::setFillMode(const FillMode mode) noexcept {
+  this->fillMode = mode;
+}
+
+void AbstractRenderer::setLogger(QOpenGLDebugLogger *) {}
+
+bool AbstractRenderer::isOpaque() const noexcept { return false; }
+
+void AbstractRenderer::setResultListener(const Listener &listener) {
+  this->resultListener = listener;
+}
+
+void AbstractRenderer::finish() {}
+
+void AbstractRenderer::setProfiler(Profiler *profiler) noexcept {
+  this->profiler = profiler;
+}
@@ -1,6 +1,8 @@
 #ifndef ABSTRACTRENDERER_HPP
 #define ABSTRACTRENDERER_HPP
 
+#include <functional>
+
 #include <QMatrix4x4>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLShader>
@@ -9,18 +11,48 @@
 class QOpenGLContext;
 class QOpenGLFunctions;
 class QOpenGLBuffer;
+class QOpenGLDebugLogger;
+class Profiler;
 struct ShapelyModel;
 
 class AbstractRenderer {
 public:
+  /**
+   * How to fill the polygon's interior.  Triangulate only fills simple
+   * polygons; ShaderRenderer can also fill any polygon with the stencil
+   * buffer, by the given fill rule.  MidpointRenderer always triangulates.
+   */
+  enum FillMode { Triangulate, NonZero, EvenOdd };
+
   AbstractRenderer(QOpenGLContext *, QOpenGLFunctions *, QOpenGLBuffer *);
   virtual ~AbstractRenderer();
   virtual void drawPolygon() = 0;
   virtual void updateData(const ShapelyModel &) = 0;
+  virtual void updateVertex(const ShapelyModel &, const int index);
+  // ^ Only the vertex at index moved, or was just appended; by default this
+  // just calls updateData()
   virtual void updateView(const ShapelyModel &) = 0;
   QPointF unproject(const float x, const float y) const noexcept;
   QPointF project(const float x, const float y) const noexcept;
   void updateSize(const int w, const int h);
+  void setFillMode(const FillMode mode) noexcept;
+  // ^ Takes effect on the next updateData()
+  virtual void setLogger(QOpenGLDebugLogger *);
+  // ^ Where to report uploads that had to wait on the GPU; none by default
+  void setProfiler(Profiler *) noexcept;
+  // ^ Where to record how long rasterizing and uploading take; none by default
+  virtual bool isOpaque() const noexcept;
+  // ^ Whether drawPolygon() covers the whole viewport, hiding anything drawn
+  // before it
+
+  typedef std::function<void()> Listener;
+  void setResultListener(const Listener &);
+  // ^ Called (on a worker thread) whenever geometry work started by
+  // updateData() or updateView() finishes, so drawPolygon() would now draw
+  // something newer; set it before either is called
+  virtual void finish();
+  // ^ Waits until drawPolygon() would draw the results of everything passed
+  // to updateData() and updateView() so far; returns at once by default
 
 protected:
   virtual void drawBackground() = 0;
@@ -39,6 +71,9 @@ protected:
   QMatrix4x4 worldToScreen;
   QMatrix4x4 screenToWorld;
   QSize size;
+  FillMode fillMode;
+  Profiler *profiler;
+  Listener resultListener;
 
   bool dataChanged : 1;
   bool viewChanged : 1;
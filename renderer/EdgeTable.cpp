@@ -0,0 +1,107 @@
+#include "EdgeTable.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include <QPoint>
+
+#include "FrameArena.hpp"
+
+EdgeTable::EdgeTable() noexcept : _yMin(0), _yMax(0), _maxActive(0) {}
+
+void EdgeTable::clear() noexcept {
+  this->_edges.clear();
+  this->_buckets.clear();
+  this->_yMin = 0;
+  this->_yMax = 0;
+  this->_maxActive = 0;
+}
+
+void EdgeTable::addEdge(const QPoint &a, const QPoint &b) {
+  if (a.y() == b.y())
+    return;
+  // Horizontal edges never cross a scan line, so the spans on either side of
+  // them already cover them
+
+  const QPoint &top = (a.y() < b.y()) ? a : b;
+  const QPoint &bottom = (a.y() < b.y()) ? b : a;
+
+  Edge e;
+  e.yMin = top.y();
+  e.yMax = bottom.y();
+  e.xOrigin = top.x();
+  e.dx = bottom.x() - top.x();
+  e.dy = bottom.y() - top.y();
+
+  std::int64_t q = e.dx / e.dy;
+  std::int64_t r = e.dx - q * e.dy;
+  if (r < 0) {
+    --q;
+    r += e.dy;
+  }
+  e.xStep = q;
+  e.remainderStep = r;
+  e.x = e.xOrigin;
+  e.remainder = 0;
+
+  this->_edges.push_back(e);
+}
+
+void EdgeTable::build(FrameArena &scratch) {
+  if (this->_edges.empty()) {
+    this->_buckets.clear();
+    this->_yMin = this->_yMax = 0;
+    this->_maxActive = 0;
+    return;
+  }
+
+  int yMin = std::numeric_limits<int>::max();
+  int yMax = std::numeric_limits<int>::min();
+  for (const Edge &e : this->_edges) {
+    yMin = std::min(yMin, e.yMin);
+    yMax = std::max(yMax, e.yMax);
+  }
+
+  this->_yMin = yMin;
+  this->_yMax = yMax;
+
+  int rows = yMax - yMin;
+  this->_buckets.assign(rows + 1, 0);
+
+  // Counting sort by yMin; first count the edges that start on each row...
+  for (const Edge &e : this->_edges) {
+    ++this->_buckets[e.yMin - yMin + 1];
+  }
+
+  // ...then turn the counts into offsets...
+  for (int i = 1; i <= rows; ++i) {
+    this->_buckets[i] += this->_buckets[i - 1];
+  }
+
+  // ...then scatter the edges into their buckets
+  int edges = this->_edges.size();
+  Edge *sorted = scratch.allocate<Edge>(edges);
+  int *next = scratch.allocate<int>(rows);
+  std::copy(this->_buckets.begin(), this->_buckets.end() - 1, next);
+  for (const Edge &e : this->_edges) {
+    sorted[next[e.yMin - yMin]++] = e;
+  }
+  std::copy(sorted, sorted + edges, this->_edges.begin());
+  // ^ Copied back rather than swapped, so _edges keeps its capacity
+
+  int *ends = next;
+  std::fill(ends, ends + rows, 0);
+  for (const Edge &e : this->_edges) {
+    if (e.yMax - yMin < rows) {
+      ++ends[e.yMax - yMin];
+    }
+  }
+  // ^ How many edges end on each row (the last row's are never active there)
+
+  int active = 0;
+  this->_maxActive = 0;
+  for (int y = 0; y < rows; ++y) {
+    active += this->_buckets[y + 1] - this->_buckets[y] - ends[y];
+    this->_maxActive = std::max(this->_maxActive, active);
+  }
+}
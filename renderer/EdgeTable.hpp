@@ -0,0 +1,187 @@
+#ifndef EDGETABLE_HPP
+#define EDGETABLE_HPP
+
+#include <cstdint>
+#include <vector>
+
+class FrameArena;
+class QPoint;
+
+/**
+ * Scan-line polygon fill using an edge table and an active edge table.
+ *
+ * Edges are bucketed by their lowest scan line in one flat array (sorted by
+ * bucket, with an offset per scan line), and every active edge steps its
+ * x-intercept from one scan line to the next with exact integer arithmetic.
+ * The cost of a fill is proportional to edges * scan lines rather than to the
+ * number of pixels covered.
+ */
+class EdgeTable {
+public:
+  struct Span {
+    int y;
+    int x0;
+    int x1;
+    // ^ Half-open; covers the pixels x0, x0 + 1, ..., x1 - 1
+  };
+
+  struct Edge {
+    int yMin;
+    int yMax;    // Exclusive
+    int xOrigin; // x-intercept at yMin
+    std::int64_t dx;
+    std::int64_t dy; // Always positive; horizontal edges are never stored
+
+    int x; // floor() of the x-intercept on the current scan line
+    std::int64_t remainder;     // Fractional part of the intercept, times dy
+    int xStep;                  // floor(dx / dy)
+    std::int64_t remainderStep; // dx - xStep * dy
+
+    void start(const int y) noexcept;
+    void step() noexcept;
+    bool operator<(const Edge &) const noexcept;
+    int left() const noexcept { return x + (remainder > 0); }
+    // ^ ceil() of the intercept; the first pixel at or to the right of it
+  };
+
+  EdgeTable() noexcept;
+
+  void clear() noexcept;
+  void addEdge(const QPoint &a, const QPoint &b);
+  void build(FrameArena &scratch);
+  // ^ scratch only needs to last until this returns
+  bool isEmpty() const noexcept { return this->_edges.empty(); }
+
+  int yMin() const noexcept { return this->_yMin; }
+  int yMax() const noexcept { return this->_yMax; }
+  int edgeCount() const noexcept { return this->_edges.size(); }
+  int maxActive() const noexcept { return this->_maxActive; }
+  // ^ The most edges that cross any one scan line
+
+  /**
+   * Calls emit(const Span &) for every span covered by the polygon on the scan
+   * lines [y0, y1), in order of increasing y, then increasing x.  Spans are
+   * paired by the even-odd rule.  This is const, and keeps its scratch state
+   * in active (which needs room for maxActive() edges), so disjoint ranges
+   * may be scanned concurrently with different scratch.
+   */
+  template <class F> void scan(int y0, int y1, Edge *active, F emit) const;
+
+  template <class F> void scan(int y0, int y1, F emit) const {
+    std::vector<Edge> active(this->_maxActive);
+    this->scan(y0, y1, active.data(), emit);
+  }
+
+  template <class F> void scan(F emit) const {
+    this->scan(this->_yMin, this->_yMax, emit);
+  }
+
+private:
+  std::vector<Edge> _edges;
+  // ^ After build(), sorted by yMin
+  std::vector<int> _buckets;
+  // ^ _buckets[y - _yMin] is the index of the first edge in _edges with that
+  // yMin; one extra entry at the end so each bucket is [b[i], b[i + 1])
+
+  int _yMin;
+  int _yMax;
+  int _maxActive;
+};
+
+inline void EdgeTable::Edge::start(const int y) noexcept {
+  std::int64_t n = (y - this->yMin) * this->dx;
+  std::int64_t q = n / this->dy;
+  std::int64_t r = n - q * this->dy;
+  if (r < 0) {
+    // Integer division truncates toward zero; we want floor()
+    --q;
+    r += this->dy;
+  }
+
+  this->x = this->xOrigin + q;
+  this->remainder = r;
+}
+
+inline void EdgeTable::Edge::step() noexcept {
+  this->x += this->xStep;
+  this->remainder += this->remainderStep;
+  if (this->remainder >= this->dy) {
+    this->remainder -= this->dy;
+    ++this->x;
+  }
+}
+
+inline bool EdgeTable::Edge::operator<(const Edge &o) const noexcept {
+  if (this->x != o.x)
+    return this->x < o.x;
+
+  // Same integer part, so compare remainder / dy against o.remainder / o.dy
+  return this->remainder * o.dy < o.remainder * this->dy;
+}
+
+template <class F>
+void EdgeTable::scan(int y0, int y1, Edge *active, F emit) const {
+  if (this->_edges.empty())
+    return;
+
+  y0 = (y0 < this->_yMin) ? this->_yMin : y0;
+  y1 = (y1 > this->_yMax) ? this->_yMax : y1;
+
+  if (y0 >= y1)
+    return;
+
+  int count = 0;
+  int first = this->_buckets[y0 - this->_yMin];
+  for (int i = 0; i < first; ++i) {
+    // For every edge that started above this range...
+    const Edge &e = this->_edges[i];
+    if (e.yMax > y0) {
+      // ...if it's still going by the time we get there...
+      active[count] = e;
+      active[count++].start(y0);
+    }
+  }
+
+  for (int y = y0; y < y1; ++y) {
+    int kept = 0;
+    for (int i = 0; i < count; ++i) {
+      if (active[i].yMax > y) {
+        active[kept++] = active[i];
+      }
+    }
+    // Retire the edges that ended on the previous scan line; done before
+    // adding this one's, so there's never more than maxActive() at once
+
+    int begin = this->_buckets[y - this->_yMin];
+    int end = this->_buckets[y - this->_yMin + 1];
+    for (int i = begin; i < end; ++i) {
+      active[kept] = this->_edges[i];
+      active[kept++].start(y);
+    }
+    count = kept;
+
+    for (int i = 1; i < kept; ++i) {
+      // Insertion sort; the active edges are almost always already in order
+      Edge e = active[i];
+      int j = i - 1;
+      for (; j >= 0 && e < active[j]; --j) {
+        active[j + 1] = active[j];
+      }
+      active[j + 1] = e;
+    }
+
+    for (int i = 0; i + 1 < kept; i += 2) {
+      int x0 = active[i].left();
+      int x1 = active[i + 1].left();
+      if (x0 < x1) {
+        emit(Span{y, x0, x1});
+      }
+    }
+
+    for (int i = 0; i < count; ++i) {
+      active[i].step();
+    }
+  }
+}
+
+#endif // EDGETABLE_HPP
@@ -0,0 +1,88 @@
+#include "FrameArena.hpp"
+
+#include <algorithm>
+
+constexpr std::size_t MIN_BLOCK = 64 * 1024;
+
+FrameArena::FrameArena() noexcept
+    : _used(0), _bytes(0), _peak(0), _blocksAllocated(0) {}
+
+FrameArena::~FrameArena() {}
+
+std::size_t FrameArena::capacity() const noexcept {
+  std::size_t total = 0;
+  for (const Block &block : this->_blocks) {
+    total += block.size;
+  }
+  return total;
+}
+
+void FrameArena::reserve(const std::size_t bytes) {
+  if (this->_blocks.empty() ||
+      this->_blocks.back().size - this->_used < bytes) {
+    this->_grow(bytes);
+  }
+}
+
+void FrameArena::reset() {
+  if (this->_blocks.size() > 1) {
+    // If the last frame outgrew the first block, start the next one with room
+    // for all of it
+    std::size_t total = this->capacity();
+    this->_blocks.clear();
+    this->_blocks.push_back(Block{
+        std::unique_ptr<unsigned char[]>(new unsigned char[total]), total});
+    ++this->_blocksAllocated;
+  }
+
+  this->_used = 0;
+  this->_bytes = 0;
+}
+
+void *FrameArena::_allocate(const std::size_t bytes,
+                            const std::size_t alignment) {
+  if (bytes == 0)
+    return nullptr;
+
+  std::size_t padding = 0;
+  if (!this->_blocks.empty()) {
+    const Block &block = this->_blocks.back();
+    std::uintptr_t at =
+        reinterpret_cast<std::uintptr_t>(block.data.get()) + this->_used;
+    padding = (alignment - at % alignment) % alignment;
+  }
+
+  if (this->_blocks.empty() ||
+      this->_blocks.back().size - this->_used < padding + bytes) {
+    this->_grow(bytes + alignment);
+    padding = 0;
+    // ^ new[] aligns for anything with a fundamental alignment
+  }
+
+  unsigned char *p = this->_blocks.back().data.get() + this->_used + padding;
+  this->_used += padding + bytes;
+  this->_bytes += padding + bytes;
+  this->_peak = std::max(this->_peak, this->_bytes);
+  return p;
+}
+
+/**
+ * Starts a new block with room for at least bytes more.  Whatever's left of
+ * the old one is wasted until reset().
+ */
+void FrameArena::_grow(const std::size_t bytes) {
+  std::size_t size = std::max(bytes, MIN_BLOCK);
+  if (!this->_blocks.empty()) {
+    size = std::max(size, this->_blocks.back().size * 2);
+  }
+
+  if (this->_used == 0 && !this->_blocks.empty()) {
+    // If nothing's been allocated from the last block yet, replace it
+    this->_blocks.pop_back();
+  }
+
+  this->_blocks.push_back(
+      Block{std::unique_ptr<unsigned char[]>(new unsigned char[size]), size});
+  ++this->_blocksAllocated;
+  this->_used = 0;
+}
@@ -0,0 +1,72 @@
+#ifndef FRAMEARENA_HPP
+#define FRAMEARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Scratch memory for one frame's worth of rasterizing or triangulating.
+ * Allocating just bumps a pointer, nothing is freed on its own, and reset()
+ * takes it all back at once when the next frame starts.
+ *
+ * Memory comes in blocks.  If a frame needed more than one, reset() swaps
+ * them for a single block as big as all of them, so once the frames stop
+ * growing (e.g. while dragging a vertex), they stop touching the heap.
+ *
+ * Only for trivially destructible types, since nothing's ever destroyed, and
+ * not thread-safe; hand each thread its own piece before it starts.
+ */
+class FrameArena {
+public:
+  FrameArena() noexcept;
+  ~FrameArena();
+
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  /**
+   * @return Room for count (uninitialized) objects of type T, which lasts
+   * until the next reset()
+   */
+  template <class T> T *allocate(const std::size_t count) {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "FrameArena never runs destructors");
+    return static_cast<T *>(this->_allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void reserve(const std::size_t bytes);
+  // ^ Makes sure that many bytes can be allocated without a new block
+  void reset();
+
+  std::size_t bytes() const noexcept { return this->_bytes; }
+  // ^ Allocated since the last reset(), padding included
+  std::size_t peak() const noexcept { return this->_peak; }
+  // ^ The most bytes() has ever been
+  std::size_t capacity() const noexcept;
+  std::uint64_t blocksAllocated() const noexcept {
+    return this->_blocksAllocated;
+  }
+  // ^ Trips to the heap so far
+
+private:
+  struct Block {
+    std::unique_ptr<unsigned char[]> data;
+    std::size_t size;
+  };
+
+  void *_allocate(const std::size_t bytes, const std::size_t alignment);
+  void _grow(const std::size_t bytes);
+
+  std::vector<Block> _blocks;
+  // ^ Only the last one is allocated from; the rest are full
+  std::size_t _used;
+  // ^ Of the last block
+  std::size_t _bytes;
+  std::size_t _peak;
+  std::uint64_t _blocksAllocated;
+};
+
+#endif // FRAMEARENA_HPP
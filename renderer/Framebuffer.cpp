@@ -0,0 +1,109 @@
+#include "Framebuffer.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include <QColor>
+
+#include "SpanFill.hpp"
+
+constexpr int NOTHING_BEGIN = std::numeric_limits<int>::max();
+constexpr int NOTHING_END = std::numeric_limits<int>::min();
+
+Framebuffer::Framebuffer() noexcept
+    : _width(0), _height(0), _clearColor(0), _dirtyBegin(NOTHING_BEGIN),
+      _dirtyEnd(NOTHING_END), _usedBegin(NOTHING_BEGIN),
+      _usedEnd(NOTHING_END) {}
+
+Framebuffer::Pixel Framebuffer::pack(const QColor &color) noexcept {
+  const unsigned char rgba[4] = {
+      static_cast<unsigned char>(color.red()),
+      static_cast<unsigned char>(color.green()),
+      static_cast<unsigned char>(color.blue()),
+      static_cast<unsigned char>(color.alpha())};
+
+  Pixel p;
+  std::copy(rgba, rgba + sizeof(rgba), reinterpret_cast<unsigned char *>(&p));
+  // ^ Byte-wise so this is right regardless of the host's endianness
+  return p;
+}
+
+void Framebuffer::resize(const int w, const int h) {
+  if (w == this->_width && h == this->_height)
+    return;
+
+  this->_width = std::max(w, 0);
+  this->_height = std::max(h, 0);
+  this->_pixels.assign(this->_width * this->_height, this->_clearColor);
+
+  this->_dirtyBegin = 0;
+  this->_dirtyEnd = this->_height;
+  this->_usedBegin = NOTHING_BEGIN;
+  this->_usedEnd = NOTHING_END;
+}
+
+void Framebuffer::setClearColor(const Pixel color) noexcept {
+  if (color != this->_clearColor) {
+    this->_clearColor = color;
+    this->_usedBegin = 0;
+    this->_usedEnd = this->_height;
+    // Every row is now the wrong color
+  }
+}
+
+void Framebuffer::clear() noexcept {
+  if (this->_usedBegin >= this->_usedEnd)
+    return;
+
+  jtg::fillSpan(this->_pixels.data() + this->_usedBegin * this->_width,
+                (this->_usedEnd - this->_usedBegin) * this->_width,
+                this->_clearColor);
+  // The used rows are contiguous, so clear them as one long span
+
+  this->_dirtyBegin = std::min(this->_dirtyBegin, this->_usedBegin);
+  this->_dirtyEnd = std::max(this->_dirtyEnd, this->_usedEnd);
+  this->_usedBegin = NOTHING_BEGIN;
+  this->_usedEnd = NOTHING_END;
+}
+
+void Framebuffer::fillSpan(const int y, int x0, int x1,
+                           const Pixel color) noexcept {
+  if (y < 0 || y >= this->_height)
+    return;
+
+  x0 = std::max(x0, 0);
+  x1 = std::min(x1, this->_width);
+  if (x0 >= x1)
+    return;
+
+  Pixel *row = this->_pixels.data() + y * this->_width;
+  jtg::fillSpan(row + x0, x1 - x0, color);
+  this->_touch(y);
+}
+
+void Framebuffer::fillSpanUntracked(const int y, int x0, int x1,
+                                    const Pixel color) noexcept {
+  if (y < 0 || y >= this->_height)
+    return;
+
+  x0 = std::max(x0, 0);
+  x1 = std::min(x1, this->_width);
+  if (x0 < x1) {
+    jtg::fillSpan(this->_pixels.data() + y * this->_width + x0, x1 - x0,
+                  color);
+  }
+}
+
+void Framebuffer::markRows(int begin, int end) noexcept {
+  begin = std::max(begin, 0);
+  end = std::min(end, this->_height);
+  if (begin < end) {
+    this->_touch(begin);
+    this->_touch(end - 1);
+  }
+}
+
+void Framebuffer::markClean() noexcept {
+  this->_dirtyBegin = NOTHING_BEGIN;
+  this->_dirtyEnd = NOTHING_END;
+}
@@ -0,0 +1,97 @@
+#ifndef FRAMEBUFFER_HPP
+#define FRAMEBUFFER_HPP
+
+#include <cstdint>
+#include <vector>
+
+class QColor;
+
+/**
+ * A CPU-side RGBA8 image that the software rasterizer draws into.  Row 0 is
+ * the bottom of the viewport, matching OpenGL's texture coordinates, so the
+ * whole thing can be uploaded as-is.
+ *
+ * Keeps track of which rows were touched since the last upload (so only those
+ * need to be sent to the GPU) and which rows hold anything besides the clear
+ * color (so clear() only has to wipe those).
+ */
+class Framebuffer {
+public:
+  typedef std::uint32_t Pixel;
+
+  Framebuffer() noexcept;
+
+  static Pixel pack(const QColor &) noexcept;
+  // ^ In memory order R, G, B, A, i.e. GL_RGBA + GL_UNSIGNED_BYTE
+
+  void resize(const int w, const int h);
+  void setClearColor(const Pixel color) noexcept;
+  void clear() noexcept;
+
+  void plot(const int x, const int y, const Pixel color) noexcept;
+  void fillSpan(const int y, int x0, int x1, const Pixel color) noexcept;
+  // ^ Covers [x0, x1); clipped to the framebuffer
+
+  /**
+   * Like fillSpan(), but doesn't record the row as touched, so it's safe to
+   * call from several threads at once as long as they write different rows.
+   * Call markRows() (on one thread) for the rows you're going to write.
+   */
+  void fillSpanUntracked(const int y, int x0, int x1,
+                         const Pixel color) noexcept;
+  void markRows(int begin, int end) noexcept;
+
+  int width() const noexcept { return this->_width; }
+  int height() const noexcept { return this->_height; }
+  const Pixel *data() const noexcept { return this->_pixels.data(); }
+  const Pixel *row(const int y) const noexcept {
+    return this->_pixels.data() + y * this->_width;
+  }
+  Pixel pixel(const int x, const int y) const noexcept {
+    return this->_pixels[y * this->_width + x];
+  }
+
+  bool isDirty() const noexcept { return this->_dirtyBegin < this->_dirtyEnd; }
+  int dirtyBegin() const noexcept { return this->_dirtyBegin; }
+  int dirtyEnd() const noexcept { return this->_dirtyEnd; }
+  // ^ Rows [dirtyBegin, dirtyEnd) changed since the last markClean()
+  void markClean() noexcept;
+
+  int usedBegin() const noexcept { return this->_usedBegin; }
+  int usedEnd() const noexcept { return this->_usedEnd; }
+  // ^ Rows outside [usedBegin, usedEnd) are all the clear color
+
+private:
+  void _touch(const int y) noexcept;
+
+  std::vector<Pixel> _pixels;
+  int _width;
+  int _height;
+  Pixel _clearColor;
+
+  int _dirtyBegin;
+  int _dirtyEnd;
+  int _usedBegin;
+  int _usedEnd;
+};
+
+inline void Framebuffer::_touch(const int y) noexcept {
+  if (y < this->_dirtyBegin)
+    this->_dirtyBegin = y;
+  if (y >= this->_dirtyEnd)
+    this->_dirtyEnd = y + 1;
+  if (y < this->_usedBegin)
+    this->_usedBegin = y;
+  if (y >= this->_usedEnd)
+    this->_usedEnd = y + 1;
+}
+
+inline void Framebuffer::plot(const int x, const int y,
+                              const Pixel color) noexcept {
+  if (0 <= x && x < this->_width && 0 <= y && y < this->_height) {
+    this->_pixels[y * this->_width + x] = color;
+    this->_touch(y);
+  }
+}
+
+#endif // FRAMEBUFFER_HPP
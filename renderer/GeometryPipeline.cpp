@@ -0,0 +1,70 @@
+#include "GeometryPipeline.hpp"
+
+GeometryPipeline::GeometryPipeline(const Job &job)
+    : _job(job), _pending(false), _pendingGeneration(0), _busy(false),
+      _quit(false), _generation(0), _thread(&GeometryPipeline::_loop, this) {}
+
+GeometryPipeline::~GeometryPipeline() {
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    this->_quit = true;
+    this->_pending = false;
+    ++this->_generation;
+  }
+  this->_wake.notify_all();
+  this->_thread.join();
+}
+
+void GeometryPipeline::submit() {
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    this->_pendingGeneration = ++this->_generation;
+    this->_pending = true;
+  }
+  this->_wake.notify_all();
+}
+
+void GeometryPipeline::cancel() {
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    ++this->_generation;
+    this->_pending = false;
+  }
+  this->_idle.notify_all();
+}
+
+bool GeometryPipeline::isStale(const unsigned generation) const noexcept {
+  return generation != this->_generation.load(std::memory_order_acquire);
+}
+
+void GeometryPipeline::wait() {
+  std::unique_lock<std::mutex> lock(this->_lock);
+  this->_idle.wait(lock,
+                   [this]() { return !this->_pending && !this->_busy; });
+}
+
+void GeometryPipeline::_loop() {
+  std::unique_lock<std::mutex> lock(this->_lock);
+
+  for (;;) {
+    this->_wake.wait(lock,
+                     [this]() { return this->_quit || this->_pending; });
+    if (this->_quit)
+      return;
+
+    this->_pending = false;
+    unsigned generation = this->_pendingGeneration;
+    this->_busy = true;
+
+    lock.unlock();
+    if (!this->isStale(generation)) {
+      this->_job(generation);
+    }
+    lock.lock();
+
+    this->_busy = false;
+    if (!this->_pending) {
+      this->_idle.notify_all();
+    }
+  }
+}
@@ -0,0 +1,64 @@
+#ifndef GEOMETRYPIPELINE_HPP
+#define GEOMETRYPIPELINE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * A thread of its own for a renderer's expensive geometry work (triangulating,
+ * rasterizing), so editing a huge polygon never waits on it.
+ *
+ * There's only ever one job, given up front; submitting just asks for it to
+ * run (again).  It takes its inputs from a slot the renderer keeps for them,
+ * under the renderer's lock, so submitting never allocates, however big the
+ * snapshot.  Only the newest submission matters: one that hasn't started yet
+ * is simply merged with the next, and a run that's in progress becomes stale,
+ * which it can check with isStale() between stages and give up early.  Each
+ * run publishes its own results (into the renderer's front buffer, under the
+ * renderer's lock); the renderer draws whatever was published last.
+ */
+class GeometryPipeline {
+public:
+  typedef std::function<void(const unsigned generation)> Job;
+
+  explicit GeometryPipeline(const Job &job);
+  ~GeometryPipeline();
+  // ^ Cancels whatever's queued or running, and waits for it to stop
+
+  GeometryPipeline(const GeometryPipeline &) = delete;
+  GeometryPipeline &operator=(const GeometryPipeline &) = delete;
+
+  void submit();
+  // ^ Has the job run once whatever's running now is done, and makes that
+  // stale
+  void cancel();
+  // ^ Drops the queued run, if any, and makes the running one stale
+
+  bool isStale(const unsigned generation) const noexcept;
+  // ^ Whether something newer has been submitted (or cancelled) since the job
+  // with this generation was; thread-safe
+
+  void wait();
+  // ^ Until there's nothing queued or running
+
+private:
+  void _loop();
+
+  std::mutex _lock;
+  std::condition_variable _wake;
+  std::condition_variable _idle;
+  Job _job;
+  bool _pending;
+  unsigned _pendingGeneration;
+  bool _busy;
+  bool _quit;
+  std::atomic<unsigned> _generation;
+
+  std::thread _thread;
+  // ^ Last, so everything above exists before it starts
+};
+
+#endif // GEOMETRYPIPELINE_HPP
@@ -2,29 +2,41 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
 
 #include <QOpenGLBuffer>
 #include <QOpenGLFunctions>
 #include <QPointF>
-#include <QPoint>
 #include <QtMath>
 
 #include "exception/ShaderException.hpp"
 #include "exception/ShaderProgramException.hpp"
 #include "Constants.hpp"
 #include "Utility.hpp"
+#include "profiling/Profiler.hpp"
 
-constexpr QOpenGLBuffer::UsagePattern USAGE_PATTERN = QOpenGLBuffer::StaticDraw;
+constexpr GLfloat SCREEN_QUAD[] = {-1, -1, 1, -1, -1, 1, 1, 1};
+// ^ Triangle strip covering all of clip space
 
-// TODO: Only drawing a dot at the center; presumably -1 to 1; gotta map these
-// back to screen dimensions
+constexpr int FRAMEBUFFER_UNIT = 0;
+
+constexpr int NO_ROWS_BEGIN = std::numeric_limits<int>::max();
+constexpr int NO_ROWS_END = std::numeric_limits<int>::min();
 
 // Make the renderers responsible for projection
 MidpointRenderer::MidpointRenderer(const QString &vertPath,
                                    const QString &fragPath,
                                    QOpenGLContext *context,
                                    QOpenGLFunctions *gl, QOpenGLBuffer *vbo)
-    : AbstractRenderer(context, gl, vbo) {
+    : AbstractRenderer(context, gl, vbo), _filling(false),
+      _uploadBegin(NO_ROWS_BEGIN), _uploadEnd(NO_ROWS_END), _texture(0),
+      _pbo(QOpenGLBuffer::PixelUnpackBuffer), _stream(context, &_pbo, "Pixel"),
+      _pipeline([this](const unsigned generation) { this->_run(generation); }) {
 
   if (!this->vert.compileSourceFile(vertPath)) {
     throw ShaderException(vert);
@@ -43,33 +55,81 @@ MidpointRenderer::MidpointRenderer(const QString &vertPath,
     throw ShaderProgramException(shader);
   }
 
-  this->_matrix = shader.uniformLocation("matrix");
-  this->_color = shader.uniformLocation("color");
+  this->_sampler = shader.uniformLocation("framebuffer");
+  shader.setUniformValue(this->_sampler, FRAMEBUFFER_UNIT);
+
+  this->gl->glGenTextures(1, &this->_texture);
+  this->gl->glActiveTexture(GL_TEXTURE0 + FRAMEBUFFER_UNIT);
+  this->gl->glBindTexture(GL_TEXTURE_2D, this->_texture);
+  this->gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  this->gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  this->gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  this->gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  // One texel per pixel, so no filtering
+
+  vbo->allocate(SCREEN_QUAD, sizeof(SCREEN_QUAD));
+  // The only geometry we ever draw; everything else is in the texture
 
   this->_position = shader.attributeLocation("position");
   shader.enableAttributeArray(this->_position);
   this->gl->glVertexAttribPointer(this->_position, 2, GL_FLOAT, GL_FALSE, 0, 0);
-  shader.setUniformValue(this->_matrix, this->worldToScreen);
+
+  Framebuffer::Pixel background =
+      Framebuffer::pack(Constants::BACKGROUND_COLOR);
+  this->_rasterizer.framebuffer().setClearColor(background);
+  this->_front.setClearColor(background);
+  // ^ They trade places after every frame
+
+  if (!this->_pbo.create()) {
+    std::ostringstream e;
+    e << "Could not create PBO (ID: " << this->_pbo.bufferId() << ")";
+    throw std::runtime_error(e.str());
+  }
 }
 
 MidpointRenderer::~MidpointRenderer() {
   shader.disableAttributeArray(this->_position);
+  this->gl->glDeleteTextures(1, &this->_texture);
+  this->_pbo.destroy();
+}
+
+void MidpointRenderer::setLogger(QOpenGLDebugLogger *logger) {
+  this->_stream.setLogger(logger);
 }
 
-void MidpointRenderer::drawBackground() {}
+void MidpointRenderer::drawBackground() {
+  this->_rasterizer.framebuffer().clear();
+}
 
 void MidpointRenderer::updateData(const ShapelyModel &model) {
-  this->_current = model;
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    this->_store.reset(model.polygon);
+  }
   this->updateView(model);
   this->dataChanged = true;
 }
 
-void MidpointRenderer::updateView(const ShapelyModel &model) {
-  using std::round;
-  using std::abs;
+void MidpointRenderer::updateVertex(const ShapelyModel &model,
+                                    const int index) {
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    int n = model.polygon.size();
 
-  if (this->dataChanged)
-    return;
+    if (n == this->_store.size()) {
+      this->_store.moveVertex(index, model.polygon[index]);
+    } else if (n == this->_store.size() + 1 && index == n - 1) {
+      this->_store.appendVertex(model.polygon[index]);
+    } else {
+      this->_store.reset(model.polygon);
+    }
+    // ^ Only a move or an append can be passed along as one vertex
+  }
+  this->updateView(model);
+  this->dataChanged = true;
+}
+
+void MidpointRenderer::updateView(const ShapelyModel &model) {
   float w = this->size.width();
   float h = this->size.height();
 
@@ -92,168 +152,221 @@ void MidpointRenderer::updateView(const ShapelyModel &model) {
     this->screenToWorld = sTw;
     this->projection = p;
 
-    this->_linePixels.clear();
-
-    const QPolygonF &polygon = this->_current.polygon;
-    int verts = polygon.size();
+    this->shouldFillPolygon = model.isSimple();
+    // If the polygon self-intersects or doesn't have 3 sides, don't fill it
 
-    QRectF rect = model.polygon.boundingRect();
-    float area = rect.width() * rect.height();
-    // Rough area approximation so we can preallocate memory
+    this->_submit();
+    this->viewChanged = true;
+  }
+}
 
-    this->_intersections.clear();
-    this->_linePixels.reserve(area * 2);
-    for (int i = 0; i < verts; ++i) {
-      const QPointF &a = polygon[i];
-      const QPointF &b = polygon[(i + 1) % verts];
+void MidpointRenderer::finish() { this->_pipeline.wait(); }
 
-      this->_computeLine(QPoint(round(a.x()), round(a.y())),
-                         QPoint(round(b.x()), round(b.y())));
-    }
+/**
+ * Hands the view as it is now to the pipeline, replacing whatever it was going
+ * to rasterize next.  The polygon is already in _store.
+ */
+void MidpointRenderer::_submit() {
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    this->_next = {this->worldToScreen, this->size,
+                   LevelOfDetail::tolerance(this->worldToScreen, this->size),
+                   this->shouldFillPolygon, this->profiler};
+  }
+  this->_pipeline.submit();
+}
 
-    // NOTE: Can optimize; only need to check new edges for intersection
-    if (jtg::isSimplePolygon(polygon)) {
-      // If the polygon self-intersects or doesn't have 3 sides...
-      this->shouldFillPolygon = true;
-      this->_fillPixels.clear();
+/**
+ * Runs on the pipeline's thread: takes the latest snapshot and edits, and
+ * rasterizes them, with only the vertices that show once they've been ranked.
+ */
+void MidpointRenderer::_run(const unsigned generation) {
+  Snapshot snapshot;
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    snapshot = this->_next;
+    this->_store.sync();
+  }
 
-      this->_fillPixels.reserve(area * 2);
-      this->_fill();
-    } else {
-      this->shouldFillPolygon = false;
-    }
-    this->viewChanged = true;
+  const std::function<bool()> cancelled = [this, generation]() {
+    return this->_pipeline.isStale(generation);
+  };
+  // ^ Only captures what fits in a std::function without allocating
+  bool ranked = this->_lod.refine(
+      this->_store.polygon(), this->_store.revision(), snapshot.tolerance,
+      snapshot.fill, this->_kept, this->_scratch, cancelled,
+      [this, &snapshot, generation]() {
+        this->_rasterize(snapshot, generation);
+      });
+  if (ranked && snapshot.profiler) {
+    snapshot.profiler->recordScratch(this->_scratch.bytes());
   }
 }
 
-void MidpointRenderer::drawLines() {
-  shader.setUniformValue(this->_color, this->shouldFillPolygon
-                                           ? Constants::OUTLINE_COLOR
-                                           : Constants::COMPLEX_OUTLINE);
-  this->gl->glDrawArrays(GL_POINTS, this->_lineNumsOffset,
-                         this->_linePixels.size() / 2); // hack
-}
+/**
+ * Rasterizes the vertices in _kept, or all of them if it's empty.  Gives up
+ * between stages if a newer snapshot has come in, since nobody will ever see
+ * this one.
+ */
+void MidpointRenderer::_rasterize(const Snapshot &snapshot,
+                                  const unsigned generation) noexcept {
+  {
+    Profiler::Scope scope(snapshot.profiler, Profiler::Rasterize);
 
-void MidpointRenderer::fillPolygon() {
-  shader.setUniformValue(this->_color, Constants::POLYGON_COLOR);
-  this->gl->glDrawArrays(GL_POINTS, this->_fillNumsOffset,
-                         this->_fillPixels.size() / 2); // hack
-}
+    const QPolygonF &polygon = this->_store.polygon();
+    bool all = this->_kept.empty();
+    int verts = all ? polygon.size() : this->_kept.size();
+    float w = snapshot.size.width();
+    float h = snapshot.size.height();
 
-void MidpointRenderer::drawPolygon() {
-  Q_ASSERT(shader.isLinked());
-  Q_ASSERT(vert.isCompiled() && frag.isCompiled());
+    this->_rasterizer.framebuffer().resize(w, h);
 
-  if (this->dataChanged || this->viewChanged) {
-    int lineNums = this->_linePixels.size();
-    int fillNums = (this->shouldFillPolygon) ? this->_fillPixels.size() : 0;
+    this->_points.clear();
+    this->_points.reserve(verts);
+    for (int i = 0; i < verts; ++i) {
+      const QPointF &world = polygon[all ? i : this->_kept[i]];
+      QPointF ndc = snapshot.worldToScreen.map(world);
+      this->_points.push_back(
+          QPointF((ndc.x() + 1) * 0.5f * w, (ndc.y() + 1) * 0.5f * h));
+      // ^ Where this vertex lands; the rasterizer clips the polygon to the
+      // viewport before rounding it to pixels
+    }
 
-    this->_lineNumsOffset = 0;
-    this->_fillNumsOffset =
-        (this->_lineNumsOffset + lineNums) * sizeof(CoordType);
+    if (this->_pipeline.isStale(generation))
+      return;
 
-    vbo->allocate((lineNums + fillNums) * sizeof(CoordType));
+    this->_filling = snapshot.fill;
+    this->drawBackground();
 
-    // The VBO will contain line coordinates, vertex marker coordinates, and
-    // fill coordinates (if applicable), in that order
-    vbo->write(this->_lineNumsOffset, this->_linePixels.data(),
-               lineNums * sizeof(CoordType));
-    if (fillNums) {
-      // If we're filling the polygon, then write the coordinates in
-      vbo->write(this->_fillNumsOffset, this->_fillPixels.data(),
-                 fillNums * sizeof(CoordType));
+    if (this->_filling) {
+      this->fillPolygon();
     }
 
-    shader.setUniformValue(this->_matrix, this->worldToScreen);
+    if (this->_pipeline.isStale(generation))
+      return;
 
-    this->dataChanged = false;
-    this->viewChanged = false;
+    this->drawLines();
   }
 
-  if (this->shouldFillPolygon) {
-    this->fillPolygon();
+  if (snapshot.profiler) {
+    snapshot.profiler->recordScratch(this->_rasterizer.arena().bytes());
   }
 
-  this->drawLines();
+  this->_publish();
 }
 
 /**
- * Given two points, add the coordinates of each pixel between them to the
- * current buffer of line pixels
+ * Swaps the freshly drawn back buffer to the front.  The old front one (which
+ * may be what the texture holds) becomes the next back buffer; rows that
+ * either of them used are the only ones that can differ.
  */
-void MidpointRenderer::_computeLine(QPoint a, QPoint b) noexcept {
-  using jtg::sign;
-  using std::abs;
-
-  int width = b.x() - a.x();
-  int height = b.y() - a.y();
-
-  // In any Bresenham run, there's always two directions you can go; east or
-  // northeast.  This screwing around with signs below helps generalize that to
-  // other slopes (e.g. east/south-east for -1 < slope < 0)
-  int dx = sign(width);
-  int dy = sign(height);
-
-  int du = dx;
-  int dv = dy;
-
-  int longest = abs(width);
-  int shortest = abs(height);
-
-  if (longest <= shortest) {
-    // If the line's absolute slope is greater than 1...
-    longest = abs(height);
-    shortest = abs(width);
-    // ...then swap the axes
-
-    du = 0;
-    dv = dy;
-  } else {
-    du = dx;
-    dv = 0;
+void MidpointRenderer::_publish() {
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    Framebuffer &back = this->_rasterizer.framebuffer();
+    std::swap(this->_front, back);
+
+    this->_uploadBegin = std::min(
+        {this->_uploadBegin, this->_front.usedBegin(), back.usedBegin()});
+    this->_uploadEnd =
+        std::max({this->_uploadEnd, this->_front.usedEnd(), back.usedEnd()});
   }
 
-  int rise = longest / 2;
-  // integer multiplies/divides by powers of two usually compile to bit-shifts
+  if (this->resultListener) {
+    this->resultListener();
+  }
+}
 
-  for (int i = 0; i < longest; ++i) {
-    // For each vertical or horizontal (whichever is longer) pixel spanned...
-    this->_linePixels.push_back(a.x());
-    this->_linePixels.push_back(a.y());
-    // Queue up these pixels for rendering
+void MidpointRenderer::drawLines() {
+  Framebuffer::Pixel color =
+      Framebuffer::pack(this->_filling ? Constants::OUTLINE_COLOR
+                                       : Constants::COMPLEX_OUTLINE);
+  this->_rasterizer.drawOutline(this->_points, color);
+}
 
-    std::vector<int> &row = this->_intersections[a.y()];
+void MidpointRenderer::fillPolygon() {
+  this->_rasterizer.fill(this->_points,
+                         Framebuffer::pack(Constants::POLYGON_COLOR));
+}
 
-    if (row.empty() || row.back() != a.x()) {
-      row.push_back(a.x());
-    }
-    // Kill two birds with one stone; we know the scan lines intersect here, so
-    // why not get them ready for rendering?
+void MidpointRenderer::drawPolygon() {
+  Q_ASSERT(shader.isLinked());
+  Q_ASSERT(vert.isCompiled() && frag.isCompiled());
 
-    rise += shortest;
-    if (rise > longest) {
-      rise -= longest;
-      a += {dx, dy};
+  this->gl->glActiveTexture(GL_TEXTURE0 + FRAMEBUFFER_UNIT);
+  this->gl->glBindTexture(GL_TEXTURE_2D, this->_texture);
+
+  {
+    Profiler::Scope scope(this->profiler, Profiler::Upload);
+    std::lock_guard<std::mutex> guard(this->_lock);
+    // ^ Only waits if the pipeline is swapping buffers right now
+    const Framebuffer &fb = this->_front;
+
+    if (this->_textureSize != QSize(fb.width(), fb.height())) {
+      // If the viewport changed size, we need a new texture anyway...
+      this->gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, fb.width(),
+                             fb.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                             fb.data());
+      this->_textureSize = QSize(fb.width(), fb.height());
     } else {
-      a += {du, dv};
+      // ...otherwise only send the rows that changed
+      int begin = std::max(this->_uploadBegin, 0);
+      int end = std::min(this->_uploadEnd, fb.height());
+      if (begin < end) {
+        this->_uploadRows(begin, end);
+      }
     }
+
+    this->_uploadBegin = NO_ROWS_BEGIN;
+    this->_uploadEnd = NO_ROWS_END;
   }
-}
 
-void MidpointRenderer::_fill() noexcept {
+  this->dataChanged = false;
+  this->viewChanged = false;
 
-  for (auto &i : this->_intersections) {
-    int y = i.first;
-    auto &second = i.second;
-    int size = second.size();
-    std::sort(second.begin(), second.end());
-    for (int j = 0; j < size - 1; j += 2) {
-      int x1 = second[j + 1];
+  if (this->_textureSize.isEmpty())
+    return;
+  // ^ Nothing's been rasterized yet
 
-      for (int x0 = second[j]; x0 < x1; ++x0) {
-        this->_fillPixels.push_back(x0);
-        this->_fillPixels.push_back(y);
-      }
-    }
+  this->gl->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+/**
+ * Copies rows [begin, end) of the front buffer into the next section of the
+ * pixel buffer and has the texture pull them from there.  glTexSubImage2D()
+ * from client memory has to finish copying before it returns; from a buffer
+ * object it's just queued, and the fence tells us when the section is free
+ * again.
+ */
+void MidpointRenderer::_uploadRows(const int begin, const int end) {
+  const Framebuffer &fb = this->_front;
+  int stride = fb.width() * sizeof(Framebuffer::Pixel);
+  int rows = end - begin;
+  int offset = begin * stride;
+
+  if (this->_stream.sectionSize() != stride * fb.height()) {
+    this->_stream.resize(stride * fb.height());
+  }
+  // ^ Each section could have to hold the whole framebuffer
+
+  this->_stream.advance();
+  void *staging = this->_stream.map(offset, rows * stride);
+  if (staging) {
+    std::memcpy(staging, fb.row(begin), rows * stride);
+    this->_stream.unmap();
+    this->gl->glTexSubImage2D(
+        GL_TEXTURE_2D, 0, 0, begin, fb.width(), rows, GL_RGBA,
+        GL_UNSIGNED_BYTE,
+        reinterpret_cast<const void *>(
+            static_cast<quintptr>(this->_stream.offset() + offset)));
+    this->_stream.fence();
   }
+  this->_pbo.release();
+  // ^ Otherwise glTexImage2D() would read from it, too
+}
+
+void MidpointRenderer::setThreadCount(const int threads) noexcept {
+  this->_pipeline.wait();
+  // ^ The rasterizer is the pipeline's while it's working
+  this->_rasterizer.setThreadCount(threads);
 }
@@ -1,17 +1,44 @@
 #ifndef MIDPOINTRENDERER_HPP
 #define MIDPOINTRENDERER_HPP
 
-#include <map>
+#include <mutex>
 #include <vector>
 
+#include <QMatrix4x4>
+#include <QOpenGLBuffer>
+#include <QOpenGLFunctions>
+#include <QPointF>
+#include <QPolygonF>
+#include <QSize>
+
 #include "AbstractRenderer.hpp"
+#include "FrameArena.hpp"
+#include "Framebuffer.hpp"
+#include "GeometryPipeline.hpp"
+#include "Rasterizer.hpp"
+#include "StreamBuffer.hpp"
+#include "VertexStore.hpp"
 
+#include "geometry/LevelOfDetail.hpp"
 #include "model/ShapelyModel.hpp"
 
 class QOpenGLContext;
-class QOpenGLFunctions;
-class QPoint;
+class Profiler;
 
+/**
+ * Rasterizes the polygon on the CPU into a Framebuffer the size of the
+ * viewport, then shows it with one textured quad.  Only the rows that changed
+ * since the last frame are uploaded, through a triple-buffered pixel buffer so
+ * that writing them never waits on the GPU.
+ *
+ * Rasterizing happens on the pipeline's thread, into a back buffer that's
+ * swapped with the front one when it's done; drawPolygon() always shows the
+ * front one, so it never waits for a frame that's still being drawn.
+ *
+ * Once the polygon stops changing, the pipeline also ranks its vertices, and
+ * from then on only rasterizes the ones that are at least a pixel's worth of
+ * detail at the current scale.
+ */
 class MidpointRenderer : public AbstractRenderer {
 public:
   MidpointRenderer(const QString &vertPath, const QString &fragPath,
@@ -20,7 +47,19 @@ public:
   virtual ~MidpointRenderer();
   virtual void drawPolygon() override;
   virtual void updateData(const ShapelyModel &) override;
+  virtual void updateVertex(const ShapelyModel &, const int index) override;
   virtual void updateView(const ShapelyModel &) override;
+  virtual void setLogger(QOpenGLDebugLogger *) override;
+  virtual bool isOpaque() const noexcept override { return true; }
+  virtual void finish() override;
+
+  const Framebuffer &framebuffer() const noexcept { return this->_front; }
+  // ^ The last finished frame; only safe to look at after finish()
+
+  int threadCount() const noexcept { return this->_rasterizer.threadCount(); }
+  void setThreadCount(const int) noexcept;
+  // ^ How many threads fill the polygon, in horizontal bands; defaults to one
+  // per core
 
 protected:
   virtual void drawBackground() override;
@@ -28,25 +67,58 @@ protected:
   virtual void fillPolygon() override;
 
 private:
-  void _computeLine(QPoint, QPoint) noexcept;
-  void _fill() noexcept;
+  struct Snapshot {
+    QMatrix4x4 worldToScreen;
+    QSize size;
+    double tolerance;
+    // ^ A pixel, in world units
+    bool fill;
+    // ^ Whether the polygon is simple (and so filled); if it is, so is every
+    // level of detail drawn
+    Profiler *profiler;
+  };
+
+  void _submit();
+  void _run(const unsigned generation);
+  void _rasterize(const Snapshot &, const unsigned generation) noexcept;
+  void _publish();
+  void _uploadRows(const int begin, const int end);
 
-  ShapelyModel _current;
+  LevelOfDetail _lod;
+  std::vector<int> _kept;
+  // ^ The vertices selected from it for the frame being rasterized
+  FrameArena _scratch;
+  // ^ For ranking; the rasterizer has its own
+  std::vector<QPointF> _points;
+  // ^ The polygon's vertices, in pixels; unclipped, so maybe far outside the
+  // viewport
+  bool _filling;
+  // ^ Whether the frame being rasterized is filled
+  Rasterizer _rasterizer;
+  // ^ These are only touched by the pipeline's thread
 
-  typedef GLfloat CoordType;
-  // ^ So if I change the data representation this changes, too
+  std::mutex _lock;
+  VertexStore _store;
+  // ^ Edited on the GUI thread, synced on the pipeline's
+  Snapshot _next;
+  // ^ What the pipeline's next run will work with
+  Framebuffer _front;
+  int _uploadBegin;
+  int _uploadEnd;
+  // ^ Rows that may differ between the front buffer and the texture
 
-  std::vector<CoordType> _linePixels;
-  std::vector<CoordType> _fillPixels;
+  GLuint _texture;
+  QSize _textureSize;
+  // ^ What the texture was last allocated with
+  QOpenGLBuffer _pbo;
+  StreamBuffer _stream;
+  // ^ Staging for the rows we send to the texture
 
-  std::map<int, std::vector<int>> _intersections;
-  // y, [x, x, x, x...]
   int _position;
-  int _matrix;
-  int _color;
+  int _sampler;
 
-  int _lineNumsOffset;
-  int _fillNumsOffset;
+  GeometryPipeline _pipeline;
+  // ^ Last, so it stops before anything its jobs use is destroyed
 };
 
 #endif // MIDPOINTRENDERER_HPP
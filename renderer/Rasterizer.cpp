@@ -0,0 +1,364 @@
+#include "Rasterizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+
+#include "Utility.hpp"
+
+constexpr int MIN_BAND_ROWS = 32;
+constexpr int BANDS_PER_THREAD = 8;
+// ^ More bands than threads, so work stealing has something to balance
+
+namespace {
+QPoint pixelOf(const QPointF &p) noexcept {
+  return QPoint(static_cast<int>(std::floor(p.x())),
+                static_cast<int>(std::floor(p.y())));
+}
+
+/**
+ * One pass of Sutherland-Hodgman: keeps the part of the polygon on the inside
+ * of the line x = bound (or y = bound, if horizontal), where inside means
+ * below it if below is true, else above it.  The result goes in arena, and n
+ * becomes its size.
+ */
+const QPointF *clipAgainst(const QPointF *in, int &n, FrameArena &arena,
+                           const bool horizontal, const double bound,
+                           const bool below) {
+  auto coordinate = [horizontal](const QPointF &p) {
+    return horizontal ? p.y() : p.x();
+  };
+  auto inside = [&coordinate, bound, below](const QPointF &p) {
+    return below ? coordinate(p) <= bound : coordinate(p) >= bound;
+  };
+
+  if (n == 0)
+    return in;
+
+  int size = 0;
+  bool sInside = inside(in[n - 1]);
+  for (int i = 0; i < n; ++i) {
+    bool eInside = inside(in[i]);
+    size += (eInside != sInside) + eInside;
+    sInside = eInside;
+  }
+  // ^ Counted first, so the result takes no more room than it needs
+
+  QPointF *out = arena.allocate<QPointF>(size);
+  int m = 0;
+
+  QPointF s = in[n - 1];
+  sInside = inside(s);
+  for (int i = 0; i < n; ++i) {
+    const QPointF &e = in[i];
+    bool eInside = inside(e);
+    if (eInside != sInside) {
+      // If this edge crosses the line, keep where it crosses
+      double t = (bound - coordinate(s)) / (coordinate(e) - coordinate(s));
+      QPointF crossing = s + t * (e - s);
+      if (horizontal) {
+        crossing.setY(bound);
+      } else {
+        crossing.setX(bound);
+      }
+      // ^ Exactly on the line, despite rounding
+      out[m++] = crossing;
+    }
+
+    if (eInside) {
+      out[m++] = e;
+    }
+
+    s = e;
+    sInside = eInside;
+  }
+
+  n = size;
+  return out;
+}
+
+/**
+ * Liang-Barsky: shortens ab to the part of it inside rect.
+ *
+ * @return false if none of it is
+ */
+bool clipLine(QPointF &a, QPointF &b, const QRectF &rect) noexcept {
+  QPointF d = b - a;
+  const double p[] = {-d.x(), d.x(), -d.y(), d.y()};
+  const double q[] = {a.x() - rect.left(), rect.right() - a.x(),
+                      a.y() - rect.top(), rect.bottom() - a.y()};
+
+  double t0 = 0;
+  double t1 = 1;
+  for (int i = 0; i < 4; ++i) {
+    if (p[i] == 0) {
+      if (q[i] < 0)
+        return false;
+      // ^ Parallel to this side, and outside of it
+    } else {
+      double t = q[i] / p[i];
+      if (p[i] < 0) {
+        t0 = std::max(t0, t);
+      } else {
+        t1 = std::min(t1, t);
+      }
+    }
+  }
+
+  if (!(t0 <= t1))
+    return false;
+  // ^ Also catches NaNs
+
+  if (t1 < 1) {
+    b = a + t1 * d;
+  }
+  if (t0 > 0) {
+    a += t0 * d;
+  }
+  // ^ Endpoints that weren't clipped are left exactly as they were
+  return true;
+}
+}
+
+Rasterizer::Rasterizer()
+    : _threadCount(std::max<int>(std::thread::hardware_concurrency(), 1)) {}
+
+void Rasterizer::drawOutline(const std::vector<QPoint> &points,
+                             const Framebuffer::Pixel color) noexcept {
+  int verts = points.size();
+  for (int i = 0; i < verts; ++i) {
+    this->drawLine(points[i], points[(i + 1) % verts], color);
+  }
+}
+
+void Rasterizer::fill(const std::vector<QPoint> &points,
+                      const Framebuffer::Pixel color) noexcept {
+  this->_beginFill(points.size());
+  this->_fill(points.data(), points.size(), color);
+}
+
+void Rasterizer::drawOutline(const std::vector<QPointF> &points,
+                             const Framebuffer::Pixel color) noexcept {
+  QRectF rect = this->_clipRect();
+  int verts = points.size();
+  for (int i = 0; i < verts; ++i) {
+    QPointF a = points[i];
+    QPointF b = points[(i + 1) % verts];
+    if (clipLine(a, b, rect)) {
+      this->drawLine(pixelOf(a), pixelOf(b), color);
+    }
+  }
+}
+
+void Rasterizer::fill(const std::vector<QPointF> &points,
+                      const Framebuffer::Pixel color) noexcept {
+  this->_beginFill(points.size());
+
+  int verts = points.size();
+  const QPointF *clipped = this->_clip(points.data(), verts);
+
+  QPoint *pixels = this->_arena.allocate<QPoint>(verts);
+  for (int i = 0; i < verts; ++i) {
+    pixels[i] = pixelOf(clipped[i]);
+  }
+
+  this->_fill(pixels, verts, color);
+}
+
+/**
+ * Starts a new frame's worth of scratch memory, with room for a fill with
+ * about this many vertices: a copy of each (twice, while clipping), an edge
+ * for each, and some per scan line.  Nothing's allocated if the last frame
+ * needed at least as much.
+ */
+void Rasterizer::_beginFill(const int vertices) {
+  this->_arena.reset();
+
+  std::size_t rows = this->_framebuffer.height() + 2;
+  this->_arena.reserve(vertices * (2 * sizeof(QPointF) + sizeof(QPoint) +
+                                   sizeof(EdgeTable::Edge)) +
+                       rows * sizeof(int));
+}
+
+/**
+ * @return The framebuffer, plus a pixel on every side, so that the edges that
+ * clipping adds along it are never drawn
+ */
+QRectF Rasterizer::_clipRect() const noexcept {
+  return QRectF(-1, -1, this->_framebuffer.width() + 1,
+                this->_framebuffer.height() + 1);
+}
+
+/**
+ * @return The polygon clipped to _clipRect(), which is either points itself
+ * (if it's all inside already) or in the arena; n becomes its size
+ */
+const QPointF *Rasterizer::_clip(const QPointF *points, int &n) {
+  QRectF rect = this->_clipRect();
+
+  bool inside = true;
+  for (int i = 0; i < n; ++i) {
+    const QPointF &p = points[i];
+    if (!(rect.left() <= p.x() && p.x() <= rect.right() &&
+          rect.top() <= p.y() && p.y() <= rect.bottom())) {
+      inside = false;
+      break;
+    }
+  }
+
+  if (inside)
+    return points;
+
+  points = clipAgainst(points, n, this->_arena, false, rect.left(), false);
+  points = clipAgainst(points, n, this->_arena, false, rect.right(), true);
+  points = clipAgainst(points, n, this->_arena, true, rect.top(), false);
+  points = clipAgainst(points, n, this->_arena, true, rect.bottom(), true);
+  // ^ Each pass only replaces the outside of one side with a walk along it,
+  // so every pixel inside keeps its crossing count, and the even-odd rule
+  // fills it the same as before
+
+  return points;
+}
+
+/**
+ * Given two points, draw each pixel between them into the framebuffer
+ */
+void Rasterizer::drawLine(QPoint a, QPoint b,
+                          const Framebuffer::Pixel color) noexcept {
+  using jtg::sign;
+  using std::abs;
+
+  int width = b.x() - a.x();
+  int height = b.y() - a.y();
+
+  // In any Bresenham run, there's always two directions you can go; east or
+  // northeast.  This screwing around with signs below helps generalize that to
+  // other slopes (e.g. east/south-east for -1 < slope < 0)
+  int dx = sign(width);
+  int dy = sign(height);
+
+  int du = dx;
+  int dv = dy;
+
+  int longest = abs(width);
+  int shortest = abs(height);
+
+  if (longest <= shortest) {
+    // If the line's absolute slope is greater than 1...
+    longest = abs(height);
+    shortest = abs(width);
+    // ...then swap the axes
+
+    du = 0;
+    dv = dy;
+  } else {
+    du = dx;
+    dv = 0;
+  }
+
+  int rise = longest / 2;
+  // integer multiplies/divides by powers of two usually compile to bit-shifts
+
+  if (dv == 0) {
+    // If this line is closer to horizontal, then each row gets a run of
+    // consecutive pixels; write them a whole run at a time
+    int run = a.x();
+
+    for (int i = 0; i < longest; ++i) {
+      int x = a.x();
+
+      rise += shortest;
+      bool diagonal = rise > longest;
+
+      if (diagonal || i == longest - 1) {
+        // If this is the last pixel of this row...
+        this->_framebuffer.fillSpan(a.y(), std::min(run, x),
+                                    std::max(run, x) + 1, color);
+      }
+
+      if (diagonal) {
+        rise -= longest;
+        a += {dx, dy};
+        run = a.x();
+      } else {
+        a += {du, dv};
+      }
+    }
+
+    return;
+  }
+
+  for (int i = 0; i < longest; ++i) {
+    // For each vertical pixel spanned...
+    this->_framebuffer.plot(a.x(), a.y(), color);
+
+    rise += shortest;
+    if (rise > longest) {
+      rise -= longest;
+      a += {dx, dy};
+    } else {
+      a += {du, dv};
+    }
+  }
+}
+
+void Rasterizer::_fill(const QPoint *points, const int verts,
+                       const Framebuffer::Pixel color) noexcept {
+  this->_edges.clear();
+  for (int i = 0; i < verts; ++i) {
+    this->_edges.addEdge(points[i], points[(i + 1) % verts]);
+  }
+  this->_edges.build(this->_arena);
+
+  int y0 = std::max(this->_edges.yMin(), 0);
+  int y1 = std::min(this->_edges.yMax(), this->_framebuffer.height());
+  int rows = y1 - y0;
+  if (rows <= 0)
+    return;
+
+  this->_framebuffer.markRows(y0, y1);
+  // Mark the rows up front, so the bands don't have to share any state
+
+  int active = this->_edges.maxActive();
+  auto band = [this, color](const int b0, const int b1,
+                            EdgeTable::Edge *scratch) {
+    this->_edges.scan(b0, b1, scratch,
+                      [this, color](const EdgeTable::Span &span) {
+                        this->_framebuffer.fillSpanUntracked(
+                            span.y, span.x0, span.x1, color);
+                      });
+  };
+
+  if (this->_threadCount <= 1 || rows < MIN_BAND_ROWS * 2) {
+    // If it's not worth waking up the other threads...
+    band(y0, y1, this->_arena.allocate<EdgeTable::Edge>(active));
+    return;
+  }
+
+  if (!this->_pool || this->_pool->threadCount() != this->_threadCount) {
+    this->_pool.reset(new WorkerPool(this->_threadCount));
+  }
+
+  EdgeTable::Edge *scratch =
+      this->_arena.allocate<EdgeTable::Edge>(active * this->_threadCount);
+  // ^ One active edge list per thread, not per band
+
+  int bands = std::min(this->_threadCount * BANDS_PER_THREAD,
+                       rows / MIN_BAND_ROWS);
+  auto task = [y0, rows, bands, scratch, active, &band](const int i,
+                                                        const int self) {
+    band(y0 + rows * i / bands, y0 + rows * (i + 1) / bands,
+         scratch + self * active);
+  };
+  this->_pool->run(bands, [&task](const int i, const int self) {
+    task(i, self);
+  });
+  // Each band only writes its own rows, so the result is identical to
+  // rasterizing the whole thing on one thread.  (The lambda passed to run()
+  // only holds a reference, so making a std::function of it doesn't allocate)
+}
+
+void Rasterizer::setThreadCount(const int threads) noexcept {
+  this->_threadCount = std::max(threads, 1);
+}
@@ -0,0 +1,70 @@
+#ifndef RASTERIZER_HPP
+#define RASTERIZER_HPP
+
+#include <memory>
+#include <vector>
+
+#include <QPoint>
+#include <QPointF>
+#include <QRectF>
+
+#include "EdgeTable.hpp"
+#include "FrameArena.hpp"
+#include "Framebuffer.hpp"
+#include "WorkerPool.hpp"
+
+/**
+ * The software rasterizer behind MidpointRenderer: Bresenham lines and
+ * scan-line fills into a Framebuffer.  Knows nothing about OpenGL, so it can
+ * be driven (and benchmarked) without a context.
+ *
+ * Polygons given in continuous pixel coordinates are clipped to the
+ * framebuffer first (Sutherland-Hodgman for the fill, Liang-Barsky for each
+ * edge of the outline), so however far they extend past it, the work and
+ * memory a frame takes are bounded by the framebuffer's size.
+ */
+class Rasterizer {
+public:
+  Rasterizer();
+
+  Framebuffer &framebuffer() noexcept { return this->_framebuffer; }
+  const Framebuffer &framebuffer() const noexcept { return this->_framebuffer; }
+
+  void drawLine(QPoint a, QPoint b, const Framebuffer::Pixel) noexcept;
+  void drawOutline(const std::vector<QPoint> &,
+                   const Framebuffer::Pixel) noexcept;
+  // ^ A closed loop through the given pixels
+  void fill(const std::vector<QPoint> &, const Framebuffer::Pixel) noexcept;
+  // ^ The polygon through the given pixels, by the even-odd rule
+
+  void drawOutline(const std::vector<QPointF> &,
+                   const Framebuffer::Pixel) noexcept;
+  void fill(const std::vector<QPointF> &, const Framebuffer::Pixel) noexcept;
+  // ^ The same, for points anywhere at all in continuous pixel coordinates
+  // (pixel (x, y) covers [x, x + 1) by [y, y + 1)); clipped first
+
+  const FrameArena &arena() const noexcept { return this->_arena; }
+
+  int threadCount() const noexcept { return this->_threadCount; }
+  void setThreadCount(const int) noexcept;
+  // ^ How many threads fill polygons, in horizontal bands; defaults to one per
+  // core
+
+private:
+  void _beginFill(const int vertices);
+  void _fill(const QPoint *, const int verts,
+             const Framebuffer::Pixel) noexcept;
+  QRectF _clipRect() const noexcept;
+  const QPointF *_clip(const QPointF *, int &n);
+
+  EdgeTable _edges;
+  Framebuffer _framebuffer;
+  FrameArena _arena;
+  // ^ Scratch for the fill in progress; reset when the next one starts
+
+  int _threadCount;
+  std::unique_ptr<WorkerPool> _pool;
+  // ^ Created on first use
+};
+
+#endif // RASTERIZER_HPP
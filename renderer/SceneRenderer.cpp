@@ -0,0 +1,603 @@
+#include "SceneRenderer.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include <QOpenGLContext>
+#include <QOpenGLFunctions_3_2_Core>
+#include <QPointF>
+
+#include "Constants.hpp"
+#include "Utility.hpp"
+#include "exception/ShaderException.hpp"
+#include "exception/ShaderProgramException.hpp"
+#include "model/ShapelyModel.hpp"
+
+constexpr int TRANSFORM_UNIT = 1;
+// ^ Not 0, so we don't disturb MidpointRenderer's framebuffer texture
+constexpr int COLUMNS = 4;
+// ^ Texels per transform
+constexpr int BATCH_VERTICES = 1 << 16;
+// ^ How many vertices' worth of triangulations the pipeline makes before it
+// has them drawn, so a scene of many small models isn't a repaint per model
+
+/**
+ * @return How many indices a full triangulation of n vertices can have
+ */
+static int indicesFor(const int n) noexcept { return 3 * std::max(n - 2, 0); }
+
+/**
+ * Reallocates buffer with room for bytes, keeping its first kept bytes.  The
+ * copy happens on the GPU, through a temporary buffer, and it leaves the
+ * element array binding (which belongs to the VAO) alone.
+ */
+static void grow(QOpenGLFunctions_3_2_Core *gl, QOpenGLBuffer &buffer,
+                 const int kept, const int bytes) {
+  GLuint copy = 0;
+  gl->glBindBuffer(GL_COPY_READ_BUFFER, buffer.bufferId());
+  if (kept > 0) {
+    gl->glGenBuffers(1, &copy);
+    gl->glBindBuffer(GL_COPY_WRITE_BUFFER, copy);
+    gl->glBufferData(GL_COPY_WRITE_BUFFER, kept, nullptr, GL_STREAM_COPY);
+    gl->glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                            kept);
+  }
+
+  gl->glBufferData(GL_COPY_READ_BUFFER, bytes, nullptr, GL_DYNAMIC_DRAW);
+
+  if (kept > 0) {
+    gl->glCopyBufferSubData(GL_COPY_WRITE_BUFFER, GL_COPY_READ_BUFFER, 0, 0,
+                            kept);
+    gl->glDeleteBuffers(1, &copy);
+  }
+}
+
+SceneRenderer::SceneRenderer(const QString &vertPath, const QString &fragPath,
+                             QOpenGLContext *context)
+    : _gl(context->versionFunctions<QOpenGLFunctions_3_2_Core>()),
+      _vert(QOpenGLShader::Vertex), _frag(QOpenGLShader::Fragment),
+      _shader(context), _positions(QOpenGLBuffer::VertexBuffer),
+      _modelIds(QOpenGLBuffer::VertexBuffer),
+      _ibo(QOpenGLBuffer::IndexBuffer), _transformBuffer(0),
+      _transformTexture(0), _usedVertices(0), _usedIndices(0),
+      _vertexCapacity(0), _indexCapacity(0), _simpleLines(0),
+      _pipeline([this](const unsigned generation) { this->_run(generation); }) {
+  if (!this->_gl || !this->_gl->initializeOpenGLFunctions()) {
+    throw std::runtime_error("The scene renderer needs OpenGL 3.2");
+  }
+
+  if (!this->_vert.compileSourceFile(vertPath)) {
+    throw ShaderException(this->_vert);
+  }
+
+  if (!this->_frag.compileSourceFile(fragPath)) {
+    throw ShaderException(this->_frag);
+  }
+
+  if (!(this->_shader.addShader(&this->_vert) &&
+        this->_shader.addShader(&this->_frag))) {
+    throw ShaderProgramException(this->_shader);
+  }
+
+  if (!this->_shader.link()) {
+    throw ShaderProgramException(this->_shader);
+  }
+
+  this->_position = this->_shader.attributeLocation("position");
+  this->_model = this->_shader.attributeLocation("model");
+  this->_color = this->_shader.uniformLocation("color");
+  this->_sampler = this->_shader.uniformLocation("transforms");
+
+  GLint program = 0;
+  GLint vao = 0;
+  this->_gl->glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+  this->_gl->glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vao);
+  // ^ The widget's; we put them back when we're done
+
+  if (!this->_vao.create()) {
+    std::ostringstream e;
+    e << "Could not create scene VAO (ID: " << this->_vao.objectId() << ")";
+    throw std::runtime_error(e.str());
+  }
+
+  for (QOpenGLBuffer *buffer :
+       {&this->_positions, &this->_modelIds, &this->_ibo}) {
+    if (!buffer->create()) {
+      std::ostringstream e;
+      e << "Could not create scene buffer (ID: " << buffer->bufferId() << ")";
+      throw std::runtime_error(e.str());
+    }
+    buffer->setUsagePattern(QOpenGLBuffer::DynamicDraw);
+  }
+
+  this->_vao.bind();
+  this->_shader.bind();
+  this->_shader.setUniformValue(this->_sampler, TRANSFORM_UNIT);
+
+  this->_positions.bind();
+  this->_shader.enableAttributeArray(this->_position);
+  this->_gl->glVertexAttribPointer(this->_position, 2, GL_FLOAT, GL_FALSE, 0,
+                                   nullptr);
+  this->_modelIds.bind();
+  this->_shader.enableAttributeArray(this->_model);
+  this->_gl->glVertexAttribIPointer(this->_model, 1, GL_INT, 0, nullptr);
+  this->_ibo.bind();
+  // ^ All of which the VAO remembers
+
+  this->_gl->glGenBuffers(1, &this->_transformBuffer);
+  this->_gl->glGenTextures(1, &this->_transformTexture);
+  this->_gl->glBindBuffer(GL_TEXTURE_BUFFER, this->_transformBuffer);
+  this->_gl->glActiveTexture(GL_TEXTURE0 + TRANSFORM_UNIT);
+  this->_gl->glBindTexture(GL_TEXTURE_BUFFER, this->_transformTexture);
+  this->_gl->glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, this->_transformBuffer);
+  this->_gl->glActiveTexture(GL_TEXTURE0);
+
+  this->_gl->glBindVertexArray(vao);
+  this->_gl->glUseProgram(program);
+}
+
+SceneRenderer::~SceneRenderer() {
+  this->_gl->glDeleteTextures(1, &this->_transformTexture);
+  this->_gl->glDeleteBuffers(1, &this->_transformBuffer);
+  this->_ibo.destroy();
+  this->_modelIds.destroy();
+  this->_positions.destroy();
+  this->_vao.destroy();
+  this->_shader.removeAllShaders();
+}
+
+void SceneRenderer::setResultListener(const Listener &listener) {
+  this->_listener = listener;
+}
+
+void SceneRenderer::updateSize(const int w, const int h) {
+  this->_size = QSize(w, h);
+}
+
+void SceneRenderer::draw(const QVector<QSharedPointer<ShapelyModel>> &models,
+                         const ShapelyModel *skip) {
+  GLint program = 0;
+  GLint vao = 0;
+  GLint unit = 0;
+  this->_gl->glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+  this->_gl->glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vao);
+  this->_gl->glGetIntegerv(GL_ACTIVE_TEXTURE, &unit);
+
+  this->_vao.bind();
+  this->_shader.bind();
+
+  int packed = this->_packed(models);
+  if (packed < static_cast<int>(this->_entries.size())) {
+    this->_pack(models);
+  } else if (packed < models.size()) {
+    this->_append(models, packed);
+  }
+
+  bool requested = false;
+  for (Entry &e : this->_entries) {
+    if (e.model.data() == skip)
+      continue;
+    // ^ The model being edited changes every frame, but it isn't drawn here;
+    // it gets caught up once it's deselected
+
+    if (e.revision != e.model->revision) {
+      this->_update(e);
+    }
+
+    if (e.isSimple && !e.requested) {
+      this->_request(e);
+      requested = true;
+    }
+  }
+
+  if (requested) {
+    this->_pipeline.submit();
+  }
+  this->_collect();
+
+  this->_uploadTransforms();
+  this->_buildDrawTables(skip);
+
+  this->_gl->glActiveTexture(GL_TEXTURE0 + TRANSFORM_UNIT);
+  this->_gl->glBindTexture(GL_TEXTURE_BUFFER, this->_transformTexture);
+
+  if (!this->_fillCounts.empty()) {
+    this->_shader.setUniformValue(this->_color, Constants::POLYGON_COLOR);
+    this->_gl->glMultiDrawElements(GL_TRIANGLES, this->_fillCounts.data(),
+                                   GL_UNSIGNED_INT, this->_fillOffsets.data(),
+                                   this->_fillCounts.size());
+  }
+
+  int lines = this->_lineCounts.size();
+  if (this->_simpleLines > 0) {
+    this->_shader.setUniformValue(this->_color, Constants::OUTLINE_COLOR);
+    this->_gl->glMultiDrawArrays(GL_LINE_LOOP, this->_lineFirsts.data(),
+                                 this->_lineCounts.data(), this->_simpleLines);
+  }
+
+  if (lines > this->_simpleLines) {
+    this->_shader.setUniformValue(this->_color, Constants::COMPLEX_OUTLINE);
+    this->_gl->glMultiDrawArrays(
+        GL_LINE_LOOP, this->_lineFirsts.data() + this->_simpleLines,
+        this->_lineCounts.data() + this->_simpleLines,
+        lines - this->_simpleLines);
+  }
+
+  this->_gl->glActiveTexture(unit);
+  this->_gl->glBindVertexArray(vao);
+  this->_gl->glUseProgram(program);
+}
+
+/**
+ * @return How many of models, from the start, already have entries in the
+ * same places; the rest (if the entries all match) can be appended
+ */
+int SceneRenderer::_packed(
+    const QVector<QSharedPointer<ShapelyModel>> &models) const noexcept {
+  int n = std::min<int>(models.size(), this->_entries.size());
+  for (int i = 0; i < n; ++i) {
+    if (this->_entries[i].model != models[i])
+      return i;
+  }
+
+  return n;
+}
+
+/**
+ * Lays out every model from scratch, for when models were removed or moved.
+ * Vertices are uploaded again, but triangulations that are still for the
+ * models' current revisions are kept (or, if they're still being made, go to
+ * the new slots once they're ready).
+ */
+void SceneRenderer::_pack(
+    const QVector<QSharedPointer<ShapelyModel>> &models) {
+  std::vector<Entry> old;
+  old.swap(this->_entries);
+  std::unordered_map<const ShapelyModel *, int> slots;
+  slots.swap(this->_slots);
+
+  int vertices = 0;
+  int indices = 0;
+  for (const QSharedPointer<ShapelyModel> &model : models) {
+    vertices += model->vertexCount();
+    indices += indicesFor(model->vertexCount());
+  }
+
+  this->_usedVertices = 0;
+  this->_usedIndices = 0;
+  if (vertices > this->_vertexCapacity ||
+      vertices * 4 < this->_vertexCapacity ||
+      indices > this->_indexCapacity || indices * 4 < this->_indexCapacity) {
+    // If the buffers are too small (or way too big), start them over
+    this->_vertexCapacity = 0;
+    this->_indexCapacity = 0;
+  }
+  this->_append(models, 0);
+
+  for (Entry &e : this->_entries) {
+    auto slot = slots.find(e.model.data());
+    if (slot == slots.end())
+      continue;
+
+    Entry &o = old[slot->second];
+    if (!o.requested || o.triangulated != e.revision)
+      continue;
+
+    e.triangles.swap(o.triangles);
+    e.triangulated = o.triangulated;
+    e.requested = true;
+    e.ready = o.ready;
+    if (e.ready && e.isSimple) {
+      this->_writeIndices(e);
+    }
+  }
+}
+
+/**
+ * Gives models[from] onwards entries after the last one, and uploads their
+ * vertices (and model IDs) in one write per buffer.
+ */
+void SceneRenderer::_append(
+    const QVector<QSharedPointer<ShapelyModel>> &models, const int from) {
+  int vertices = 0;
+  int indices = 0;
+  for (int m = from; m < models.size(); ++m) {
+    vertices += models[m]->vertexCount();
+    indices += indicesFor(models[m]->vertexCount());
+  }
+  this->_reserve(vertices, indices);
+
+  int first = this->_usedVertices;
+  this->_positionScratch.resize(vertices * 2);
+  this->_idScratch.resize(vertices);
+  GLfloat *position = this->_positionScratch.data();
+  GLint *id = this->_idScratch.data();
+
+  this->_entries.reserve(models.size());
+  for (int m = from; m < models.size(); ++m) {
+    const QSharedPointer<ShapelyModel> &model = models[m];
+    int n = model->vertexCount();
+    this->_entries.push_back(Entry{model, model->revision,
+                                   this->_usedVertices, n, n,
+                                   this->_usedIndices, 0,
+                                   model->isSimple(),
+                                   QVector<std::uint32_t>(), 0, false, false});
+    this->_slots[model.data()] = m;
+    this->_usedVertices += n;
+    this->_usedIndices += indicesFor(n);
+
+    const QPointF *vertex = model->vertexData();
+    for (int i = 0; i < n; ++i) {
+      *position++ = vertex[i].x();
+      *position++ = vertex[i].y();
+    }
+    id = std::fill_n(id, n, m);
+  }
+
+  if (vertices > 0) {
+    this->_positions.bind();
+    this->_positions.write(first * 2 * sizeof(GLfloat),
+                           this->_positionScratch.data(),
+                           vertices * 2 * sizeof(GLfloat));
+    this->_modelIds.bind();
+    this->_modelIds.write(first * sizeof(GLint), this->_idScratch.data(),
+                          vertices * sizeof(GLint));
+  }
+}
+
+/**
+ * Makes sure there's room for that many more vertices and indices after what's
+ * taken, growing the buffers geometrically so that appending a model at a time
+ * costs O(1) copying per vertex overall.
+ */
+void SceneRenderer::_reserve(const int vertices, const int indices) {
+  int v = this->_usedVertices + vertices;
+  if (v > this->_vertexCapacity) {
+    int capacity = std::max(v, this->_vertexCapacity * 2);
+    grow(this->_gl, this->_positions,
+         this->_usedVertices * 2 * sizeof(GLfloat),
+         capacity * 2 * sizeof(GLfloat));
+    grow(this->_gl, this->_modelIds, this->_usedVertices * sizeof(GLint),
+         capacity * sizeof(GLint));
+    this->_vertexCapacity = capacity;
+  }
+
+  int i = this->_usedIndices + indices;
+  if (i > this->_indexCapacity) {
+    int capacity = std::max(i, this->_indexCapacity * 2);
+    grow(this->_gl, this->_ibo, this->_usedIndices * sizeof(GLuint),
+         capacity * sizeof(GLuint));
+    this->_indexCapacity = capacity;
+  }
+}
+
+/**
+ * Re-sends one model's vertices, moving it to a new slot at the end if it no
+ * longer fits in its own.  Its old triangulation is kept drawn (against the
+ * new vertices) until a new one is ready, as long as it has as many vertices
+ * as before and stayed put.
+ */
+void SceneRenderer::_update(Entry &e) {
+  int n = e.model->vertexCount();
+  bool moved = n > e.room;
+  if (moved) {
+    this->_reserve(n, indicesFor(n));
+    e.first = this->_usedVertices;
+    e.room = n;
+    e.indexFirst = this->_usedIndices;
+    this->_usedVertices += n;
+    this->_usedIndices += indicesFor(n);
+
+    this->_idScratch.assign(n, &e - this->_entries.data());
+    this->_modelIds.bind();
+    this->_modelIds.write(e.first * sizeof(GLint), this->_idScratch.data(),
+                          n * sizeof(GLint));
+  }
+
+  bool resized = n != e.count;
+  e.count = n;
+  e.revision = e.model->revision;
+  e.isSimple = e.model->isSimple();
+  e.requested = false;
+  e.ready = false;
+  if (moved || resized || !e.isSimple) {
+    e.indexCount = 0;
+  }
+
+  this->_writeVertices(e);
+}
+
+void SceneRenderer::_writeVertices(const Entry &e) {
+  if (e.count == 0)
+    return;
+
+  this->_positionScratch.resize(e.count * 2);
+  GLfloat *position = this->_positionScratch.data();
+  const QPointF *vertex = e.model->vertexData();
+  for (int i = 0; i < e.count; ++i) {
+    *position++ = vertex[i].x();
+    *position++ = vertex[i].y();
+  }
+
+  this->_positions.bind();
+  this->_positions.write(e.first * 2 * sizeof(GLfloat),
+                         this->_positionScratch.data(),
+                         e.count * 2 * sizeof(GLfloat));
+}
+
+/**
+ * Writes e's triangulation into its slot in the IBO, pointing into the shared
+ * VBO, and records how many indices that was.
+ */
+void SceneRenderer::_writeIndices(Entry &e) {
+  Q_ASSERT(e.triangles.size() <= indicesFor(e.room));
+  e.indexCount = e.triangles.size();
+  if (e.indexCount == 0)
+    return;
+
+  this->_indexScratch.resize(e.indexCount);
+  GLuint *index = this->_indexScratch.data();
+  for (std::uint32_t i : e.triangles) {
+    *index++ = i + e.first;
+  }
+
+  this->_ibo.bind();
+  this->_ibo.write(e.indexFirst * sizeof(GLuint), this->_indexScratch.data(),
+                   e.indexCount * sizeof(GLuint));
+}
+
+/**
+ * Queues e's model to be triangulated as it is now.  The polygon is shared
+ * with the model (or still mapped from its scene file), not copied, so this
+ * is O(1).
+ */
+void SceneRenderer::_request(Entry &e) {
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    this->_queue.push_back(Job{e.model, e.revision, e.model->polygon,
+                               e.model->vertexData(), e.count});
+  }
+  e.triangulated = e.revision;
+  e.requested = true;
+  e.ready = false;
+}
+
+/**
+ * Takes whatever triangulations the pipeline has finished, and writes the ones
+ * that are still wanted to the IBO.
+ */
+void SceneRenderer::_collect() {
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    this->_taken.swap(this->_results);
+  }
+
+  for (Result &r : this->_taken) {
+    auto slot = this->_slots.find(r.model.data());
+    if (slot == this->_slots.end())
+      continue;
+    // ^ It was removed since
+
+    Entry &e = this->_entries[slot->second];
+    if (!e.requested || e.triangulated != r.revision)
+      continue;
+    // ^ It was changed since, and a newer one is on its way
+
+    e.triangles.swap(r.triangles);
+    e.ready = true;
+    if (e.revision == r.revision && e.isSimple) {
+      this->_writeIndices(e);
+    }
+  }
+  this->_taken.clear();
+}
+
+/**
+ * Triangulates queued models until there are none left, or until this run is
+ * stale (in which case the next one carries on where it left off).
+ */
+void SceneRenderer::_run(const unsigned generation) {
+  int vertices = 0;
+  // ^ Triangulated since the listener was last called
+
+  for (;;) {
+    Job job;
+    {
+      std::lock_guard<std::mutex> guard(this->_lock);
+      if (this->_queue.empty() || this->_pipeline.isStale(generation))
+        break;
+
+      job = std::move(this->_queue.front());
+      this->_queue.pop_front();
+    }
+
+    const QPolygonF *polygon = &job.polygon;
+    if (job.polygon.size() != job.count) {
+      this->_mapped.resize(job.count);
+      std::copy_n(job.vertices, job.count, this->_mapped.begin());
+      polygon = &this->_mapped;
+    }
+    // ^ It's still in its scene file, and the ear clipper wants a QPolygonF
+
+    this->_scratch.reset();
+    Result result{job.model, job.revision, QVector<std::uint32_t>()};
+    jtg::decomposePolygon(*polygon, result.triangles, this->_scratch);
+    {
+      std::lock_guard<std::mutex> guard(this->_lock);
+      this->_results.push_back(std::move(result));
+    }
+
+    vertices += job.count;
+    if (vertices >= BATCH_VERTICES) {
+      vertices = 0;
+      if (this->_listener) {
+        this->_listener();
+      }
+    }
+  }
+
+  if (vertices > 0 && this->_listener) {
+    this->_listener();
+  }
+}
+
+/**
+ * Sends every model's world-to-screen transform.  Transforms change with no
+ * revision bump (and they're tiny next to the vertices), so this just happens
+ * every frame, into fresh storage so it never waits on the last frame's.
+ */
+void SceneRenderer::_uploadTransforms() {
+  float w = this->_size.width();
+  float h = this->_size.height();
+
+  QMatrix4x4 p;
+  p.ortho(-w, w, -h, h, 0, 1);
+
+  this->_transforms.resize(this->_entries.size() * COLUMNS * 4);
+  GLfloat *column = this->_transforms.data();
+  for (const Entry &e : this->_entries) {
+    QMatrix4x4 v;
+    v.translate(e.model->cameraCoords.x(), e.model->cameraCoords.y());
+
+    QMatrix4x4 wTs = p * v * e.model->transform;
+    column = std::copy_n(wTs.constData(), COLUMNS * 4, column);
+    // ^ Column-major, as texelFetch() wants it
+  }
+
+  this->_gl->glBindBuffer(GL_TEXTURE_BUFFER, this->_transformBuffer);
+  this->_gl->glBufferData(GL_TEXTURE_BUFFER,
+                          this->_transforms.size() * sizeof(GLfloat),
+                          this->_transforms.data(), GL_STREAM_DRAW);
+}
+
+void SceneRenderer::_buildDrawTables(const ShapelyModel *skip) {
+  this->_lineFirsts.clear();
+  this->_lineCounts.clear();
+  this->_fillOffsets.clear();
+  this->_fillCounts.clear();
+
+  for (const Entry &e : this->_entries) {
+    if (e.model.data() == skip)
+      continue;
+
+    if (e.indexCount > 0) {
+      this->_fillOffsets.push_back(reinterpret_cast<const void *>(
+          static_cast<quintptr>(e.indexFirst * sizeof(GLuint))));
+      this->_fillCounts.push_back(e.indexCount);
+    }
+
+    if (e.isSimple && e.count >= 2) {
+      this->_lineFirsts.push_back(e.first);
+      this->_lineCounts.push_back(e.count);
+    }
+  }
+  this->_simpleLines = this->_lineCounts.size();
+
+  for (const Entry &e : this->_entries) {
+    if (e.model.data() != skip && !e.isSimple && e.count >= 2) {
+      this->_lineFirsts.push_back(e.first);
+      this->_lineCounts.push_back(e.count);
+    }
+  }
+}
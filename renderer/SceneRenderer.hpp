@@ -0,0 +1,178 @@
+#ifndef SCENERENDERER_HPP
+#define SCENERENDERER_HPP
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <QMatrix4x4>
+#include <QOpenGLBuffer>
+#include <QOpenGLShader>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLVertexArrayObject>
+#include <QPolygonF>
+#include <QSharedPointer>
+#include <QSize>
+#include <QVector>
+
+#include "FrameArena.hpp"
+#include "GeometryPipeline.hpp"
+
+class QOpenGLContext;
+class QOpenGLFunctions_3_2_Core;
+struct ShapelyModel;
+
+/**
+ * Draws every polygon in the scene except the one being edited, in a constant
+ * number of draw calls no matter how many there are.
+ *
+ * All the polygons' vertices live back to back in one VBO, each tagged with its
+ * model's index, and all their triangulations in one IBO.  Each model's
+ * transform is a column of four texels in a texture buffer, which the vertex
+ * shader looks up by that index.  So one glMultiDrawElements() fills them all,
+ * and two glMultiDrawArrays() outline them (simple and complex, in different
+ * colors), with per-model offset tables saying where each one starts.
+ *
+ * Only models whose revision changed since the last frame get re-uploaded, and
+ * models added to the end of the list are packed in after the rest, with the
+ * buffers growing geometrically (on the GPU, so nothing already there comes
+ * back through the CPU).  A model that grew past its slot moves to the end;
+ * everything is only packed again when models are removed or reordered.
+ *
+ * Triangulations are made on a pipeline of their own and cached with the
+ * revision they're for, so neither packing nor a model changing ever ear-clips
+ * anything on the GUI thread.  A model's outline is drawn right away, and its
+ * fill once its triangulation is ready.
+ */
+class SceneRenderer {
+public:
+  SceneRenderer(const QString &vertPath, const QString &fragPath,
+                QOpenGLContext *context);
+  ~SceneRenderer();
+
+  typedef std::function<void()> Listener;
+  void setResultListener(const Listener &);
+  // ^ Called on the pipeline's thread whenever there are triangulations ready
+  // to draw
+
+  void updateSize(const int w, const int h);
+
+  /**
+   * Draws models, skipping skip (if it's one of them).  Restores the shader
+   * program and vertex array that were bound before.
+   */
+  void draw(const QVector<QSharedPointer<ShapelyModel>> &models,
+            const ShapelyModel *skip);
+
+private:
+  struct Entry {
+    QSharedPointer<ShapelyModel> model;
+    unsigned revision;
+    // ^ Of the vertices in the VBO
+    int first;
+    int count;
+    int room;
+    // ^ Vertices, in the VBO, and how many fit in the slot
+    int indexFirst;
+    int indexCount;
+    // ^ Indices, in the IBO; the slot fits a full triangulation of room
+    // vertices, but indexCount may be less (or 0, if the polygon isn't simple
+    // or its triangulation isn't ready)
+    bool isSimple;
+    QVector<std::uint32_t> triangles;
+    unsigned triangulated;
+    bool requested;
+    bool ready;
+    // ^ The triangulation of revision triangulated, in the model's own
+    // numbering, if it's been requested and is ready
+  };
+
+  struct Job {
+    QSharedPointer<ShapelyModel> model;
+    unsigned revision;
+    QPolygonF polygon;
+    // ^ Shares the model's storage until the model is edited
+    const QPointF *vertices;
+    int count;
+    // ^ polygon's, or (if the model hasn't been loaded from its scene file)
+    // the mapped ones
+  };
+
+  struct Result {
+    QSharedPointer<ShapelyModel> model;
+    unsigned revision;
+    QVector<std::uint32_t> triangles;
+  };
+
+  int _packed(const QVector<QSharedPointer<ShapelyModel>> &) const noexcept;
+  void _pack(const QVector<QSharedPointer<ShapelyModel>> &);
+  void _append(const QVector<QSharedPointer<ShapelyModel>> &, const int from);
+  void _reserve(const int vertices, const int indices);
+  void _update(Entry &);
+  void _writeVertices(const Entry &);
+  void _writeIndices(Entry &);
+  void _request(Entry &);
+  void _collect();
+  void _run(const unsigned generation);
+  void _uploadTransforms();
+  void _buildDrawTables(const ShapelyModel *skip);
+
+  QOpenGLFunctions_3_2_Core *_gl;
+  QOpenGLShader _vert;
+  QOpenGLShader _frag;
+  QOpenGLShaderProgram _shader;
+  QOpenGLVertexArrayObject _vao;
+  QOpenGLBuffer _positions;
+  QOpenGLBuffer _modelIds;
+  QOpenGLBuffer _ibo;
+  GLuint _transformBuffer;
+  GLuint _transformTexture;
+
+  std::vector<Entry> _entries;
+  std::unordered_map<const ShapelyModel *, int> _slots;
+  // ^ Where each model's entry is
+  int _usedVertices;
+  int _usedIndices;
+  int _vertexCapacity;
+  int _indexCapacity;
+  // ^ How much of the VBOs and IBO is taken (including slots left behind by
+  // models that moved to the end), and how much is allocated
+  std::vector<GLfloat> _positionScratch;
+  std::vector<GLint> _idScratch;
+  std::vector<GLuint> _indexScratch;
+  std::vector<Result> _taken;
+  // ^ Staging, kept so that it stops allocating once it's big enough
+  std::vector<GLfloat> _transforms;
+  // ^ Four columns per model
+  QSize _size;
+
+  std::vector<GLint> _lineFirsts;
+  std::vector<GLsizei> _lineCounts;
+  int _simpleLines;
+  // ^ The first _simpleLines outlines are of simple polygons, the rest complex
+  std::vector<const void *> _fillOffsets;
+  std::vector<GLsizei> _fillCounts;
+  // ^ Draw tables, rebuilt every frame since they're small
+
+  int _position;
+  int _model;
+  int _color;
+  int _sampler;
+
+  FrameArena _scratch;
+  QPolygonF _mapped;
+  // ^ Only touched by the pipeline's thread
+
+  std::mutex _lock;
+  std::deque<Job> _queue;
+  std::vector<Result> _results;
+  // ^ Triangulations still to make, and made but not drawn yet
+  Listener _listener;
+  GeometryPipeline _pipeline;
+  // ^ Last, so it stops before anything its jobs use is destroyed
+};
+
+#endif // SCENERENDERER_HPP
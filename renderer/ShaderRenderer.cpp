@@ -1,26 +1,76 @@
 ﻿#include "ShaderRenderer.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <utility>
 
 #include <QtGlobal>
 #include <QColor>
 #include <QVector4D>
 #include <QMatrix3x3>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
 #include <QOpenGLFunctions>
 #include <QOpenGLBuffer>
+#include <QPolygonF>
+#include <QRectF>
 #include <QSurfaceFormat>
 #include <QTransform>
+#include <QtMath>
 
 #include "Constants.hpp"
 #include "Utility.hpp"
 #include "exception/ShaderException.hpp"
 #include "exception/ShaderProgramException.hpp"
 #include "model/ShapelyModel.hpp"
+#include "profiling/Profiler.hpp"
+
+constexpr int COVER_VERTICES = 4;
+// ^ The stencil modes' cover quad, at the start of the VBO
+constexpr int MARKER_VERTICES = Constants::MARKER_RESOLUTION;
+// ^ The marker circle, right after it
+constexpr int STRIDE = 2 * sizeof(GLfloat);
+
+namespace {
+/**
+ * Fills the index buffer with the triangulation followed by the outline,
+ * shifted past the cover quad and marker circle, as T (GLushort or GLuint).
+ * indices is just scratch, kept around so that uploading doesn't allocate.
+ */
+template <class T>
+void allocateIndices(QOpenGLBuffer &ibo, std::vector<T> &indices,
+                     const QVector<std::uint32_t> &triangles,
+                     const QVector<std::uint32_t> &outline, const int offset) {
+  indices.clear();
+  indices.reserve(triangles.size() + outline.size());
+  for (std::uint32_t i : triangles) {
+    indices.push_back(i + offset);
+  }
+  for (std::uint32_t i : outline) {
+    indices.push_back(i + offset);
+  }
+  ibo.allocate(indices.data(), indices.size() * sizeof(T));
+}
+}
 
 ShaderRenderer::ShaderRenderer(const QString &vertPath, const QString &fragPath,
                                QOpenGLContext *context, QOpenGLFunctions *gl,
                                QOpenGLBuffer *vbo)
-    : AbstractRenderer(context, gl, vbo) {
+    : AbstractRenderer(context, gl, vbo), _indexedVertices(0),
+      _ibo(QOpenGLBuffer::IndexBuffer), _indexType(GL_UNSIGNED_SHORT),
+      _indexCount(0), _outlineCount(0), _indicesChanged(false), _tolerance(0),
+      _stream(context, vbo, "Vertex"),
+      _vertexOffset(COVER_VERTICES + MARKER_VERTICES), _vertexCount(0),
+      _bufferedVertices(0), _compact(false), _isSimple(false),
+      _markerOffset(COVER_VERTICES), _showMarkers(true),
+      _extra(context->extraFunctions()), _triangulatedVertices(0),
+      _triangulatedResets(0), _triangulatedEdits(0), _triangulated(false),
+      _pipeline([this](const unsigned generation) { this->_run(generation); }) {
 
   if (!this->vert.compileSourceFile(vertPath)) {
     throw ShaderException(vert);
@@ -42,34 +92,381 @@ ShaderRenderer::ShaderRenderer(const QString &vertPath, const QString &fragPath,
   this->_matrix = shader.uniformLocation("matrix");
   this->_color = shader.uniformLocation("color");
 
+  this->_markerScale = shader.uniformLocation("markerScale");
+
   this->_position = shader.attributeLocation("position");
   shader.enableAttributeArray(this->_position);
   this->gl->glVertexAttribPointer(this->_position, 2, GL_FLOAT, GL_TRUE, 0, 0);
   shader.setUniformValue(this->_matrix, QMatrix4x4(this->worldToScreen));
+
+  this->_offset = shader.attributeLocation("offset");
+  shader.setAttributeValue(this->_offset, 0.0f, 0.0f);
+  // ^ Only the markers read it from the VBO
+
+  this->_vertices.resize(this->_vertexOffset * 2);
+  NumberType *vertex = this->_vertices.data() + this->_markerOffset * 2;
+  for (int i = 0; i < MARKER_VERTICES; ++i) {
+    double angle = 2 * M_PI * i / MARKER_VERTICES;
+    *vertex++ = std::cos(angle);
+    *vertex++ = std::sin(angle);
+  }
+  // ^ A unit circle; the vertex shader scales it to MARKER_RADIUS pixels
+
+  if (!this->_ibo.create()) {
+    std::ostringstream e;
+    e << "Could not create IBO (ID: " << this->_ibo.bufferId() << ")";
+    throw std::runtime_error(e.str());
+  }
+  this->_ibo.setUsagePattern(QOpenGLBuffer::StaticDraw);
 }
 
 ShaderRenderer::~ShaderRenderer() {
   shader.disableAttributeArray(this->_position);
+  this->_ibo.destroy();
 }
 
 void ShaderRenderer::updateData(const ShapelyModel &model) {
-  using std::sin;
-  using std::cos;
-  using Constants::MARKER_RADIUS;
-  using Constants::MARKER_RESOLUTION;
-  this->_vertices.clear();
-  this->_vertices.reserve(model.polygon.size() * 2);
-  // may change if more vertex attributes are added
+  int n = model.polygon.size();
+  this->_vertexCount = n;
+
+  this->_bounds = model.polygon.boundingRect();
+  this->_updateCover();
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    this->_store.reset(model.polygon);
+  }
+  this->_indexedVertices = -1;
+  this->_indices.clear();
+  this->_outline.clear();
+  // ^ The last indices may be for another polygon with as many vertices, or
+  // for this one before vertices were inserted or removed; either way, none of
+  // them are drawn until the pipeline makes new ones
+
+  if (n < 3) {
+    this->_expand(model.polygon);
+    // ^ The pipeline has nothing to do for these, so they go in as they are
+  } else {
+    this->_vertices.resize(this->_vertexOffset * 2);
+    this->_bufferedVertices = 0;
+    this->_compact = true;
+    // ^ The pipeline picks what goes in, with only the vertices that show at
+    // this scale once it's ranked them
+  }
+  this->_updateFill(model);
+
+  this->_stream.markDirty(this->_markerOffset * STRIDE,
+                          this->_vertexOffset * STRIDE);
+  // ^ The marker circle never changes, but a new buffer needs it, too
+  this->dataChanged = true;
+}
+
+void ShaderRenderer::updateVertex(const ShapelyModel &model, const int index) {
+  int n = model.polygon.size();
+  bool appended = (n == this->_vertexCount + 1 && index == n - 1);
+
+  if (n != this->_vertexCount && !appended) {
+    // If this isn't a move or an append, everything after index moved
+    this->updateData(model);
+    return;
+  }
+
+  const QPointF &point = model.polygon[index];
+  int slot = this->_vertexOffset + index;
+  this->_vertexCount = n;
 
-  for (const QPointF &point : model.polygon) {
+  if (this->_compact) {
+    this->_expand(model.polygon);
+  } else if (appended) {
     this->_vertices.push_back(point.x());
     this->_vertices.push_back(point.y());
+    ++this->_bufferedVertices;
+  } else {
+    this->_vertices[slot * 2] = point.x();
+    this->_vertices[slot * 2 + 1] = point.y();
   }
 
-  this->shouldFillPolygon = jtg::isSimplePolygon(model.polygon);
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    if (appended) {
+      this->_store.appendVertex(point);
+    } else {
+      this->_store.moveVertex(index, point);
+    }
+  }
+
+  this->_stream.markDirty(slot * STRIDE, (slot + 1) * STRIDE);
+
+  QRectF &b = this->_bounds;
+  if (n == 1) {
+    b = QRectF(point, point);
+    this->_updateCover();
+  } else if (point.x() < b.left() || point.x() > b.right() ||
+             point.y() < b.top() || point.y() > b.bottom()) {
+    b.setLeft(qMin(b.left(), point.x()));
+    b.setRight(qMax(b.right(), point.x()));
+    b.setTop(qMin(b.top(), point.y()));
+    b.setBottom(qMax(b.bottom(), point.y()));
+    this->_updateCover();
+  }
+  // ^ The cover quad only has to contain the polygon, so it never shrinks
+  // here; updateData() makes it tight again
+
+  this->_updateFill(model);
   this->dataChanged = true;
 }
 
+/**
+ * Puts every vertex in the vertex buffer, in order, so that updateVertex() can
+ * edit them in place, and renumbers the last indices to match.  That's O(n)
+ * once, when a drag (or a run of appends) starts; the pipeline cuts the buffer
+ * down again once it catches up with the last edit.
+ */
+void ShaderRenderer::_expand(const QPolygonF &polygon) {
+  int n = polygon.size();
+  this->_vertices.resize((this->_vertexOffset + n) * 2);
+  // may change if more vertex attributes are added
+
+  NumberType *vertex = this->_vertices.data() + this->_vertexOffset * 2;
+  for (const QPointF &point : polygon) {
+    *vertex++ = point.x();
+    *vertex++ = point.y();
+  }
+  this->_bufferedVertices = n;
+  this->_stream.markDirty(this->_vertexOffset * STRIDE,
+                          (this->_vertexOffset + n) * STRIDE);
+  this->dataChanged = true;
+
+  if (this->_compact && !this->_outline.isEmpty()) {
+    for (std::uint32_t &i : this->_indices) {
+      i = this->_outline[i];
+    }
+    this->_indicesChanged = true;
+    // ^ Also so that the outline goes in the index buffer
+  }
+  this->_compact = false;
+}
+
+/**
+ * Writes the stencil modes' cover quad (the bounding box, as a triangle strip)
+ * to the start of the vertex buffer.
+ */
+void ShaderRenderer::_updateCover() {
+  const QRectF &b = this->_bounds;
+  NumberType *vertex = this->_vertices.data();
+  for (const QPointF &corner :
+       {b.topLeft(), b.topRight(), b.bottomLeft(), b.bottomRight()}) {
+    *vertex++ = corner.x();
+    *vertex++ = corner.y();
+  }
+
+  this->_stream.markDirty(0, COVER_VERTICES * STRIDE);
+}
+
+/**
+ * Decides whether (and how) to fill the polygon.  Triangulating (and picking
+ * the level of detail) has to look at the whole polygon again, so it's left to
+ * the pipeline; the stencil modes don't need anything else.
+ */
+void ShaderRenderer::_updateFill(const ShapelyModel &model) {
+  this->_isSimple = model.isSimple();
+
+  if (this->fillMode != Triangulate) {
+    this->shouldFillPolygon = this->_vertexCount >= 3;
+  } else {
+    this->shouldFillPolygon = this->_isSimple;
+  }
+
+  this->_submit();
+}
+
+/**
+ * Hands the polygon as it is now to the pipeline.  Until it's done, we keep
+ * drawing the last vertices and indices it made, as long as they're for the
+ * right number of vertices.
+ */
+void ShaderRenderer::_submit() {
+  if (this->_vertexCount < 3) {
+    // If there's nothing to simplify or fill, don't bother the pipeline
+    this->_pipeline.cancel();
+    {
+      std::lock_guard<std::mutex> guard(this->_lock);
+      this->_triangulated = false;
+    }
+
+    if (!this->_indices.isEmpty() || !this->_outline.isEmpty()) {
+      this->_indices.clear();
+      this->_outline.clear();
+      this->_indicesChanged = true;
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    this->_next = {this->_tolerance, this->_isSimple,
+                   this->shouldFillPolygon && this->fillMode == Triangulate,
+                   this->profiler};
+  }
+  this->_pipeline.submit();
+}
+
+/**
+ * Runs on the pipeline's thread: takes the latest snapshot and edits, and
+ * indexes them, with only the vertices that show once they've been ranked.
+ */
+void ShaderRenderer::_run(const unsigned generation) {
+  Snapshot snapshot;
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    snapshot = this->_next;
+    this->_store.sync();
+    snapshot.resets = this->_store.resets();
+    snapshot.edits = this->_store.edits();
+  }
+
+  const std::function<bool()> cancelled = [this, generation]() {
+    return this->_pipeline.isStale(generation);
+  };
+  // ^ Only captures what fits in a std::function without allocating
+  bool ranked = this->_lod.refine(
+      this->_store.polygon(), this->_store.revision(), snapshot.tolerance,
+      snapshot.simple, this->_kept, this->_scratch, cancelled,
+      [this, &snapshot, generation]() { this->_index(snapshot, generation); });
+  if (ranked && snapshot.profiler) {
+    snapshot.profiler->recordScratch(this->_scratch.bytes());
+  }
+}
+
+/**
+ * Makes the outline and triangulation indices for the vertices in _kept (or
+ * all of them, if it's empty) and publishes them.  Ear clipping can't stop
+ * halfway, but its result is thrown away if a newer snapshot came in
+ * meanwhile.
+ */
+void ShaderRenderer::_index(const Snapshot &snapshot,
+                            const unsigned generation) {
+  const QPolygonF &polygon = this->_store.polygon();
+  QVector<std::uint32_t> &outline = this->_nextOutline;
+  QVector<std::uint32_t> &triangles = this->_nextTriangles;
+  outline.clear();
+  triangles.clear();
+  // ^ Both keep their capacity, so once they've been around the cycle with
+  // _indices and _outline, this doesn't allocate
+
+  if (!this->_kept.empty() &&
+      static_cast<int>(this->_kept.size()) < polygon.size()) {
+    outline.reserve(this->_kept.size());
+    for (int i : this->_kept) {
+      outline.append(i);
+    }
+  }
+
+  if (snapshot.triangulate && outline.isEmpty()) {
+    if (!this->_publish(snapshot, generation))
+      return;
+
+    outline.clear();
+    triangles.clear();
+    // ^ Whatever came back
+  }
+  // ^ Ear clipping every vertex can take seconds, so the outline goes first
+
+  if (snapshot.triangulate) {
+    Profiler::Scope scope(snapshot.profiler, Profiler::Triangulate);
+    this->_scratch.reset();
+
+    if (outline.isEmpty()) {
+      jtg::decomposePolygon(polygon, triangles, this->_scratch);
+    } else {
+      QPolygonF &simplified = this->_simplifiedPolygon;
+      simplified.clear();
+      simplified.reserve(outline.size());
+      for (std::uint32_t i : outline) {
+        simplified.append(polygon[i]);
+      }
+
+      jtg::decomposePolygon(simplified, triangles, this->_scratch);
+      // ^ Numbered like the vertex buffer is once drawPolygon() cuts it down
+      // to these
+    }
+
+    if (snapshot.profiler) {
+      snapshot.profiler->recordScratch(this->_scratch.bytes());
+    }
+  }
+
+  this->_publish(snapshot, generation);
+}
+
+/**
+ * Hands _nextTriangles and _nextOutline to drawPolygon(), with the vertices
+ * they use if nothing's been edited since the snapshot (otherwise it only
+ * wants the indices).
+ *
+ * @return false if a newer snapshot came in, so nothing was published
+ */
+bool ShaderRenderer::_publish(const Snapshot &snapshot,
+                              const unsigned generation) {
+  const QPolygonF &polygon = this->_store.polygon();
+  const QVector<std::uint32_t> &outline = this->_nextOutline;
+  std::vector<NumberType> &points = this->_nextPoints;
+
+  bool current;
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    current = snapshot.edits == this->_store.edits();
+  }
+  // ^ Edits only ever add up, so if this is already out of date, it will be
+  // when drawPolygon() looks, too
+
+  points.clear();
+  if (current && outline.isEmpty()) {
+    points.reserve(polygon.size() * 2);
+    for (const QPointF &point : polygon) {
+      points.push_back(point.x());
+      points.push_back(point.y());
+    }
+  } else if (current) {
+    points.reserve(outline.size() * 2);
+    for (std::uint32_t i : outline) {
+      points.push_back(polygon[i].x());
+      points.push_back(polygon[i].y());
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    if (this->_pipeline.isStale(generation))
+      return false;
+    // ^ Checked under the lock, so a cancel() can't slip in before we publish
+
+    this->_triangulation.swap(this->_nextTriangles);
+    this->_simplified.swap(this->_nextOutline);
+    this->_drawn.swap(points);
+    this->_triangulatedVertices = polygon.size();
+    this->_triangulatedResets = snapshot.resets;
+    this->_triangulatedEdits = snapshot.edits;
+    this->_triangulated = true;
+  }
+  // ^ What we get back is either a result nobody took, or the buffers
+  // drawPolygon() was done with; either way, they're reused next time
+
+  if (this->resultListener) {
+    this->resultListener();
+  }
+  return true;
+}
+
+void ShaderRenderer::finish() { this->_pipeline.wait(); }
+
+void ShaderRenderer::setLogger(QOpenGLDebugLogger *logger) {
+  this->_stream.setLogger(logger);
+}
+
+void ShaderRenderer::setMarkersVisible(const bool visible) noexcept {
+  this->_showMarkers = visible;
+}
+
 void ShaderRenderer::updateView(const ShapelyModel &model) {
   float w = this->size.width();
   float h = this->size.height();
@@ -93,38 +490,168 @@ void ShaderRenderer::updateView(const ShapelyModel &model) {
     this->screenToWorld = sTw;
     this->projection = p;
     this->viewChanged = true;
+
+    double tolerance = LevelOfDetail::tolerance(wTs, this->size);
+    if (tolerance != this->_tolerance) {
+      // If the scale changed enough to draw a different level of detail...
+      this->_tolerance = tolerance;
+      this->_submit();
+    }
   }
 }
 
 void ShaderRenderer::drawBackground() {}
 
 void ShaderRenderer::drawLines() {
-  shader.setUniformValue(this->_color, this->shouldFillPolygon
+  shader.setUniformValue(this->_color, this->_isSimple
                                            ? Constants::OUTLINE_COLOR
                                            : Constants::COMPLEX_OUTLINE);
-  this->gl->glDrawArrays(GL_LINE_LOOP, this->_vertexOffset,
-                         this->_vertices.size() / 2); // hack
+  this->_drawOutline(GL_LINE_LOOP);
+}
+
+/**
+ * Draws the polygon's vertices in order, with the given primitive: only the
+ * ones at the current level of detail if the pipeline has picked them (for
+ * this many vertices), else all of them.
+ */
+void ShaderRenderer::_drawOutline(const GLenum mode) {
+  if (this->_outlineCount && this->_indexedVertices == this->_vertexCount) {
+    // If the buffer has every vertex, but not all of them show...
+    quintptr size = (this->_indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort)
+                                                             : sizeof(GLuint);
+    const void *outline =
+        reinterpret_cast<const void *>(this->_indexCount * size);
+    // ^ The outline comes after the triangulation
+
+    this->_ibo.bind();
+    this->gl->glDrawElements(mode, this->_outlineCount, this->_indexType,
+                             outline);
+  } else {
+    this->gl->glDrawArrays(mode, this->_vertexOffset,
+                           this->_bufferedVertices);
+  }
+}
+
+/**
+ * Draws a circle around every vertex in one instanced call.  The circle's own
+ * vertices are the per-vertex offsets, and the polygon's vertices, read from
+ * where they already are in the VBO, are the per-instance centers; so nothing
+ * extra is generated or uploaded, however many vertices there are.
+ */
+void ShaderRenderer::_drawMarkers() {
+  auto at = [this](const int vertex) {
+    return reinterpret_cast<const void *>(
+        static_cast<quintptr>(this->_stream.offset() + vertex * STRIDE));
+  };
+
+  shader.setUniformValue(this->_color, Constants::MARKER_COLOR);
+  this->vbo->bind();
+
+  this->gl->glVertexAttribPointer(this->_position, 2, GL_FLOAT, GL_TRUE, 0,
+                                  at(this->_vertexOffset));
+  this->_extra->glVertexAttribDivisor(this->_position, 1);
+  shader.enableAttributeArray(this->_offset);
+  this->gl->glVertexAttribPointer(this->_offset, 2, GL_FLOAT, GL_FALSE, 0,
+                                  at(this->_markerOffset));
+
+  this->_extra->glDrawArraysInstanced(GL_LINE_LOOP, 0, MARKER_VERTICES,
+                                      this->_bufferedVertices);
+
+  shader.disableAttributeArray(this->_offset);
+  shader.setAttributeValue(this->_offset, 0.0f, 0.0f);
+  this->_extra->glVertexAttribDivisor(this->_position, 0);
+  this->gl->glVertexAttribPointer(this->_position, 2, GL_FLOAT, GL_TRUE, 0,
+                                  at(0));
+  // ^ Back to how the other draws expect them
 }
 
 void ShaderRenderer::fillPolygon() {
   shader.setUniformValue(this->_color, Constants::POLYGON_COLOR);
-  this->gl->glDrawArrays(GL_TRIANGLE_FAN, this->_vertexOffset,
-                         this->_vertices.size() / 2); // hack
+
+  if (this->fillMode == Triangulate) {
+    if (this->_indexedVertices != this->_vertexCount)
+      return;
+    // ^ They're for another polygon, or vertices were added since.  Only
+    // updateVertex()'s moves keep them, so that a dragged vertex's old ears
+    // are drawn (against every vertex, where they are now) until the pipeline
+    // catches up
+
+    this->_ibo.bind();
+    this->gl->glDrawElements(GL_TRIANGLES, this->_indexCount,
+                             this->_indexType, nullptr);
+  } else {
+    this->_fillStencil();
+  }
+}
+
+/**
+ * Stencil-then-cover.  A triangle fan from the first vertex covers each pixel
+ * once for every time the polygon winds around it (with the sign of the
+ * winding given by the triangle's facing), so drawing the fan into the stencil
+ * buffer leaves the winding number (nonzero) or its parity (even-odd) there.
+ * Then one quad over the bounding box draws wherever the stencil isn't zero,
+ * and zeroes it on the way for the next frame.
+ */
+void ShaderRenderer::_fillStencil() {
+  GLuint mask = (this->fillMode == EvenOdd) ? 0x01 : 0xFF;
+
+  this->gl->glEnable(GL_STENCIL_TEST);
+  this->gl->glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+  this->gl->glStencilMask(mask);
+  this->gl->glStencilFunc(GL_ALWAYS, 0, mask);
+
+  if (this->fillMode == EvenOdd) {
+    this->gl->glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+  } else {
+    this->gl->glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INCR_WRAP);
+    this->gl->glStencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_DECR_WRAP);
+    // ^ Winding numbers are only kept mod 256, which is plenty in practice
+  }
+
+  this->_drawOutline(GL_TRIANGLE_FAN);
+
+  this->gl->glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  this->gl->glStencilFunc(GL_NOTEQUAL, 0, mask);
+  this->gl->glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+  this->gl->glDrawArrays(GL_TRIANGLE_STRIP, 0, COVER_VERTICES);
+
+  this->gl->glStencilMask(0xFF);
+  this->gl->glDisable(GL_STENCIL_TEST);
 }
 
 void ShaderRenderer::drawPolygon() {
   Q_ASSERT(shader.isLinked());
   Q_ASSERT(vert.isCompiled() && frag.isCompiled());
 
-  if (this->dataChanged) {
-    this->_vertexOffset = 0;
-    vbo->allocate(this->_vertices.data(),
-                  this->_vertices.size() * sizeof(NumberType));
-    this->dataChanged = false;
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    if (this->_triangulated &&
+        this->_triangulatedResets == this->_store.resets()) {
+      this->_take(this->_triangulatedEdits == this->_store.edits());
+    }
+    this->_triangulated = false;
+  }
+  // ^ Take the pipeline's newest indices, if there are any, and they're for
+  // the polygon as it's been since updateData() last replaced it
+
+  if (this->dataChanged || this->_indicesChanged) {
+    Profiler::Scope scope(this->profiler, Profiler::Upload);
+    if (this->dataChanged) {
+      this->_uploadVertices();
+      this->dataChanged = false;
+    }
+    if (this->_indicesChanged) {
+      this->_uploadIndices();
+    }
   }
 
   if (this->viewChanged) {
     shader.setUniformValue(this->_matrix, this->worldToScreen);
+    shader.setUniformValue(
+        this->_markerScale,
+        2.0f * Constants::MARKER_RADIUS / std::max(this->size.width(), 1),
+        2.0f * Constants::MARKER_RADIUS / std::max(this->size.height(), 1));
+    // ^ From unit circle to clip space
     this->viewChanged = false;
   }
 
@@ -133,4 +660,99 @@ void ShaderRenderer::drawPolygon() {
   }
 
   this->drawLines();
+  if (this->_showMarkers) {
+    this->_drawMarkers();
+  }
+  this->_stream.fence();
+  // ^ Whether or not we wrote to it this frame, the GPU is now reading this
+  // section until it gets this far
+}
+
+/**
+ * Takes what the pipeline published last.  If it's for the polygon as it is
+ * now, the vertex buffer is cut down to just the vertices it uses; otherwise a
+ * vertex is being dragged (or added), the buffer has every one, and only the
+ * indices are any use, renumbered to match it.  Called under the lock.
+ */
+void ShaderRenderer::_take(const bool current) {
+  if (current) {
+    if (this->_compact || !this->_simplified.isEmpty()) {
+      // If the buffer doesn't hold exactly these vertices already...
+      this->_vertices.resize(this->_vertexOffset * 2);
+      this->_vertices.insert(this->_vertices.end(), this->_drawn.begin(),
+                             this->_drawn.end());
+      this->_bufferedVertices = this->_drawn.size() / 2;
+      this->_stream.markDirty(
+          this->_vertexOffset * STRIDE,
+          (this->_vertexOffset + this->_bufferedVertices) * STRIDE);
+      this->dataChanged = true;
+    }
+    this->_compact = true;
+  } else if (this->_compact) {
+    return;
+    // ^ Every edit expands the buffer first, so this is from before that
+  } else if (!this->_simplified.isEmpty()) {
+    for (std::uint32_t &i : this->_triangulation) {
+      i = this->_simplified[i];
+    }
+  }
+
+  this->_indices.swap(this->_triangulation);
+  this->_outline.swap(this->_simplified);
+  this->_indexedVertices = this->_triangulatedVertices;
+  this->_indicesChanged = true;
+}
+
+/**
+ * Sends whatever changed in _vertices to the next section of the VBO, which the
+ * GPU stopped reading a couple of frames ago.  A dragged vertex is one 8-byte
+ * write per section; the sections grow geometrically, so appending usually is
+ * too.
+ */
+void ShaderRenderer::_uploadVertices() {
+  int bytes = this->_vertices.size() * sizeof(NumberType);
+  int capacity = this->_stream.sectionSize();
+
+  if (bytes > capacity || bytes * 4 < capacity) {
+    // If the sections are too small (or way too big), reallocate them all
+    capacity = std::max(bytes, capacity * 2);
+    capacity = std::min(capacity, bytes * 2);
+    this->_stream.resize(capacity);
+  }
+
+  this->_stream.advance();
+  this->_stream.upload(this->_vertices.data(), bytes);
+
+  this->gl->glVertexAttribPointer(
+      this->_position, 2, GL_FLOAT, GL_TRUE, 0,
+      reinterpret_cast<const void *>(
+          static_cast<quintptr>(this->_stream.offset())));
+  // ^ Draw calls count vertices from the start of the section
+}
+
+void ShaderRenderer::_uploadIndices() {
+  static const QVector<std::uint32_t> NONE;
+  const QVector<std::uint32_t> &outline =
+      this->_compact ? NONE : this->_outline;
+  // ^ A cut-down buffer is the outline, in order
+  int vertices =
+      this->_compact ? this->_bufferedVertices : this->_indexedVertices;
+
+  this->_ibo.bind();
+  this->_indexCount = this->_indices.size();
+  this->_outlineCount = outline.size();
+  this->_indicesChanged = false;
+
+  if (this->_vertexOffset + vertices <=
+      std::numeric_limits<GLushort>::max() + 1) {
+    // If every index fits in 16 bits, use half the memory and bandwidth
+    this->_indexType = GL_UNSIGNED_SHORT;
+    allocateIndices(this->_ibo, this->_shortIndices, this->_indices, outline,
+                    this->_vertexOffset);
+  } else {
+    this->_indexType = GL_UNSIGNED_INT;
+    allocateIndices(this->_ibo, this->_longIndices, this->_indices, outline,
+                    this->_vertexOffset);
+  }
+  // ^ The polygon starts after the cover quad
 }
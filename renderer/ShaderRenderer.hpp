@@ -1,16 +1,40 @@
 #ifndef SHADERRENDERER_HPP
 #define SHADERRENDERER_HPP
 
+#include <cstdint>
+#include <mutex>
 #include <vector>
 
+#include <QOpenGLBuffer>
+#include <QPolygonF>
+#include <QRectF>
+#include <QVector>
+
 #include "AbstractRenderer.hpp"
+#include "FrameArena.hpp"
+#include "GeometryPipeline.hpp"
+#include "StreamBuffer.hpp"
+#include "VertexStore.hpp"
+
+#include "geometry/LevelOfDetail.hpp"
 
 class QOpenGLContext;
+class QOpenGLExtraFunctions;
 class QOpenGLFunctions;
 class QOpenGLShader;
 class QOpenGLShaderProgram;
+class Profiler;
 struct ShapelyModel;
 
+/**
+ * Draws the polygon with OpenGL.  Once the pipeline has ranked the vertices,
+ * the vertex buffer only holds the ones that are at least a pixel's worth of
+ * detail at the current scale, so what's uploaded and drawn (outline, fill,
+ * and vertex markers alike) follows what's on screen rather than the polygon's
+ * size.  While a vertex is being dragged or added, the buffer holds every one
+ * instead, so that each edit is a single small write; the pipeline cuts it
+ * down again once it catches up.
+ */
 class ShaderRenderer : public AbstractRenderer {
 public:
   ShaderRenderer(const QString &, const QString &, QOpenGLContext *,
@@ -18,7 +42,12 @@ public:
   virtual ~ShaderRenderer();
   virtual void drawPolygon() override;
   virtual void updateData(const ShapelyModel &) override;
+  virtual void updateVertex(const ShapelyModel &, const int index) override;
   virtual void updateView(const ShapelyModel &) override;
+  virtual void setLogger(QOpenGLDebugLogger *) override;
+  virtual void finish() override;
+  void setMarkersVisible(const bool) noexcept;
+  // ^ Whether to circle every vertex; on by default
 
 protected:
   virtual void drawBackground() override;
@@ -26,14 +55,108 @@ protected:
   virtual void fillPolygon() override;
 
 private:
+  void _updateCover();
+  struct Snapshot {
+    double tolerance;
+    // ^ A pixel, in world units
+    bool simple;
+    // ^ Then so is every level of detail drawn
+    bool triangulate;
+    Profiler *profiler;
+    unsigned resets;
+    unsigned edits;
+    // ^ Of _store, as of the run; filled in by _run()
+  };
+
+  void _updateFill(const ShapelyModel &);
+  void _submit();
+  void _run(const unsigned generation);
+  void _index(const Snapshot &, const unsigned generation);
+  bool _publish(const Snapshot &, const unsigned generation);
+  void _take(const bool current);
+  void _expand(const QPolygonF &);
+  void _drawOutline(const GLenum mode);
+  void _uploadVertices();
+  void _uploadIndices();
+  void _fillStencil();
+  void _drawMarkers();
+
   typedef GLfloat NumberType;
   std::vector<NumberType> _vertices;
+  // ^ The cover quad, the marker circle, then the polygon; mirrors the VBO
+  QVector<std::uint32_t> _indices;
+  // ^ The polygon's latest finished triangulation, if it's simple, numbered
+  // like the vertex buffer; uploaded on the next draw
+  QVector<std::uint32_t> _outline;
+  // ^ The vertices worth drawing at the latest finished level of detail, or
+  // nothing if that's all of them; uploaded after the triangulation, unless
+  // the buffer only holds those anyway
+  int _indexedVertices;
+  // ^ How many vertices the polygon had when those were made, or -1 if they're
+  // for another polygon; they aren't drawn while that's out of date
+  QOpenGLBuffer _ibo;
+  GLenum _indexType;
+  int _indexCount;
+  int _outlineCount;
+  bool _indicesChanged;
+  std::vector<GLushort> _shortIndices;
+  std::vector<GLuint> _longIndices;
+  // ^ Where they're staged for uploading, whichever size they fit
+  double _tolerance;
+  // ^ What the pipeline was last given
+
+  StreamBuffer _stream;
+  // ^ Triple-buffers the VBO, and remembers which vertices each copy is
+  // missing
+  QRectF _bounds;
 
   int _vertexOffset;
+  int _vertexCount;
+  // ^ Where the polygon starts in the VBO (after the cover quad and marker),
+  // and how many vertices it has
+  int _bufferedVertices;
+  bool _compact;
+  // ^ How many of them are in the VBO, and whether that's just _outline's (or
+  // every one, in order, if it's empty); if not, it's every one, edited in
+  // place
+  bool _isSimple;
   int _markerOffset;
+  bool _showMarkers;
+  QOpenGLExtraFunctions *_extra;
+  // ^ For instancing
   int _position;
+  int _offset;
   int _matrix;
   int _color;
+  int _markerScale;
+
+  LevelOfDetail _lod;
+  std::vector<int> _kept;
+  QVector<std::uint32_t> _nextTriangles;
+  QVector<std::uint32_t> _nextOutline;
+  std::vector<NumberType> _nextPoints;
+  QPolygonF _simplifiedPolygon;
+  FrameArena _scratch;
+  // ^ Only touched by the pipeline's thread
+
+  std::mutex _lock;
+  VertexStore _store;
+  // ^ Edited on the GUI thread, synced on the pipeline's
+  Snapshot _next;
+  // ^ What the pipeline's next run will work with
+  QVector<std::uint32_t> _triangulation;
+  QVector<std::uint32_t> _simplified;
+  std::vector<NumberType> _drawn;
+  // ^ The vertices those use, or nothing if they're already out of date
+  int _triangulatedVertices;
+  unsigned _triangulatedResets;
+  unsigned _triangulatedEdits;
+  bool _triangulated;
+  // ^ What the pipeline finished last (for how many vertices, and as of which
+  // of _store's resets and edits), and whether it's newer than _indices and
+  // _outline
+  GeometryPipeline _pipeline;
+  // ^ Last, so it stops before anything its jobs use is destroyed
 };
 
 #endif // SHADERRENDERER_HPP
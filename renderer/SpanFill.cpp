@@ -0,0 +1,126 @@
+#include "SpanFill.hpp"
+
+#ifdef JTG_HAS_X86_SPAN_FILL
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define JTG_TARGET(isa) __attribute__((target(isa)))
+#else
+#define JTG_TARGET(isa)
+// ^ MSVC lets you use any intrinsic without enabling it first
+#endif
+
+namespace jtg {
+
+void fillSpanScalar(uint32_t *dst, int count, uint32_t color) noexcept {
+  for (int i = 0; i < count; ++i) {
+    dst[i] = color;
+  }
+}
+
+#ifdef JTG_HAS_X86_SPAN_FILL
+JTG_TARGET("sse2")
+void fillSpanSSE2(uint32_t *dst, int count, uint32_t color) noexcept {
+  int i = 0;
+  for (; i < count && (reinterpret_cast<std::uintptr_t>(dst + i) & 15); ++i) {
+    dst[i] = color;
+  }
+  // Framebuffer rows are only 4-byte aligned, so walk up to a 16-byte boundary
+
+  __m128i c = _mm_set1_epi32(color);
+  for (; i + 16 <= count; i += 16) {
+    __m128i *p = reinterpret_cast<__m128i *>(dst + i);
+    _mm_store_si128(p, c);
+    _mm_store_si128(p + 1, c);
+    _mm_store_si128(p + 2, c);
+    _mm_store_si128(p + 3, c);
+  }
+
+  for (; i + 4 <= count; i += 4) {
+    _mm_store_si128(reinterpret_cast<__m128i *>(dst + i), c);
+  }
+
+  for (; i < count; ++i) {
+    dst[i] = color;
+  }
+}
+
+JTG_TARGET("avx2")
+void fillSpanAVX2(uint32_t *dst, int count, uint32_t color) noexcept {
+  int i = 0;
+  for (; i < count && (reinterpret_cast<std::uintptr_t>(dst + i) & 31); ++i) {
+    dst[i] = color;
+  }
+
+  __m256i c = _mm256_set1_epi32(color);
+  for (; i + 32 <= count; i += 32) {
+    __m256i *p = reinterpret_cast<__m256i *>(dst + i);
+    _mm256_store_si256(p, c);
+    _mm256_store_si256(p + 1, c);
+    _mm256_store_si256(p + 2, c);
+    _mm256_store_si256(p + 3, c);
+  }
+
+  for (; i + 8 <= count; i += 8) {
+    _mm256_store_si256(reinterpret_cast<__m256i *>(dst + i), c);
+  }
+
+  for (; i < count; ++i) {
+    dst[i] = color;
+  }
+}
+#endif
+
+bool hasSSE2() noexcept {
+#if defined(__x86_64__) || defined(_M_X64)
+  return true;
+  // ^ Part of the x86-64 baseline
+#elif defined(JTG_HAS_X86_SPAN_FILL) && (defined(__GNUC__) || defined(__clang__))
+  return __builtin_cpu_supports("sse2");
+#elif defined(JTG_HAS_X86_SPAN_FILL) && defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  return info[3] & (1 << 26);
+#else
+  return false;
+#endif
+}
+
+bool hasAVX2() noexcept {
+#if defined(JTG_HAS_X86_SPAN_FILL) && (defined(__GNUC__) || defined(__clang__))
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#elif defined(JTG_HAS_X86_SPAN_FILL) && defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return false;
+
+  __cpuid(info, 1);
+  bool osxsave = info[2] & (1 << 27);
+  bool avx = info[2] & (1 << 28);
+  if (!(osxsave && avx && (_xgetbv(0) & 6) == 6))
+    return false;
+  // ^ The OS also has to save the YMM registers on a context switch
+
+  __cpuidex(info, 7, 0);
+  return info[1] & (1 << 5);
+#else
+  return false;
+#endif
+}
+
+SpanFiller bestSpanFiller() noexcept {
+#ifdef JTG_HAS_X86_SPAN_FILL
+  if (hasAVX2())
+    return fillSpanAVX2;
+  if (hasSSE2())
+    return fillSpanSSE2;
+#endif
+  return fillSpanScalar;
+}
+}
@@ -0,0 +1,41 @@
+#ifndef SPANFILL_HPP
+#define SPANFILL_HPP
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||          \
+    defined(_M_IX86)
+#define JTG_HAS_X86_SPAN_FILL
+#endif
+
+namespace jtg {
+using std::uint32_t;
+
+typedef void (*SpanFiller)(uint32_t *dst, int count, uint32_t color);
+
+/**
+ * Span writers; each one sets dst[0], dst[1], ..., dst[count - 1] to color.
+ * The vectorized ones are only compiled in on x86, and must only be called if
+ * the CPU supports them (see hasSSE2() and hasAVX2()).
+ */
+void fillSpanScalar(uint32_t *dst, int count, uint32_t color) noexcept;
+#ifdef JTG_HAS_X86_SPAN_FILL
+void fillSpanSSE2(uint32_t *dst, int count, uint32_t color) noexcept;
+void fillSpanAVX2(uint32_t *dst, int count, uint32_t color) noexcept;
+#endif
+
+bool hasSSE2() noexcept;
+bool hasAVX2() noexcept;
+
+/**
+ * @return The fastest span writer this CPU supports; decided once, on first use
+ */
+SpanFiller bestSpanFiller() noexcept;
+
+inline void fillSpan(uint32_t *dst, int count, uint32_t color) noexcept {
+  static const SpanFiller filler = bestSpanFiller();
+  filler(dst, count, color);
+}
+}
+
+#endif // SPANFILL_HPP
@@ -0,0 +1,187 @@
+#include "StreamBuffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include <QElapsedTimer>
+#include <QOpenGLBuffer>
+#include <QOpenGLContext>
+#include <QOpenGLDebugLogger>
+#include <QString>
+
+constexpr GLuint64 STALL_TIMEOUT = 1000000000;
+// ^ In nanoseconds; after this long we give up on the fence and write anyway
+constexpr int MAX_DIRTY_RANGES = 8;
+// ^ Past this many, just merge them all into one
+
+StreamBuffer::StreamBuffer(QOpenGLContext *context, QOpenGLBuffer *buffer,
+                           const char *name)
+    : _gl(context->extraFunctions()), _buffer(buffer), _logger(nullptr),
+      _name(name), _current(0), _sectionSize(0) {
+  switch (buffer->type()) {
+  case QOpenGLBuffer::VertexBuffer:
+    this->_target = GL_ARRAY_BUFFER;
+    break;
+  case QOpenGLBuffer::IndexBuffer:
+    this->_target = GL_ELEMENT_ARRAY_BUFFER;
+    break;
+  case QOpenGLBuffer::PixelPackBuffer:
+    this->_target = GL_PIXEL_PACK_BUFFER;
+    break;
+  case QOpenGLBuffer::PixelUnpackBuffer:
+    this->_target = GL_PIXEL_UNPACK_BUFFER;
+    break;
+  }
+
+  for (Section &section : this->_sections) {
+    section.fence = nullptr;
+  }
+
+  buffer->setUsagePattern(QOpenGLBuffer::StreamDraw);
+}
+
+StreamBuffer::~StreamBuffer() {
+  for (Section &section : this->_sections) {
+    if (section.fence) {
+      this->_gl->glDeleteSync(section.fence);
+    }
+  }
+}
+
+void StreamBuffer::setLogger(QOpenGLDebugLogger *logger) noexcept {
+  this->_logger = logger;
+}
+
+void StreamBuffer::resize(const int bytes) {
+  this->_sectionSize = bytes;
+  this->_buffer->bind();
+  this->_buffer->allocate(bytes * SECTIONS);
+  // ^ glBufferData gives us fresh storage; the GPU can keep reading the old
+  // storage until it's done, so none of the fences matter any more
+
+  for (Section &section : this->_sections) {
+    if (section.fence) {
+      this->_gl->glDeleteSync(section.fence);
+      section.fence = nullptr;
+    }
+    section.dirty.assign(1, Range{0, bytes});
+  }
+}
+
+void StreamBuffer::markDirty(const int begin, int end) {
+  Q_ASSERT(0 <= begin);
+  end = std::min(end, this->_sectionSize);
+  if (begin >= end)
+    return;
+
+  for (Section &section : this->_sections) {
+    std::vector<Range> &dirty = section.dirty;
+    Range added{begin, end};
+
+    auto overlaps = [&added](const Range &r) {
+      return r.begin <= added.end && added.begin <= r.end;
+    };
+    // ^ Touching ranges count, too
+
+    for (const Range &r : dirty) {
+      if (overlaps(r)) {
+        added.begin = std::min(added.begin, r.begin);
+        added.end = std::max(added.end, r.end);
+      }
+    }
+    dirty.erase(std::remove_if(dirty.begin(), dirty.end(), overlaps),
+                dirty.end());
+    dirty.push_back(added);
+
+    if (dirty.size() > MAX_DIRTY_RANGES) {
+      Range all{std::numeric_limits<int>::max(), 0};
+      for (const Range &r : dirty) {
+        all.begin = std::min(all.begin, r.begin);
+        all.end = std::max(all.end, r.end);
+      }
+      dirty.assign(1, all);
+    }
+  }
+}
+
+void StreamBuffer::advance() {
+  this->_current = (this->_current + 1) % SECTIONS;
+  this->_buffer->bind();
+  this->_wait(this->_sections[this->_current]);
+}
+
+void StreamBuffer::upload(const void *data, const int bytes) {
+  std::vector<Range> &dirty = this->_sections[this->_current].dirty;
+
+  for (const Range &r : dirty) {
+    int end = std::min(r.end, bytes);
+    if (r.begin >= end)
+      continue;
+    // ^ Nothing there yet; it'll be marked again once there is
+
+    void *section = this->map(r.begin, end - r.begin);
+    if (section) {
+      std::memcpy(section, static_cast<const char *>(data) + r.begin,
+                  end - r.begin);
+      this->unmap();
+    }
+  }
+
+  dirty.clear();
+}
+
+void *StreamBuffer::map(const int offset, const int bytes) {
+  Q_ASSERT(0 <= offset && offset + bytes <= this->_sectionSize);
+
+  return this->_gl->glMapBufferRange(
+      this->_target, this->offset() + offset, bytes,
+      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+          GL_MAP_UNSYNCHRONIZED_BIT);
+  // ^ Unsynchronized, since the fence already told us nobody's reading this
+  // section; otherwise the driver would wait for every draw using the buffer
+}
+
+void StreamBuffer::unmap() { this->_gl->glUnmapBuffer(this->_target); }
+
+void StreamBuffer::fence() {
+  Section &section = this->_sections[this->_current];
+  if (section.fence) {
+    this->_gl->glDeleteSync(section.fence);
+  }
+
+  section.fence = this->_gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamBuffer::_wait(Section &section) {
+  if (!section.fence)
+    return;
+
+  GLenum status = this->_gl->glClientWaitSync(section.fence, 0, 0);
+  if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+    // If the GPU's already done with this section, which is the usual case...
+    this->_gl->glDeleteSync(section.fence);
+    section.fence = nullptr;
+    return;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  status = this->_gl->glClientWaitSync(
+      section.fence, GL_SYNC_FLUSH_COMMANDS_BIT, STALL_TIMEOUT);
+  qint64 elapsed = timer.nsecsElapsed();
+
+  this->_gl->glDeleteSync(section.fence);
+  section.fence = nullptr;
+
+  if (this->_logger && this->_logger->isLogging()) {
+    this->_logger->logMessage(QOpenGLDebugMessage::createApplicationMessage(
+        QString("%1 stream stalled for %2 us waiting on section %3%4")
+            .arg(this->_name)
+            .arg(elapsed / 1000)
+            .arg(this->_current)
+            .arg(status == GL_TIMEOUT_EXPIRED ? " (timed out)" : ""),
+        0, QOpenGLDebugMessage::PerformanceType,
+        QOpenGLDebugMessage::LowSeverity));
+  }
+}
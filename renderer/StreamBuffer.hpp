@@ -0,0 +1,96 @@
+#ifndef STREAMBUFFER_HPP
+#define STREAMBUFFER_HPP
+
+#include <vector>
+
+#include <QOpenGLExtraFunctions>
+
+class QOpenGLBuffer;
+class QOpenGLContext;
+class QOpenGLDebugLogger;
+
+/**
+ * Streams data that changes every frame through a buffer object without
+ * waiting on the GPU.
+ *
+ * The buffer is split into SECTIONS equal sections, used round-robin; each
+ * frame writes to the next one with glMapBufferRange(), unsynchronized, while
+ * the GPU may still be reading the ones before it.  A fence after each frame's
+ * draws says when its section is safe to write again, and we only ever wait on
+ * it if the GPU falls SECTIONS frames behind.  Those waits are stalls, and get
+ * logged to the QOpenGLDebugLogger if there is one.
+ *
+ * Each section remembers which byte ranges changed since it was last written,
+ * so data that's mostly the same from frame to frame (e.g. a polygon with one
+ * vertex being dragged) only needs the changed parts copied in.
+ */
+class StreamBuffer {
+public:
+  static constexpr int SECTIONS = 3;
+
+  StreamBuffer(QOpenGLContext *context, QOpenGLBuffer *buffer,
+               const char *name);
+  ~StreamBuffer();
+
+  StreamBuffer(const StreamBuffer &) = delete;
+  StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+  void setLogger(QOpenGLDebugLogger *logger) noexcept;
+
+  /**
+   * Reallocates (orphans) the buffer so each section holds at least bytes,
+   * and marks everything dirty.  Never waits on the GPU.
+   */
+  void resize(const int bytes);
+  int sectionSize() const noexcept { return this->_sectionSize; }
+
+  void markDirty(const int begin, const int end);
+  // ^ In bytes from the start of a section; applies to every section.  Bytes
+  // past the end of a section are ignored, since resize() marks them anyway
+
+  /**
+   * Moves on to the next section, waiting for the GPU to finish with it first
+   * if need be.  Binds the buffer.
+   */
+  void advance();
+
+  /**
+   * Copies every range that changed since the current section was last
+   * written from data (laid out like a section, and bytes long) into it.
+   */
+  void upload(const void *data, const int bytes);
+
+  void *map(const int offset, const int bytes);
+  // ^ Within the current section; the old contents of that range are gone
+  void unmap();
+
+  void fence();
+  // ^ Call after the draws that read the current section
+
+  int offset() const noexcept { return this->_current * this->_sectionSize; }
+  // ^ Of the current section, in bytes from the start of the buffer
+
+private:
+  struct Range {
+    int begin;
+    int end;
+  };
+
+  struct Section {
+    GLsync fence;
+    std::vector<Range> dirty;
+  };
+
+  void _wait(Section &section);
+
+  QOpenGLExtraFunctions *_gl;
+  QOpenGLBuffer *_buffer;
+  QOpenGLDebugLogger *_logger;
+  const char *_name;
+  GLenum _target;
+  Section _sections[SECTIONS];
+  int _current;
+  int _sectionSize;
+};
+
+#endif // STREAMBUFFER_HPP
@@ -0,0 +1,61 @@
+#include "VertexStore.hpp"
+
+#include <algorithm>
+
+VertexStore::VertexStore() noexcept
+    : _replaced(false), _size(0), _resets(0), _edits(0), _revision(0) {}
+
+void VertexStore::reset(const QPolygonF &polygon) {
+  this->_replacement.resize(polygon.size());
+  std::copy(polygon.constBegin(), polygon.constEnd(),
+            this->_replacement.begin());
+  // ^ Copied, not assigned, so that it doesn't share the model's data
+
+  this->_replaced = true;
+  this->_deltas.clear();
+  this->_size = polygon.size();
+  ++this->_resets;
+  ++this->_edits;
+}
+
+void VertexStore::moveVertex(const int index, const QPointF &point) {
+  Q_ASSERT(0 <= index && index < this->_size);
+  ++this->_edits;
+
+  if (!this->_deltas.empty() && this->_deltas.back().index == index) {
+    this->_deltas.back().point = point;
+    return;
+  }
+  // ^ The same vertex again (while dragging, it always is), or the one that
+  // was just appended; either way, only where it ends up matters
+
+  this->_deltas.push_back({index, point});
+}
+
+void VertexStore::appendVertex(const QPointF &point) {
+  ++this->_edits;
+  this->_deltas.push_back({this->_size++, point});
+}
+
+bool VertexStore::sync() {
+  if (!this->_replaced && this->_deltas.empty())
+    return false;
+
+  if (this->_replaced) {
+    this->_polygon.swap(this->_replacement);
+    this->_replaced = false;
+  }
+  // ^ The old copy becomes the next replacement, so reset() reuses its memory
+
+  for (const Delta &delta : this->_deltas) {
+    if (delta.index == this->_polygon.size()) {
+      this->_polygon.append(delta.point);
+    } else {
+      this->_polygon[delta.index] = delta.point;
+    }
+  }
+  this->_deltas.clear();
+
+  ++this->_revision;
+  return true;
+}
@@ -0,0 +1,69 @@
+#ifndef VERTEXSTORE_HPP
+#define VERTEXSTORE_HPP
+
+#include <vector>
+
+#include <QPointF>
+#include <QPolygonF>
+
+/**
+ * A renderer's pipeline's own copy of the polygon.  Handing the pipeline the
+ * model's (implicitly shared) QPolygonF would be cheaper up front, but then the
+ * model's next edit would have to copy every vertex on the GUI thread, and
+ * while dragging, every edit is the next one.  So the GUI thread only passes
+ * along what changed, and the pipeline applies that to its copy before each
+ * job: dragging a vertex costs the same whatever the polygon's size.
+ *
+ * Replacing the whole polygon (e.g. after a vertex was inserted or removed) is
+ * copied into a second buffer, which the pipeline swaps for its own.  Neither
+ * is ever shared, so once they're big enough, nothing here allocates.
+ *
+ * Not thread-safe by itself; the renderer calls both sides under one lock.
+ */
+class VertexStore {
+public:
+  VertexStore() noexcept;
+
+  // The GUI thread's side /////////////////////////////////////////////////////
+  void reset(const QPolygonF &);
+  void moveVertex(const int index, const QPointF &);
+  void appendVertex(const QPointF &);
+  int size() const noexcept { return this->_size; }
+  // ^ As of the latest edit, whether or not the pipeline has seen it yet
+  unsigned resets() const noexcept { return this->_resets; }
+  // ^ How many times reset() was called; the pipeline's results for the
+  // polygon are only any use while this is what it was when they were started
+  unsigned edits() const noexcept { return this->_edits; }
+  // ^ How many changes of any kind it's been given; results started at this
+  // count are for the polygon exactly as it is
+  //////////////////////////////////////////////////////////////////////////////
+
+  // The pipeline's side ///////////////////////////////////////////////////////
+  bool sync();
+  // ^ Brings polygon() up to date; false if nothing changed since last time
+  const QPolygonF &polygon() const noexcept { return this->_polygon; }
+  // ^ Don't copy it; the copy would share it, and sync() would then detach
+  unsigned revision() const noexcept { return this->_revision; }
+  // ^ Bumped whenever sync() changes polygon()
+  //////////////////////////////////////////////////////////////////////////////
+
+private:
+  struct Delta {
+    int index;
+    // ^ Appends the point if it's one past the end
+    QPointF point;
+  };
+
+  QPolygonF _polygon;
+  // ^ The pipeline's
+  QPolygonF _replacement;
+  bool _replaced;
+  // ^ Whether sync() should swap _replacement in before applying _deltas
+  std::vector<Delta> _deltas;
+  int _size;
+  unsigned _resets;
+  unsigned _edits;
+  unsigned _revision;
+};
+
+#endif // VERTEXSTORE_HPP
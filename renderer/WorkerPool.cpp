@@ -0,0 +1,141 @@
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(const int threads)
+    : _queues(new Queue[std::max(threads, 1)]), _task(nullptr),
+      _generation(0), _busy(0), _quit(false) {
+  for (int i = 0; i < std::max(threads, 1); ++i) {
+    this->_queues[i].begin = 0;
+    this->_queues[i].end = 0;
+  }
+
+  for (int i = 1; i < threads; ++i) {
+    this->_threads.emplace_back(&WorkerPool::_loop, this, i);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    this->_quit = true;
+  }
+  this->_wake.notify_all();
+
+  for (std::thread &t : this->_threads) {
+    t.join();
+  }
+}
+
+void WorkerPool::run(const int tasks, const std::function<void(int)> &task) {
+  this->run(tasks, [&task](const int i, int) { task(i); });
+}
+
+void WorkerPool::run(const int tasks,
+                     const std::function<void(int, int)> &task) {
+  if (tasks <= 0)
+    return;
+
+  int n = this->threadCount();
+  if (n == 1) {
+    for (int i = 0; i < tasks; ++i) {
+      task(i, 0);
+    }
+    return;
+  }
+
+  for (int i = 0; i < n; ++i) {
+    std::lock_guard<std::mutex> guard(this->_queues[i].lock);
+    this->_queues[i].begin = static_cast<long long>(tasks) * i / n;
+    this->_queues[i].end = static_cast<long long>(tasks) * (i + 1) / n;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(this->_lock);
+    this->_task = &task;
+    this->_busy = this->_threads.size();
+    ++this->_generation;
+  }
+  this->_wake.notify_all();
+
+  this->_work(0);
+
+  std::unique_lock<std::mutex> lock(this->_lock);
+  this->_done.wait(lock, [this]() { return this->_busy == 0; });
+  this->_task = nullptr;
+  // Every worker has checked in, so nobody's still looking at task
+}
+
+void WorkerPool::_loop(const int self) {
+  unsigned seen = 0;
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(this->_lock);
+      this->_wake.wait(lock, [this, seen]() {
+        return this->_quit || this->_generation != seen;
+      });
+
+      if (this->_quit)
+        return;
+
+      seen = this->_generation;
+    }
+
+    this->_work(self);
+
+    std::lock_guard<std::mutex> guard(this->_lock);
+    if (--this->_busy == 0) {
+      this->_done.notify_one();
+    }
+  }
+}
+
+void WorkerPool::_work(const int self) {
+  int task;
+  while (this->_take(self, task) || this->_steal(self, task)) {
+    (*this->_task)(task, self);
+  }
+}
+
+bool WorkerPool::_take(const int self, int &task) {
+  Queue &q = this->_queues[self];
+  std::lock_guard<std::mutex> guard(q.lock);
+
+  if (q.begin < q.end) {
+    task = q.begin++;
+    return true;
+  }
+
+  return false;
+}
+
+bool WorkerPool::_steal(const int self, int &task) {
+  int n = this->threadCount();
+
+  for (int i = 1; i < n; ++i) {
+    Queue &victim = this->_queues[(self + i) % n];
+    int begin, end;
+    {
+      std::lock_guard<std::mutex> guard(victim.lock);
+      int left = victim.end - victim.begin;
+      if (left <= 0)
+        continue;
+
+      end = victim.end;
+      begin = end - (left + 1) / 2;
+      victim.end = begin;
+      // Take the back half; the owner is working from the front
+    }
+
+    task = begin;
+
+    Queue &mine = this->_queues[self];
+    std::lock_guard<std::mutex> guard(mine.lock);
+    mine.begin = begin + 1;
+    mine.end = end;
+    return true;
+  }
+
+  return false;
+}
@@ -0,0 +1,70 @@
+#ifndef WORKERPOOL_HPP
+#define WORKERPOOL_HPP
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of threads that runs batches of numbered tasks, for splitting
+ * rasterization into bands.
+ *
+ * Each participant (the worker threads, plus the thread that calls run()) gets
+ * a contiguous range of task numbers.  It takes tasks from the front of its own
+ * range, and when that runs dry it steals the back half of someone else's.
+ * Bands on a spiky polygon can differ in cost by orders of magnitude, so a
+ * static split would leave most threads idle.
+ */
+class WorkerPool {
+public:
+  explicit WorkerPool(const int threads);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  int threadCount() const noexcept { return this->_threads.size() + 1; }
+  // ^ Including the caller of run()
+
+  /**
+   * Calls task(0), task(1), ..., task(tasks - 1) across the pool and returns
+   * once they've all finished.  The calling thread works, too.
+   */
+  void run(const int tasks, const std::function<void(int)> &task);
+
+  /**
+   * Like run(), but also passes each task the participant running it, in
+   * [0, threadCount()); no two tasks run at once with the same one, so it can
+   * pick out per-thread scratch space.
+   */
+  void run(const int tasks, const std::function<void(int, int)> &task);
+
+private:
+  struct Queue {
+    std::mutex lock;
+    int begin;
+    int end;
+  };
+
+  void _loop(const int self);
+  void _work(const int self);
+  bool _take(const int self, int &task);
+  bool _steal(const int self, int &task);
+
+  std::vector<std::thread> _threads;
+  std::unique_ptr<Queue[]> _queues;
+  // ^ One per participant; the caller of run() is participant 0
+
+  std::mutex _lock;
+  std::condition_variable _wake;
+  std::condition_variable _done;
+  const std::function<void(int, int)> *_task;
+  unsigned _generation;
+  int _busy;
+  bool _quit;
+};
+
+#endif // WORKERPOOL_HPP
@@ -0,0 +1,9 @@
+#version 130
+uniform sampler2D framebuffer;
+
+varying vec2 texCoord;
+
+void main(void)
+{
+    gl_FragColor = texture2D(framebuffer, texCoord);
+}
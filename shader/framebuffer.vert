@@ -0,0 +1,10 @@
+#version 130
+attribute vec2 position;
+
+varying vec2 texCoord;
+
+void main(void)
+{
+    texCoord = position * 0.5 + 0.5;
+    gl_Position = vec4(position, 0.0, 1.0);
+}
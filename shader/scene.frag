@@ -0,0 +1,7 @@
+#version 140
+uniform vec4 color;
+
+void main(void)
+{
+    gl_FragColor = color;
+}
@@ -0,0 +1,15 @@
+#version 140
+uniform samplerBuffer transforms;
+
+in vec2 position;
+in int model;
+
+void main(void)
+{
+    int column = model * 4;
+    mat4 matrix = mat4(texelFetch(transforms, column),
+                       texelFetch(transforms, column + 1),
+                       texelFetch(transforms, column + 2),
+                       texelFetch(transforms, column + 3));
+    gl_Position = matrix * vec4(position, 0.0, 1.0f);
+}
@@ -1,10 +1,14 @@
 #version 130
 uniform mat4 matrix;
 uniform vec4 color;
+uniform vec2 markerScale;
 
 attribute vec2 position;
+attribute vec2 offset;
+// ^ In marker radii; (0, 0) for everything but the markers
 
 void main(void)
 {
     gl_Position = matrix * vec4(position, 0.0, 1.0f);
+    gl_Position.xy += offset * markerScale * gl_Position.w;
 }
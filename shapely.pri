@@ -0,0 +1,10 @@
+# Settings shared by every subproject
+
+QT       += core gui
+
+CONFIG += c++11 warn_on thread
+CONFIG(debug, debug|release): DEFINES += DEBUG
+CONFIG(release, debug|release): QMAKE_CXXFLAGS += -Ofast
+CONFIG(release, debug|release): DEFINES += NDEBUG
+
+INCLUDEPATH += $$PWD